@@ -1,12 +1,75 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
 #include "scheme/scheme.h"
+#include "scheme/server.h"
 
-int main() {
+namespace {
+
+// Results of script mode, written to stdout in large chunks instead of one flush per line.
+class Output {
+public:
+    static constexpr size_t kFlushSize = 1 << 16;
+
+    Output() = default;
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+    ~Output() {
+        Flush();
+    }
+
+    void WriteLine(std::string_view line) {
+        buffer_ += line;
+        buffer_ += '\n';
+        if (buffer_.size() >= kFlushSize) {
+            Flush();
+        }
+    }
+    void Flush() {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+        std::fflush(stdout);
+        buffer_.clear();
+    }
+
+private:
+    std::string buffer_;
+};
+
+// Reads every datum of input, which may span lines, and prints its value; errors go to stderr
+// as name:line:column: message. Exits with 1 once a datum can not be read.
+int RunScript(std::istream* input, const std::string& name) {
+    Interpreter interpreter;
+    Output output;
+    bool broken = false;
+    interpreter.RunStream(input, [&](const BatchResult& result) {
+        if (result.status == BatchResult::Status::OK) {
+            output.WriteLine(result.value);
+            interpreter.RunPending();
+            return;
+        }
+        // Keeps errors in order with the results before them.
+        output.Flush();
+        std::cerr << name << ':' << result.position.line << ':' << result.position.column << ": "
+                  << result.value << '\n';
+        broken = broken || result.status == BatchResult::Status::SYNTAX_ERROR;
+    });
+    return broken ? 1 : 0;
+}
+
+// Evaluates each line on its own, printing results as soon as they are known.
+int RunInteractive() {
     std::string line;
     Interpreter interpreter;
     while (getline(std::cin, line)) {
         try {
             std::cout << interpreter.Run(line) << std::endl;
+            interpreter.RunPending();
         } catch (RuntimeError& e) {
             std::cerr << e.what() << std::endl;
         } catch (NameError& e) {
@@ -16,4 +79,84 @@ int main() {
         }
     }
     return 0;
-}
\ No newline at end of file
+}
+
+// Serves requests on the socket until SIGINT or SIGTERM.
+int RunServer(const char* socket, ServerOptions options) {
+    // Blocked before the server starts its threads, so that only sigwait sees them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    try {
+        Server server(std::move(options));
+        server.Listen(socket);
+        int signal;
+        sigwait(&signals, &signal);
+        std::cerr << server.GetStats();
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+bool ReadFile(const char* path, std::string* contents) {
+    std::ifstream input(path);
+    std::stringstream ss;
+    ss << input.rdbuf();
+    *contents = ss.str();
+    return static_cast<bool>(input);
+}
+
+}  // namespace
+
+// repl                          line by line, for interactive use
+// repl --script                 script mode on stdin
+// repl [--script] FILE          script mode on FILE
+// repl --serve SOCKET [--prelude FILE] [--workers N]
+//                               evaluator daemon on a Unix socket (see server.h)
+int main(int argc, char** argv) {
+    bool script = false;
+    const char* path = nullptr;
+    const char* socket = nullptr;
+    ServerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--script") == 0) {
+            script = true;
+        } else if (std::strcmp(argv[i], "--serve") == 0 && has_value) {
+            socket = argv[++i];
+        } else if (std::strcmp(argv[i], "--prelude") == 0 && has_value) {
+            if (!ReadFile(argv[++i], &options.prelude)) {
+                std::cerr << "Can not read " << argv[i] << std::endl;
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--workers") == 0 && has_value) {
+            options.workers = std::strtoul(argv[++i], nullptr, 10);
+        } else if (path == nullptr && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--script] [FILE]\n       " << argv[0]
+                      << " --serve SOCKET [--prelude FILE] [--workers N]" << std::endl;
+            return 2;
+        }
+    }
+    if (socket != nullptr) {
+        return RunServer(socket, std::move(options));
+    }
+    if (path != nullptr) {
+        std::ifstream input(path);
+        if (!input) {
+            std::cerr << "Can not open " << path << std::endl;
+            return 2;
+        }
+        return RunScript(&input, path);
+    }
+    if (script) {
+        std::ios::sync_with_stdio(false);
+        return RunScript(&std::cin, "<stdin>");
+    }
+    return RunInteractive();
+}
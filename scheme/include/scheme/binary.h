@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "object.h"
+
+// Compact binary encoding of data (numbers, booleans, symbols, strings and lists of data), much
+// cheaper to write and read than printing and parsing text:
+//
+//   datum := NIL | TRUE | FALSE | FIXNUM zigzag-varint
+//          | SYMBOL varint-length bytes | SYMBOL_REF varint-index
+//          | LIST varint-count datum... datum | STRING varint-length bytes
+//
+// after a header of kBinaryMagic and kBinaryVersion. A symbol is written once; later
+// occurrences refer to it by the order of first appearance, and are read as the same object.
+// A run of pairs is written as one LIST with its elements followed by its tail, () for a proper
+// list, so a list costs one byte plus its elements whatever its length.
+constexpr std::string_view kBinaryMagic = "SCB";
+constexpr char kBinaryVersion = 1;
+
+enum class BinaryTag : char { NIL, TRUE, FALSE, FIXNUM, SYMBOL, SYMBOL_REF, LIST, STRING };
+
+// Reads the varint at *pos in data and moves *pos past it. Throws SyntaxError if data ends first.
+uint64_t ReadVarint(std::string_view data, size_t* pos);
+
+// Returns the fixnum encoded as value. Throws SyntaxError if it is out of range.
+int DecodeFixnum(uint64_t value);
+
+// Appends the encoding of datum to out. Throws RuntimeError if datum holds anything but data.
+void WriteBinary(const Ptr<Object>& datum, std::string* out);
+
+// Decodes data, which holds exactly one encoded datum. Reads data in place, so it may be a
+// MappedFile. Throws SyntaxError if data is not a valid encoding.
+Ptr<Object> ReadBinary(std::string_view data);
+
+// Encoded data as a value of the language.
+class Bytes : public Object {
+public:
+    explicit Bytes(std::string data) : data_(std::move(data)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Bytes";
+    }
+    const std::string& GetData() const {
+        return data_;
+    }
+    ~Bytes() override = default;
+
+private:
+    std::string data_;
+};
+
+// A file mapped read-only into memory for as long as the object lives.
+class MappedFile {
+public:
+    // Throws RuntimeError if the file can not be opened.
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::string_view GetData() const {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Binds write-binary, which encodes a datum into Bytes, and read-binary, which decodes them.
+void InstallBinary(Environemnt* env);
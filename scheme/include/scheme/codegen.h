@@ -0,0 +1,22 @@
+#pragma once
+
+#include <istream>
+#include <string>
+
+// Translation of a Scheme program into a C++ program linked against the scheme library, which
+// prints what the REPL prints when fed the same forms. Used by schemec.
+//
+// Lambdas, let, if, define, set!, and, or and quote become C++ code. Calls to builtins the
+// program never rebinds are direct, and +, -, *, comparisons, car and cdr on fixnums and pairs
+// are done natively. A procedure calling itself in tail position loops instead, and other calls
+// in tail position do not grow the stack either. A top-level form using anything else (variadic
+// lambdas, spawn, a define nested in an expression...) is kept as source and run by the
+// interpreter embedded in the program.
+struct Translation {
+    std::string code;
+    size_t translated = 0;
+    size_t interpreted = 0;
+};
+
+// Reads every form of source; name is only mentioned in the output.
+Translation TranslateToCpp(std::istream* source, const std::string& name);
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "object.h"
+#include "scheme.h"
+
+// Runtime support for C++ translated from Scheme by schemec (see codegen.h). A translated
+// program keeps a regular interpreter around: its global scope holds the builtins and every
+// global the program defines, and top-level forms schemec could not translate run in it.
+namespace compiled {
+
+struct Form {
+    // A translated top-level form, or nullptr if the form is interpreted from source.
+    Ptr<Object> (*function)();
+    const char* source;
+};
+
+class Program {
+public:
+    Program() = default;
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    // Runs forms in order, printing results and errors the way the REPL does.
+    int Main(const std::vector<Form>& forms);
+
+    const Ptr<Environemnt>& GetGlobalScope() {
+        return interpreter_.GetGlobalScope();
+    }
+    // Reads datum, the source of a literal.
+    Ptr<Object> Datum(const std::string& datum);
+    // The builtin FullfillR5RS bound to name.
+    Callable* Builtin(const std::string& name);
+    void Define(const std::string& name, Ptr<Object> value) {
+        GetGlobalScope()->Define(name, std::move(value));
+    }
+
+private:
+    Interpreter interpreter_;
+};
+
+// A global variable, looked up on first use.
+class Global {
+public:
+    Global(Program* program, std::string name) : program_(program), name_(std::move(name)) {
+    }
+    const Ptr<Object>& Get() {
+        return Resolve()->value;
+    }
+    Ptr<Object> Set(Ptr<Object> value);
+
+private:
+    Binding* Resolve();
+
+    Program* program_;
+    std::string name_;
+    // Global bindings never move or go away once created.
+    Binding* binding_ = nullptr;
+};
+
+// A local variable assigned with set! or introduced by an internal define, shared by all
+// closures capturing it.
+using Box = Ptr<Binding>;
+
+inline Box MakeBox(Ptr<Object> value) {
+    auto box = std::make_shared<Binding>();
+    box->value = std::move(value);
+    return box;
+}
+
+inline Box MakeUndefinedBox() {
+    auto box = std::make_shared<Binding>();
+    box->defined = false;
+    return box;
+}
+
+const Ptr<Object>& Get(const Box& box);
+
+inline Ptr<Object> Set(const Box& box, Ptr<Object> value) {
+    *box = std::move(value);
+    return nullptr;
+}
+
+inline bool IsTrue(const Ptr<Object>& value) {
+    auto* boolean = dynamic_cast<Boolean*>(value.get());
+    return boolean == nullptr || boolean->var_;
+}
+
+// Arguments in the order they are written: braced initialization evaluates them left to right.
+struct Operands {
+    Ptr<Object> lhs;
+    Ptr<Object> rhs;
+};
+
+struct Application {
+    Ptr<Object> callee;
+    std::vector<Ptr<Object>> args;
+};
+
+enum class Fixnum { ADD, SUB, MUL, EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL };
+
+// Fixnum arithmetic done natively; operands of other types and overflows are handed to the
+// builtin, which computes the result or reports the error.
+inline Ptr<Object> Arithmetic(Fixnum op, const Operands& operands, Callable* builtin) {
+    auto* a = dynamic_cast<Number*>(operands.lhs.get());
+    auto* b = dynamic_cast<Number*>(operands.rhs.get());
+    int res;
+    if (a != nullptr && b != nullptr) {
+        bool overflow = true;
+        switch (op) {
+            case Fixnum::ADD:
+                overflow = __builtin_add_overflow(a->GetValue(), b->GetValue(), &res);
+                break;
+            case Fixnum::SUB:
+                overflow = __builtin_sub_overflow(a->GetValue(), b->GetValue(), &res);
+                break;
+            case Fixnum::MUL:
+                overflow = __builtin_mul_overflow(a->GetValue(), b->GetValue(), &res);
+                break;
+            default:
+                break;
+        }
+        if (!overflow) {
+            return MakeNumber(res);
+        }
+    }
+    return builtin->Apply({operands.lhs, operands.rhs});
+}
+
+// Fixnum comparison as a C++ bool, for conditions.
+inline bool Test(Fixnum op, const Operands& operands, Callable* builtin) {
+    auto* a = dynamic_cast<Number*>(operands.lhs.get());
+    auto* b = dynamic_cast<Number*>(operands.rhs.get());
+    if (a == nullptr || b == nullptr) {
+        return IsTrue(builtin->Apply({operands.lhs, operands.rhs}));
+    }
+    switch (op) {
+        case Fixnum::EQUAL:
+            return a->GetValue() == b->GetValue();
+        case Fixnum::LESS:
+            return a->GetValue() < b->GetValue();
+        case Fixnum::GREATER:
+            return a->GetValue() > b->GetValue();
+        case Fixnum::LESS_EQUAL:
+            return a->GetValue() <= b->GetValue();
+        case Fixnum::GREATER_EQUAL:
+            return a->GetValue() >= b->GetValue();
+        default:
+            return IsTrue(builtin->Apply({operands.lhs, operands.rhs}));
+    }
+}
+
+inline Ptr<Object> Compare(Fixnum op, const Operands& operands, Callable* builtin) {
+    return MakeBoolean(Test(op, operands, builtin));
+}
+
+inline Ptr<Object> Car(const Ptr<Object>& pair, Callable* builtin) {
+    if (auto* cell = dynamic_cast<Cell*>(pair.get())) {
+        return cell->GetFirst();
+    }
+    return builtin->Apply({pair});
+}
+
+inline Ptr<Object> Cdr(const Ptr<Object>& pair, Callable* builtin) {
+    if (auto* cell = dynamic_cast<Cell*>(pair.get())) {
+        return cell->GetSecond();
+    }
+    return builtin->Apply({pair});
+}
+
+// Throws unless callee can be called, before the arguments are evaluated like the evaluator
+// does.
+inline Ptr<Object> Callee(Ptr<Object> callee) {
+    As<Callable>(callee);
+    return callee;
+}
+
+Ptr<Object> Call(const Application& application);
+
+// A call in tail position of a translated lambda. The lambda returns it, and the Closure::Apply
+// which ran the lambda makes the call in its place, so that translated procedures calling each
+// other in tail position run in constant stack like interpreted ones.
+class DeferredCall : public Object {
+public:
+    explicit DeferredCall(Application application) : application_(std::move(application)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        throw RuntimeError("A deferred call can not be evaluated");
+    }
+    std::string ToString() override {
+        return std::string();
+    }
+    Application& GetApplication() {
+        return application_;
+    }
+    ~DeferredCall() override = default;
+
+private:
+    Application application_;
+};
+
+// Defers a call to a translated lambda, makes any other call now.
+Ptr<Object> DeferCall(Application application);
+
+// The builtin or evaluates the first argument which is not a boolean once more, in the global
+// scope since translated code has no frames.
+Ptr<Object> Reevaluate(const Ptr<Object>& value, Program* program);
+
+// Throws the error evaluating () raises.
+Ptr<Object> EvalEmpty();
+
+// A translated lambda.
+class Closure : public Callable {
+public:
+    using Function = std::function<Ptr<Object>(const std::vector<Ptr<Object>>&)>;
+
+    Closure(size_t arity, Function function) : arity_(arity), function_(std::move(function)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Lambda Procedure";
+    }
+    Ptr<Object> Call(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    Ptr<Object> Apply(const std::vector<Ptr<Object>>& args) override;
+    ~Closure() override = default;
+
+private:
+    size_t arity_;
+    Function function_;
+};
+
+inline Ptr<Object> MakeClosure(size_t arity, Closure::Function function) {
+    return std::make_shared<Closure>(arity, std::move(function));
+}
+
+}  // namespace compiled
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "object.h"
+
+// eq?: the same object. Symbols with the same name and booleans with the same value count as
+// the same object, since neither is unique in memory; so does the empty list.
+bool IsEq(const Ptr<Object>& a, const Ptr<Object>& b);
+
+// eqv?: eq?, or numbers with the same value.
+bool IsEqv(const Ptr<Object>& a, const Ptr<Object>& b);
+
+// equal?: the same structure of pairs with eqv? leaves, strings being compared by contents.
+// Pairs are walked with an explicit stack, so neither long nor deep data grows the native one;
+// identical and interned pairs (see hash_cons.h) are compared without looking into them. Past
+// kAcyclicSteps pairs, compared pairs are remembered and not looked into again, which makes
+// cyclic data compare equal when it unfolds to the same infinite structure instead of looping.
+bool IsEqual(const Ptr<Object>& a, const Ptr<Object>& b);
+
+constexpr size_t kAcyclicSteps = 1 << 16;
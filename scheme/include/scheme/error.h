@@ -1,6 +1,10 @@
 #pragma once
 
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
 
 struct SyntaxError : public std::runtime_error {
     using std::runtime_error::runtime_error;
@@ -13,3 +17,64 @@ struct RuntimeError : public std::runtime_error {
 struct NameError : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
+
+// A resource limit of the sandbox (see sandbox.h) was reached; not an error of the program.
+struct LimitError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// An error which has not been thrown, one kind per exception above.
+struct Error {
+    enum class Kind { SYNTAX, RUNTIME, NAME, LIMIT };
+
+    // Throws the exception of this kind.
+    [[noreturn]] void Raise() const {
+        switch (kind) {
+            case Kind::SYNTAX:
+                throw SyntaxError(message);
+            case Kind::NAME:
+                throw NameError(message);
+            case Kind::LIMIT:
+                throw LimitError(message);
+            default:
+                throw RuntimeError(message);
+        }
+    }
+
+    Kind kind;
+    std::string message;
+};
+
+// Either a value or the error which prevented computing it, for code where failing is an
+// ordinary outcome and unwinding would cost more than the work itself.
+//
+// The error is kept on the heap, so that a Result of a pointer takes little more room than the
+// pointer: evaluation keeps one in every frame of a nested call.
+template <class T>
+class Result {
+public:
+    Result(T value) : state_(std::in_place_index<0>, std::move(value)) {
+    }
+    Result(Error&& error)
+        : state_(std::in_place_index<1>, std::make_unique<Error>(std::move(error))) {
+    }
+    bool IsOk() const {
+        return state_.index() == 0;
+    }
+    T& GetValue() {
+        return std::get<0>(state_);
+    }
+    Error& GetError() {
+        return *std::get<1>(state_);
+    }
+    // The value, or the error thrown.
+    T ValueOrThrow() && {
+        if (!IsOk()) {
+            GetError().Raise();
+        }
+        return std::move(GetValue());
+    }
+
+private:
+    std::variant<T, std::unique_ptr<Error>> state_;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "object.h"
+
+// A pair of a HashConsTable. Interned data is immutable: no builtin changes a pair it did not
+// just make, and the table relies on it.
+class ConsedCell final : public Cell {
+public:
+    ConsedCell(const Ptr<Object>& first, const Ptr<Object>& second, uint64_t table)
+        : Cell(first, second), table_(table) {
+    }
+    // Id of the table which made the pair; a cleared table takes a new id.
+    uint64_t GetTable() const {
+        return table_;
+    }
+    ~ConsedCell() override = default;
+
+private:
+    uint64_t table_;
+};
+
+// Whether a and b are equal, if that is known without looking into them: two pairs of the same
+// table are equal only if they are the same pair.
+inline std::optional<bool> CompareConsed(const Ptr<Object>& a, const Ptr<Object>& b) {
+    if (a == b) {
+        return true;
+    }
+    auto* x = dynamic_cast<ConsedCell*>(a.get());
+    auto* y = dynamic_cast<ConsedCell*>(b.get());
+    if (x != nullptr && y != nullptr && x->GetTable() == y->GetTable()) {
+        return false;
+    }
+    return std::nullopt;
+}
+
+// Hash-cons table of quoted data: equal numbers, symbols, strings and lists interned in it share
+// one representation, so memory grows with the unique structure of the data rather than with how
+// many times it is read. Pairs are built bottom up from interned parts, which makes the lookup
+// of a pair a lookup of two pointers.
+class HashConsTable {
+public:
+    HashConsTable();
+    HashConsTable(const HashConsTable&) = delete;
+    HashConsTable& operator=(const HashConsTable&) = delete;
+
+    // Returns the interned datum equal to datum, interning it first if there is none.
+    Ptr<Object> Intern(const Ptr<Object>& datum);
+    // Replaces the datum of every (quote datum) in form, a form as read, with the interned one.
+    // The global quote has to be the builtin: arguments of anything else may be code, which is
+    // rewritten in place. Lambdas, defines and lets which bind quote themselves are skipped.
+    void InternQuoted(const Ptr<Object>& form);
+
+    // How many distinct numbers, symbols, strings and pairs are interned.
+    size_t GetSize() const {
+        return numbers_.size() + symbols_.size() + strings_.size() + pairs_.size();
+    }
+    // Forgets every interned datum. Data interned before stays valid but is not shared with
+    // data interned after.
+    void Clear();
+
+private:
+    struct PairKey {
+        const Object* first;
+        const Object* second;
+
+        bool operator==(const PairKey&) const = default;
+    };
+    struct PairHash {
+        size_t operator()(const PairKey& key) const {
+            size_t first = std::hash<const Object*>{}(key.first);
+            return first ^ (std::hash<const Object*>{}(key.second) + 0x9e3779b9 + (first << 6) +
+                            (first >> 2));
+        }
+    };
+
+    Ptr<Object> InternAtom(const Ptr<Object>& atom);
+    // Whether a result of Intern is the table's own, equal to nothing else the table holds.
+    bool IsInterned(const Ptr<Object>& datum) const;
+    Ptr<Object> InternPair(const Ptr<Object>& first, const Ptr<Object>& second);
+
+    uint64_t id_;
+    std::unordered_map<int, Ptr<Object>> numbers_;
+    std::unordered_map<std::string, Ptr<Object>> symbols_;
+    std::unordered_map<std::string, Ptr<Object>> strings_;
+    std::unordered_map<PairKey, Ptr<Object>, PairHash> pairs_;
+};
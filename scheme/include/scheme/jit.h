@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include "object.h"
+
+// Second execution tier. A lambda body runs as its optimized AST until the lambda has been
+// called kHotCalls times; then Specialize rewrites the body for the frames it runs in: frame
+// variables are read straight from their slots, and arithmetic, comparisons, car and cdr of
+// builtins are done in place on fixnums and pairs instead of going through a generic call.
+//
+// Specialized nodes guard their assumptions and deoptimize when one fails: an operand of the
+// wrong type or an overflow falls back to the builtin itself, a rebound builtin to evaluating
+// the original expression.
+//
+// On x86-64 the specialized fixnum arithmetic is compiled further to machine code (see native.h).
+constexpr size_t kHotCalls = 64;
+
+// Base of the nodes standing for an application of the builtin name: valid while name is
+// bound to it in the global scope the node was made in.
+class Specialized : public Object {
+public:
+    Specialized(std::string name, Ptr<Object> builtin, Ptr<Object> original, Environemnt* env);
+    std::string ToString() override {
+        return Object::ToString(original_);
+    }
+    const Ptr<Object>& GetOriginal() const {
+        return original_;
+    }
+    // How many times the fast path was left for the builtin.
+    size_t GetDeopts() const {
+        return deopts_;
+    }
+    // Whether the builtin is still what the name is bound to.
+    bool Guard(const Ptr<Environemnt>& env);
+
+protected:
+    Ptr<Object> Deopt(const std::vector<Ptr<Object>>& args);
+
+    Ptr<Object> original_;
+
+private:
+    std::string name_;
+    Ptr<Object> builtin_;
+    uint64_t env_id_;
+    uint64_t version_;
+    bool valid_ = true;
+    size_t deopts_ = 0;
+};
+
+// (op a b) for a builtin +, -, *, =, <, >, <= or >=.
+class FixnumOp : public Specialized {
+public:
+    enum class Op { ADD, SUB, MUL, EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL };
+
+    FixnumOp(Op op, Ptr<Object> lhs, Ptr<Object> rhs, std::string name, Ptr<Object> builtin,
+             Ptr<Object> original, Environemnt* env)
+        : Specialized(std::move(name), std::move(builtin), std::move(original), env),
+          op_(op),
+          lhs_(std::move(lhs)),
+          rhs_(std::move(rhs)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    Op GetOp() const {
+        return op_;
+    }
+    Ptr<Object>& GetLhs() {
+        return lhs_;
+    }
+    Ptr<Object>& GetRhs() {
+        return rhs_;
+    }
+    ~FixnumOp() override = default;
+
+private:
+    Op op_;
+    Ptr<Object> lhs_;
+    Ptr<Object> rhs_;
+    // Comparisons return these instead of allocating a boolean every time.
+    Ptr<Object> true_ = MakeBoolean(true);
+    Ptr<Object> false_ = MakeBoolean(false);
+};
+
+// (car x) or (cdr x) for the builtin car or cdr.
+class PairAccess : public Specialized {
+public:
+    PairAccess(bool first, Ptr<Object> pair, std::string name, Ptr<Object> builtin,
+               Ptr<Object> original, Environemnt* env)
+        : Specialized(std::move(name), std::move(builtin), std::move(original), env),
+          first_(first),
+          pair_(std::move(pair)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    Ptr<Object>& GetPair() {
+        return pair_;
+    }
+    ~PairAccess() override = default;
+
+private:
+    bool first_;
+    Ptr<Object> pair_;
+};
+
+// A variable of the frame, read from its slot without a lookup.
+class LocalRef : public Object {
+public:
+    LocalRef(int slot, Ptr<Object> original) : slot_(slot), original_(std::move(original)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    std::string ToString() override {
+        return Object::ToString(original_);
+    }
+    int GetSlot() const {
+        return slot_;
+    }
+    ~LocalRef() override = default;
+
+private:
+    int slot_;
+    Ptr<Object> original_;
+};
+
+// Rewrites ast, an optimized expression of a body running in frame env, into specialized nodes.
+// Expressions are rewritten in place where Optimize rewrites them; bodies of nested lambdas and
+// lets are left alone, they are specialized once hot themselves.
+Ptr<Object> Specialize(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "object.h"
+
+// A preprocessed lambda (or let) body, shared by all closures created from the same source.
+// Knows the frame layout of its calls and which variables of the enclosing frame it captures;
+// every other free variable is global.
+class LambdaForm : public Object {
+public:
+    LambdaForm(std::vector<std::string> params, bool variadic, const Ptr<Object>& body,
+               Environemnt* env);
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Lambda Form";
+    }
+    // Takes the captured variables out of the enclosing environment env.
+    std::vector<Ptr<Binding>> Capture(Environemnt* env) const;
+    // Runs the body, and then every call the body makes in tail position, in constant stack.
+    Ptr<Object> Run(const std::vector<Ptr<Binding>>& captures, const std::vector<Ptr<Object>>& args,
+                    const Ptr<Environemnt>& global);
+    // Run returning the errors Object::TryEval does.
+    Result<Ptr<Object>> TryRun(const std::vector<Ptr<Binding>>& captures,
+                               const std::vector<Ptr<Object>>& args,
+                               const Ptr<Environemnt>& global);
+    // Scope of the environment the form was built for: a form is reused only there.
+    uint64_t GetEnclosingScopeId() const {
+        return enclosing_scope_;
+    }
+    ~LambdaForm() override = default;
+
+private:
+    Result<Ptr<Environemnt>> MakeFrame(const std::vector<Ptr<Binding>>& captures,
+                                       const std::vector<Ptr<Object>>& args,
+                                       const Ptr<Environemnt>& global);
+    Result<Ptr<Object>> RunBody(const Ptr<Environemnt>& frame, TailCall* tail);
+
+    Ptr<Shape> shape_;
+    size_t params_count_;
+    bool variadic_;
+    size_t defines_count_;
+    std::vector<int> capture_slots_;
+    std::vector<Ptr<Object>> body_;
+    uint64_t enclosing_scope_;
+    bool optimized_ = false;
+    size_t calls_ = 0;
+};
+
+// A call left pending by the last expression of a body: run by LambdaForm::Run once the frame
+// of the current call is released.
+struct TailCall {
+    Ptr<LambdaForm> form;
+    std::vector<Ptr<Binding>> captures;
+    std::vector<Ptr<Object>> args;
+    Ptr<Environemnt> global;
+    bool pending = false;
+};
+
+// A closure: a form plus the bindings it captured. Holds only the variables the body uses, not
+// the frames it was created in.
+class Lambda : public Callable {
+public:
+    Lambda(Ptr<LambdaForm> form, std::vector<Ptr<Binding>> captures, const Ptr<Environemnt>& global)
+        : form_(std::move(form)), captures_(std::move(captures)), global_(global) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Lambda Procedure";
+    }
+    Ptr<Object> Call(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    Ptr<Object> CallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) override;
+    Ptr<Object> Apply(const std::vector<Ptr<Object>>& args) override;
+    Result<Ptr<Object>> TryCall(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    Result<Ptr<Object>> TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env,
+                                    TailCall* tail) override;
+    Result<Ptr<Object>> TryApply(const std::vector<Ptr<Object>>& args) override;
+    ~Lambda() override = default;
+
+private:
+    Ptr<Environemnt> LockGlobal() const;
+
+    Ptr<LambdaForm> form_;
+    std::vector<Ptr<Binding>> captures_;
+    // Weak: the global scope owns closures through its bindings.
+    std::weak_ptr<Environemnt> global_;
+};
+
+// Special forms, ast being the list of their arguments.
+Ptr<Object> EvalLambda(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
+Ptr<Object> EvalDefine(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
+Ptr<Object> EvalSet(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
+Ptr<Object> EvalLet(const Ptr<Object>& ast, const Ptr<Environemnt>& env, TailCall* tail);
+Ptr<Object> EvalIf(const Ptr<Object>& ast, const Ptr<Environemnt>& env, TailCall* tail);
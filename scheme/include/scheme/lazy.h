@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include "object.h"
+
+// Where the slots of lazy pairs are read from: a file holding one datum, positions being
+// offsets of data in it.
+class LazySource : public std::enable_shared_from_this<LazySource> {
+public:
+    // The datum at pos, lists in it left lazy.
+    virtual Ptr<Object> Element(size_t pos) = 0;
+    // What follows the element at pos of a list: the next pair, or the tail after the last
+    // element. Binary lists know how many elements remain after the one at pos.
+    virtual Ptr<Object> Rest(size_t pos, size_t remaining) = 0;
+    virtual ~LazySource() = default;
+};
+
+// A pair of a list read from a LazySource when its car or its cdr is first accessed.
+class LazyCell : public Cell {
+public:
+    LazyCell(Ptr<LazySource> source, size_t pos, size_t remaining)
+        : Cell(kUnrealized, kUnrealized), source_(std::move(source)), pos_(pos),
+          remaining_(remaining) {
+    }
+    ~LazyCell() override = default;
+
+protected:
+    void RealizeFirst() override;
+    void RealizeSecond() override;
+
+private:
+    // Released once both slots are realized.
+    Ptr<LazySource> source_;
+    size_t pos_;
+    size_t remaining_;
+};
+
+// Loads the datum in the file at path, text or binary (see binary.h), without parsing it. The
+// file is mapped and scanned once to index where its lists end; then each pair of a list is
+// parsed when car or cdr first reaches it, so untouched parts of the data cost no memory but
+// their share of the index. Atoms are parsed on access too; quoted data is parsed whole.
+//
+// Throws SyntaxError if the lists of the file are not balanced.
+Ptr<Object> LoadData(const std::string& path);
+
+// Binds load-data, which takes the path as a string or a symbol.
+void InstallLoadData(Environemnt* env);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "jit.h"
+
+// Third execution tier, on x86-64 only. Once a body has been specialized, CompileNative turns
+// every tree of fixnum operations whose leaves are frame variables and number constants into
+// machine code: the leaves are unboxed, the arithmetic runs in registers with an overflow check
+// after each operation, and only the final result is boxed again. Elsewhere CompileNative leaves
+// the specialized nodes as they are.
+//
+// The code is emitted by a small in-tree assembler into pages of its own, which are made
+// executable once written and unmapped with the node.
+#if defined(__x86_64__)
+constexpr bool kNativeCode = true;
+#else
+constexpr bool kNativeCode = false;
+#endif
+
+// Leaves a tree may have at most to be compiled.
+constexpr size_t kMaxNativeOperands = 16;
+
+// A fixnum expression run as machine code. When a leaf is not a number or an operation
+// overflows it deoptimizes: the specialized tree it was compiled from evaluates the expression
+// instead, deoptimizing further as needed. While a builtin of the tree is rebound the tree is
+// evaluated too.
+class NativeFixnum : public Object {
+public:
+    // Takes the arguments of the leaves and stores the value of the expression, or 1 or 0 for
+    // a comparison, to result; returns false on overflow.
+    using Code = bool (*)(const int32_t* operands, int32_t* result);
+
+    // Takes over code, size bytes mapped for it alone.
+    NativeFixnum(Ptr<FixnumOp> tree, std::vector<Ptr<FixnumOp>> ops, std::vector<int> slots,
+                 void* code, size_t size);
+    NativeFixnum(const NativeFixnum&) = delete;
+    NativeFixnum& operator=(const NativeFixnum&) = delete;
+    Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    std::string ToString() override {
+        return tree_->ToString();
+    }
+    const Ptr<FixnumOp>& GetTree() const {
+        return tree_;
+    }
+    // How many times the machine code was left for the tree.
+    size_t GetDeopts() const {
+        return deopts_;
+    }
+    ~NativeFixnum() override;
+
+private:
+    Ptr<FixnumOp> tree_;
+    // Every operation of the tree, whose builtins are guarded.
+    std::vector<Ptr<FixnumOp>> ops_;
+    // Slots of the frame variables, in the order the tree evaluates them.
+    std::vector<int> slots_;
+    bool comparison_;
+    Code code_;
+    size_t size_;
+    size_t deopts_ = 0;
+    Ptr<Object> true_ = MakeBoolean(true);
+    Ptr<Object> false_ = MakeBoolean(false);
+};
+
+// Rewrites ast, a specialized expression of a body running in frame env, replacing fixnum trees
+// by NativeFixnum nodes the way Specialize replaces applications.
+Ptr<Object> CompileNative(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
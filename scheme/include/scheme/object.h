@@ -1,9 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include "error.h"
+#include "pool.h"
+#include "reclaimer.h"
+#include "sandbox.h"
 #include <unordered_map>
 #include <functional>
+#include <limits>
+#include <optional>
+#include <vector>
 
 template <typename T>
 using Ptr = std::shared_ptr<T>;
@@ -12,11 +19,32 @@ class Interpreter;
 
 class Environemnt;
 
+struct TailCall;
+
 class Object : public std::enable_shared_from_this<Object> {
 public:
     virtual Ptr<Object> Eval(Ptr<Environemnt> env) = 0;
+    // Evaluates in tail position of a lambda body: a call to a closure is not made, but stored
+    // in tail for the caller to run in place of its own frame.
+    virtual Ptr<Object> EvalTail(Ptr<Environemnt> env, TailCall* tail) {
+        return Eval(env);
+    }
+    // Like Eval and EvalTail, but the errors the evaluator itself finds are returned instead of
+    // thrown: unbound names, applying what is not a procedure, and arguments of the wrong type or
+    // number to builtins and lambdas. Eval of symbols, applications, builtins and lambdas wraps
+    // these; errors raised in special forms and in the bodies of builtins are still thrown.
+    virtual Result<Ptr<Object>> TryEval(Ptr<Environemnt> env) {
+        return Eval(std::move(env));
+    }
+    virtual Result<Ptr<Object>> TryEvalTail(Ptr<Environemnt> env, TailCall* tail) {
+        return EvalTail(std::move(env), tail);
+    }
     virtual std::string ToString() = 0;
     static Ptr<Object> Eval(Ptr<Object> ast, Ptr<Environemnt> env);
+    static Ptr<Object> EvalTail(const Ptr<Object>& ast, Ptr<Environemnt> env, TailCall* tail);
+    static Result<Ptr<Object>> TryEval(const Ptr<Object>& ast, Ptr<Environemnt> env);
+    static Result<Ptr<Object>> TryEvalTail(const Ptr<Object>& ast, Ptr<Environemnt> env,
+                                           TailCall* tail);
     static std::string ToString(Ptr<Object> object);
     virtual ~Object() = default;
 };
@@ -27,16 +55,130 @@ public:
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
 
+// A variable slot. Slots never move while their environment is alive, so evaluation sites may
+// cache a pointer to them instead of looking the name up every time.
+struct Binding {
+    Binding& operator=(Ptr<Object> new_value) {
+        value = std::move(new_value);
+        defined = true;
+        return *this;
+    }
+    Ptr<Object> value;
+    // False for a slot of an internal define which has not been executed yet.
+    bool defined = true;
+};
+
+// Names of the variables of a lambda frame in slot order: parameters, internal defines and
+// captured variables. Shared by all frames of one lambda, so that symbols can cache the slot a
+// name resolves to.
+struct Shape {
+    Shape();
+    // Returns -1 if there is no such variable.
+    int Find(const std::string& name) const;
+
+    uint64_t id;
+    std::vector<std::string> names;
+};
+
+// Marks a thread evaluating code for a parallel builtin, for as long as it lives: the calling
+// thread and its workers then share the forms of the procedure they apply. Caches which
+// evaluation fills in lazily, the inline caches of symbols and call sites, optimized and compiled
+// lambda bodies and rewrite guards, are read but never written meanwhile; such a thread evaluates
+// whatever a cache does not hold yet the slow way.
+class ParallelSection {
+public:
+    ParallelSection() : outer_(active) {
+        active = true;
+    }
+    ParallelSection(const ParallelSection&) = delete;
+    ParallelSection& operator=(const ParallelSection&) = delete;
+    ~ParallelSection() {
+        active = outer_;
+    }
+    static bool IsActive() {
+        return active;
+    }
+
+private:
+    static constinit inline thread_local bool active = false;
+    bool outer_;
+};
+
+// Threads a parallel builtin may run on, the calling one included: hardware_concurrency unless
+// set otherwise.
+size_t GetParallelism();
+void SetParallelism(size_t threads);
+
+// Either the global scope, where names are hashed, or a flat frame of a lambda call, whose
+// variables live in slots described by a Shape. Frames never chain to each other: everything a
+// frame does not hold itself is looked up in the global scope.
 class Environemnt : public Object {
 public:
+    Environemnt();
+    Environemnt(Ptr<const Shape> shape, Ptr<Environemnt> global);
     Ptr<Object> Eval(Ptr<Environemnt> env) override;
     std::string ToString() override;
+    // Throws what Find returns.
     Ptr<Object> operator[](const std::string& symbol);
+    Result<Ptr<Object>> Find(const std::string& symbol);
+    // Returns nullptr if symbol is not bound.
+    Binding* Lookup(const std::string& symbol);
+    void Define(const std::string& symbol, Ptr<Object> value);
     void FullfillR5RS();
+    // Returns what FullfillR5RS bound name to, whatever name is bound to now, or nullptr.
+    Ptr<Object> GetBuiltin(const std::string& name) const;
+    bool IsGlobal() const {
+        return shape_ == nullptr;
+    }
+    Environemnt* GetGlobal() {
+        return IsGlobal() ? this : global_.get();
+    }
+    const Ptr<Environemnt>& GetGlobalPtr() const {
+        return global_;
+    }
+    // Returns the slot of symbol in a frame, or -1 if it is looked up in the global scope.
+    int FindSlot(const std::string& symbol) const {
+        return IsGlobal() ? -1 : shape_->Find(symbol);
+    }
+    bool IsLocal(const std::string& symbol) const {
+        return FindSlot(symbol) >= 0;
+    }
+    std::vector<Ptr<Binding>>& GetSlots() {
+        return slots_;
+    }
+    // Unique for the whole process, never reused by another environment. Zero for frames.
+    uint64_t GetId() const {
+        return id_;
+    }
+    // Identifies the layout of the environment: the id of a global scope, the shape id of a
+    // frame. Symbols and call sites cache lookups by it.
+    uint64_t GetScopeId() const {
+        return IsGlobal() ? id_ : shape_->id;
+    }
+    // Incremented on every rebinding of a global, invalidates cached callables at call sites.
+    uint64_t GetVersion() const {
+        return version_;
+    }
+    void Touch() {
+        ++version_;
+    }
     ~Environemnt() override = default;
 
 private:
-    std::unordered_map<std::string, Ptr<Object>> bindings_;
+    // The list library of lists.cpp, part of FullfillR5RS.
+    void FullfillLists();
+    // eq?, eqv? and equal? of equality.cpp, part of FullfillR5RS.
+    void FullfillEquality();
+    // Strings and string ports of text.cpp, part of FullfillR5RS.
+    void FullfillStrings();
+
+    std::unordered_map<std::string, Binding> bindings_;
+    std::unordered_map<std::string, Ptr<Object>> builtins_;
+    uint64_t id_ = 0;
+    uint64_t version_ = 0;
+    Ptr<const Shape> shape_;
+    std::vector<Ptr<Binding>> slots_;
+    Ptr<Environemnt> global_;
 };
 
 // ------------------------------------------------------------------------------------
@@ -48,6 +190,7 @@ private:
 class Number : public Object {
 public:
     Number(int value) : value_(value) {
+        Sandbox::Allocate(sizeof(Number));
     }
     int GetValue() const {
         return value_;
@@ -65,6 +208,32 @@ private:
     int value_;
 };
 
+// Fixnums from kMinSharedNumber to kMaxSharedNumber are allocated once per thread and shared by
+// every value they are; numbers are immutable.
+constexpr int kMinSharedNumber = -128;
+constexpr int kMaxSharedNumber = 1023;
+
+inline Ptr<Number> MakeNumber(int value) {
+    if (value < kMinSharedNumber || value > kMaxSharedNumber) {
+        return std::make_shared<Number>(value);
+    }
+    thread_local Ptr<Number> shared[kMaxSharedNumber - kMinSharedNumber + 1];
+    Ptr<Number>& number = shared[value - kMinSharedNumber];
+    if (number == nullptr) {
+        number = std::make_shared<Number>(value);
+    }
+    return number;
+}
+
+// The number of a size or a count computed by the builtin name; throws RuntimeError if it is past
+// the fixnum range.
+inline Ptr<Number> MakeSize(size_t size, const char* name) {
+    if (size > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        throw RuntimeError(std::string(name) + ": " + std::to_string(size) + " is out of range");
+    }
+    return MakeNumber(static_cast<int>(size));
+}
+
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
@@ -74,12 +243,20 @@ private:
 class Symbol : public Object {
 public:
     Symbol(const std::string& name) : name_(name) {
+        Sandbox::Allocate(sizeof(Symbol) + name.size());
     }
     const std::string& GetName() const {
         return name_;
     }
 
     Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    Result<Ptr<Object>> TryEval(Ptr<Environemnt> env) override;
+    // Returns the binding the symbol refers to in env, or nullptr if it is not bound.
+    Binding* Resolve(Environemnt* env);
+    // Whether the last Resolve found a global rather than a frame slot.
+    bool IsResolvedGlobal() const {
+        return cached_slot_ < 0;
+    }
 
     std::string ToString() override {
         return name_;
@@ -87,6 +264,12 @@ public:
 
 private:
     std::string name_;
+    // Inline cache, valid for environments with scope cached_scope_ and global cached_global_:
+    // either the frame slot the name lives in or the global binding.
+    uint64_t cached_scope_ = 0;
+    uint64_t cached_global_ = 0;
+    int cached_slot_ = -1;
+    Binding* cached_binding_ = nullptr;
 };
 
 // ------------------------------------------------------------------------------------
@@ -95,37 +278,217 @@ private:
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
 
+class Callable;
+
+// Call site cache: the global callable the head of an application resolved to, valid for the
+// same scope while the global environment keeps its version. Special forms also keep their
+// preprocessed arguments here.
+struct CallSite {
+    uint64_t scope = 0;
+    uint64_t global = 0;
+    uint64_t version = 0;
+    Ptr<Object> callee;
+    Callable* callable = nullptr;
+    Ptr<Object> form;
+};
+
+// Held by the slots of a lazy pair (see lazy.h) until they are first accessed.
+class Unrealized : public Object {
+public:
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        throw RuntimeError("Unrealized data can not be evaluated");
+    }
+    std::string ToString() override {
+        return std::string();
+    }
+    ~Unrealized() override = default;
+};
+
+inline const Ptr<Object> kUnrealized = std::make_shared<Unrealized>();
+
 class Cell : public Object {
 public:
     Cell(const Ptr<Object>& first, const Ptr<Object>& second) : first_(first), second_(second) {
+        Sandbox::Allocate(sizeof(Cell));
     }
     Ptr<Object>& GetFirst() {
+        if (first_ == kUnrealized) [[unlikely]] {
+            RealizeFirst();
+        }
         return first_;
     }
     Ptr<Object>& GetSecond() {
+        if (second_ == kUnrealized) [[unlikely]] {
+            RealizeSecond();
+        }
         return second_;
     }
+    // The call site cache of a pair which keeps one (see FormCell), nullptr for any other.
+    virtual CallSite* GetSite() {
+        return nullptr;
+    }
     std::string ToString() override;
-    ~Cell() override = default;
+    ~Cell() override;
 
     std::shared_ptr<Object> Eval(Ptr<Environemnt> env) override;
+    Ptr<Object> EvalTail(Ptr<Environemnt> env, TailCall* tail) override;
+    Result<Ptr<Object>> TryEval(Ptr<Environemnt> env) override;
+    Result<Ptr<Object>> TryEvalTail(Ptr<Environemnt> env, TailCall* tail) override;
+
+protected:
+    // Replace kUnrealized in a slot with its value.
+    virtual void RealizeFirst() {
+    }
+    virtual void RealizeSecond() {
+    }
 
 private:
+    // Returns what the head evaluates to, keeping it alive in callee.
+    Result<Callable*> ResolveCallee(const Ptr<Environemnt>& env, Ptr<Object>* callee);
+
+protected:
     std::shared_ptr<Object> first_;
     std::shared_ptr<Object> second_;
 };
 
+// A pair of source code, as the reader and the optimizer make them. Any of them may be evaluated
+// as an application, so they carry the call site cache which pairs built at run time, the bulk
+// of most heaps, do without.
+class FormCell final : public Cell {
+public:
+    FormCell(const Ptr<Object>& first, const Ptr<Object>& second) : Cell(first, second) {
+    }
+    // Allocated the first time the cell is evaluated as an application outside a parallel
+    // section.
+    CallSite* GetSite() override {
+        if (site_ == nullptr && !ParallelSection::IsActive()) {
+            site_ = std::make_unique<CallSite>();
+        }
+        return site_.get();
+    }
+    ~FormCell() override = default;
+
+private:
+    std::unique_ptr<CallSite> site_;
+};
+
+// Pairs are the bulk of most heaps: they take one pool block each, control block included. That
+// is still 72 bytes on 64-bit targets, only 8 less than the general allocator would use, since a
+// pair is a shared_ptr-managed object with two shared_ptr slots. Lists of small numbers save
+// much more through the shared fixnums of MakeNumber.
+inline Ptr<Cell> MakeCell(const Ptr<Object>& first, const Ptr<Object>& second) {
+    Reclaimer::Step();
+    return std::allocate_shared<Cell>(PoolAllocator<Cell>(), first, second);
+}
+
+inline Ptr<Cell> MakeFormCell(const Ptr<Object>& first, const Ptr<Object>& second) {
+    Reclaimer::Step();
+    return std::allocate_shared<FormCell>(PoolAllocator<FormCell>(), first, second);
+}
+
+// Argument buffer borrowed for the duration of one call from a per-thread pool, so that calls
+// reuse the storage of finished ones instead of allocating a vector each time. Nested calls
+// borrow distinct buffers.
+template <typename T>
+class ScratchVector {
+public:
+    ScratchVector() {
+        auto& pool = Pool();
+        if (!pool.empty()) {
+            vector_ = std::move(pool.back());
+            pool.pop_back();
+        }
+    }
+    ScratchVector(const ScratchVector&) = delete;
+    ScratchVector& operator=(const ScratchVector&) = delete;
+    ~ScratchVector() {
+        auto& pool = Pool();
+        if (pool.size() < kMaxPooled && vector_.capacity() <= kMaxCapacity) {
+            vector_.clear();
+            pool.push_back(std::move(vector_));
+        }
+    }
+    std::vector<Ptr<T>>& operator*() {
+        return vector_;
+    }
+    std::vector<Ptr<T>>* operator->() {
+        return &vector_;
+    }
+
+private:
+    static constexpr size_t kMaxPooled = 64;
+    static constexpr size_t kMaxCapacity = 256;
+
+    static std::vector<std::vector<Ptr<T>>>& Pool() {
+        thread_local std::vector<std::vector<Ptr<T>>> pool;
+        return pool;
+    }
+
+    std::vector<Ptr<T>> vector_;
+};
+
 class Callable : public Object {
 public:
     virtual Ptr<Object> Call(Ptr<Object> ast, Ptr<Environemnt> env) = 0;
+    // Call in tail position, see Object::EvalTail.
+    virtual Ptr<Object> CallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) {
+        return Call(ast, env);
+    }
+    // Calls with already evaluated arguments.
+    virtual Ptr<Object> Apply(const std::vector<Ptr<Object>>& args) = 0;
+    // Call, CallTail and Apply returning the errors Object::TryEval does.
+    virtual Result<Ptr<Object>> TryCall(Ptr<Object> ast, Ptr<Environemnt> env) {
+        return Call(std::move(ast), std::move(env));
+    }
+    virtual Result<Ptr<Object>> TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env,
+                                            TailCall* tail) {
+        return CallTail(std::move(ast), std::move(env), tail);
+    }
+    virtual Result<Ptr<Object>> TryApply(const std::vector<Ptr<Object>>& args) {
+        return Apply(args);
+    }
+    // Pure callables have no side effects and may be applied from several threads at once.
+    virtual bool IsPure() const {
+        return false;
+    }
     virtual ~Callable() = default;
 };
 
+// How many arguments a builtin takes; Procedure checks it before calling the builtin.
+struct Arity {
+    static constexpr size_t kAny = SIZE_MAX;
+
+    static Arity Exactly(const char* name, size_t count) {
+        return {name, count, count};
+    }
+    static Arity AtLeast(const char* name, size_t count) {
+        return {name, count, kAny};
+    }
+    static Arity Between(const char* name, size_t min, size_t max) {
+        return {name, min, max};
+    }
+
+    // The error of a call with count arguments, if it is one.
+    std::optional<Error> Check(size_t count) const {
+        if (count >= min && count <= max) {
+            return std::nullopt;
+        }
+        return Mismatch();
+    }
+    Error Mismatch() const;
+
+    // Names the builtin in the error.
+    const char* name = nullptr;
+    size_t min = 0;
+    size_t max = kAny;
+};
+
 template <typename T>
 class Procedure : public Callable {
 public:
-    Procedure(std::function<Ptr<Object>(const std::vector<Ptr<T>>&)> function)
-        : function_(function) {
+    Procedure(std::function<Ptr<Object>(const std::vector<Ptr<T>>&)> function, bool pure = false,
+              Arity arity = {})
+        : function_(function), pure_(pure), arity_(arity) {
     }
     Ptr<Object> Eval(Ptr<Environemnt> env) override;
     std::string ToString() override;
@@ -133,19 +496,74 @@ public:
 
 public:
     Ptr<Object> Call(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    Ptr<Object> Apply(const std::vector<Ptr<Object>>& args) override;
+    Result<Ptr<Object>> TryCall(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    // A builtin leaves no tail call behind: straight to TryCall, not through Call.
+    Result<Ptr<Object>> TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall*) override {
+        return TryCall(std::move(ast), std::move(env));
+    }
+    Result<Ptr<Object>> TryApply(const std::vector<Ptr<Object>>& args) override;
+    bool IsPure() const override {
+        return pure_;
+    }
 
 private:
+    Result<Ptr<Object>> Invoke(const std::vector<Ptr<T>>& args);
+
     std::function<Ptr<Object>(const std::vector<Ptr<T>>&)> function_;
+    bool pure_;
+    Arity arity_;
 };
 std::vector<Ptr<Object>> CollectArguments(Ptr<Object> ast);
 template <typename T>
 Ptr<Object> Procedure<T>::Call(Ptr<Object> ast, Ptr<Environemnt> env) {
-    std::vector<Ptr<Object>> args = CollectArguments(ast);
-    std::vector<Ptr<T>> evaluated_args;
-    for (Ptr<Object> ptr : args) {
-        evaluated_args.push_back(As<T>(Object::Eval(ptr, env)));
+    return TryCall(std::move(ast), std::move(env)).ValueOrThrow();
+}
+template <typename T>
+Ptr<Object> Procedure<T>::Apply(const std::vector<Ptr<Object>>& args) {
+    return TryApply(args).ValueOrThrow();
+}
+template <typename T>
+Result<Ptr<Object>> Procedure<T>::TryCall(Ptr<Object> ast, Ptr<Environemnt> env) {
+    ScratchVector<T> evaluated_args;
+    const Ptr<Object>* cur = &ast;
+    while (*cur != nullptr) {
+        auto* cell = dynamic_cast<Cell*>(cur->get());
+        Result<Ptr<Object>> value = Object::TryEval(cell == nullptr ? *cur : cell->GetFirst(), env);
+        if (!value.IsOk()) {
+            return std::move(value.GetError());
+        }
+        Result<Ptr<T>> arg = TryAs<T>(value.GetValue());
+        if (!arg.IsOk()) {
+            return std::move(arg.GetError());
+        }
+        evaluated_args->push_back(std::move(arg.GetValue()));
+        if (cell == nullptr) {
+            break;
+        }
+        cur = &cell->GetSecond();
     }
-    return function_(evaluated_args);
+    return Invoke(*evaluated_args);
+}
+template <typename T>
+Result<Ptr<Object>> Procedure<T>::TryApply(const std::vector<Ptr<Object>>& args) {
+    ScratchVector<T> converted_args;
+    converted_args->reserve(args.size());
+    for (const Ptr<Object>& ptr : args) {
+        Result<Ptr<T>> arg = TryAs<T>(ptr);
+        if (!arg.IsOk()) {
+            return std::move(arg.GetError());
+        }
+        converted_args->push_back(std::move(arg.GetValue()));
+    }
+    return Invoke(*converted_args);
+}
+template <typename T>
+Result<Ptr<Object>> Procedure<T>::Invoke(const std::vector<Ptr<T>>& args) {
+    if (std::optional<Error> error = arity_.Check(args.size())) {
+        return std::move(*error);
+    }
+    return function_(args);
 }
 template <typename T>
 Ptr<Object> Procedure<T>::Eval(Ptr<Environemnt> env) {
@@ -160,15 +578,28 @@ std::string Procedure<T>::ToString() {
 class Syntax : public Callable {
 public:
     Syntax(std::function<Ptr<Object>(Ptr<Object>, Ptr<Environemnt>)> function)
+        : function_([function](Ptr<Object> ast, Ptr<Environemnt> env, TailCall*) {
+              return function(std::move(ast), std::move(env));
+          }) {
+    }
+    // For syntax which evaluates one of its arguments in tail position: tail is nullptr unless
+    // the syntax itself is in tail position.
+    Syntax(std::function<Ptr<Object>(Ptr<Object>, Ptr<Environemnt>, TailCall*)> function)
         : function_(function) {
     }
     Ptr<Object> Eval(Ptr<Environemnt> env) override;
     std::string ToString() override;
     ~Syntax() override = default;
     Ptr<Object> Call(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    Ptr<Object> CallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) override;
+    Ptr<Object> Apply(const std::vector<Ptr<Object>>& args) override;
+    // Syntax still throws its errors; these only spare the frames of Call and CallTail.
+    Result<Ptr<Object>> TryCall(Ptr<Object> ast, Ptr<Environemnt> env) override;
+    Result<Ptr<Object>> TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env,
+                                    TailCall* tail) override;
 
 private:
-    std::function<Ptr<Object>(Ptr<Object>, Ptr<Environemnt>)> function_;
+    std::function<Ptr<Object>(Ptr<Object>, Ptr<Environemnt>, TailCall*)> function_;
 };
 
 template <class T>
@@ -177,6 +608,9 @@ bool Is(const std::shared_ptr<Object>& obj);
 template <class T>
 std::shared_ptr<T> As(const std::shared_ptr<Object>& obj);
 
+template <class T>
+Result<std::shared_ptr<T>> TryAs(const std::shared_ptr<Object>& obj);
+
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
@@ -186,7 +620,7 @@ std::shared_ptr<T> As(const std::shared_ptr<Object>& obj);
 class PairIndicator : public Object {
 public:
     Ptr<Object> Eval(Ptr<Environemnt> env) override {
-        return std::make_shared<Number>(1);
+        return MakeNumber(1);
     }
     std::string ToString() override {
         return std::string();
@@ -197,7 +631,7 @@ public:
 class CloseBracketIndicator : public Object {
 public:
     Ptr<Object> Eval(Ptr<Environemnt> env) override {
-        return std::make_shared<Number>(1);
+        return MakeNumber(1);
     }
     std::string ToString() override {
         return std::string();
@@ -222,19 +656,32 @@ public:
     bool var_;
 };
 
+// Both booleans are allocated once per thread.
+inline Ptr<Boolean> MakeBoolean(bool value) {
+    thread_local Ptr<Boolean> true_value = std::make_shared<Boolean>(true);
+    thread_local Ptr<Boolean> false_value = std::make_shared<Boolean>(false);
+    return value ? true_value : false_value;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // Runtime type checking and convertion.
 // This can be helpful: https://en.cppreference.com/w/cpp/memory/shared_ptr/pointer_cast
 
+// Throws what TryAs returns.
 template <class T>
 std::shared_ptr<T> As(const std::shared_ptr<Object>& obj) {
+    return TryAs<T>(obj).ValueOrThrow();
+}
+
+template <class T>
+Result<std::shared_ptr<T>> TryAs(const std::shared_ptr<Object>& obj) {
     if constexpr (std::is_same_v<T, Object>) {
         return obj;
     }
     std::shared_ptr<T> ptr = std::dynamic_pointer_cast<T>(obj);
     if (ptr == nullptr) {
-        throw RuntimeError("Types don't match");
+        return Error{Error::Kind::RUNTIME, "Types don't match"};
     }
     return ptr;
 }
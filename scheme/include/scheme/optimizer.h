@@ -0,0 +1,97 @@
+#pragma once
+
+#include <optional>
+#include "object.h"
+
+// A subexpression replaced by its value. The value was computed from builtins and globals of
+// the environment with id env_id_ at version version_; once a global is rebound the node
+// recomputes it, or evaluates the original expression if it is no longer constant.
+class Constant : public Object {
+public:
+    Constant(Ptr<Object> value, Ptr<Object> original, Environemnt* env)
+        : value_(std::move(value)),
+          original_(std::move(original)),
+          env_id_(env->GetGlobal()->GetId()),
+          version_(env->GetGlobal()->GetVersion()) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    std::string ToString() override {
+        return Object::ToString(original_);
+    }
+    // Returns the value in env or std::nullopt if it is not constant there anymore.
+    std::optional<Ptr<Object>> Refresh(const Ptr<Environemnt>& env);
+    const Ptr<Object>& GetOriginal() const {
+        return original_;
+    }
+    // Replaces the value while the environment keeps its version, for a datum which is copied
+    // anew (see ParseCache).
+    void Reset(Ptr<Object> value) {
+        value_ = std::move(value);
+    }
+    ~Constant() override = default;
+
+private:
+    Ptr<Object> value_;
+    Ptr<Object> original_;
+    uint64_t env_id_;
+    uint64_t version_;
+};
+
+// A subexpression replaced by a cheaper equivalent which relies on builtins keeping their
+// bindings: an access to a list built in place, a lambda applied where it is written, or a chain
+// of map and filter calls. Checked like Constant; once a global is rebound the rewrite is derived
+// again, or the original expression is evaluated.
+class Rewritten : public Object {
+public:
+    Rewritten(Ptr<Object> rewritten, Ptr<Object> original, Environemnt* env)
+        : rewritten_(std::move(rewritten)),
+          original_(std::move(original)),
+          env_id_(env->GetGlobal()->GetId()),
+          version_(env->GetGlobal()->GetVersion()) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override;
+    Ptr<Object> EvalTail(Ptr<Environemnt> env, TailCall* tail) override;
+    std::string ToString() override {
+        return Object::ToString(original_);
+    }
+    const Ptr<Object>& GetOriginal() const {
+        return original_;
+    }
+    ~Rewritten() override = default;
+
+private:
+    // Returns what to evaluate in env.
+    const Ptr<Object>& Select(const Ptr<Environemnt>& env);
+
+    Ptr<Object> rewritten_;
+    Ptr<Object> original_;
+    uint64_t env_id_;
+    uint64_t version_;
+};
+
+// Returns the value of ast if it can be computed without side effects: literals, globals bound
+// to numbers, booleans or strings, quoted data and pure builtins applied to such values, as long
+// as the result is a number, a boolean or a string. Variables of lambda frames are never
+// constant.
+std::optional<Ptr<Object>> Fold(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
+
+// Replaces constant subexpressions of ast with Constant nodes. Arguments of procedure calls and
+// the expression arguments of if, and, or, define and set! are rewritten in place; arguments
+// of other syntax are left untouched, since they are not necessarily expressions.
+//
+// Also removes allocations which never escape the expression making them (see Rewritten):
+// (car (cdr (list a b c))) evaluates a, b and c without building the list, and
+// ((lambda (x) body) a) runs body as a let without creating a closure, and
+// (fold-left + 0 (map abs (filter number? xs))) runs abs and number? on each element in turn
+// without building the two intermediate lists, when all the procedures are pure.
+Ptr<Object> Optimize(const Ptr<Object>& ast, const Ptr<Environemnt>& env);
+
+// Returns what the head of an application is bound to in the global scope, or nullptr for
+// anything but a symbol bound there. Names of frame variables are never resolved: their values
+// change from call to call.
+Ptr<Object> ResolveHead(const Ptr<Object>& head, const Ptr<Environemnt>& env);
+
+// Returns the list of the arguments of application cell which are expressions, the ones
+// Optimize rewrites: all of them for a call, some of them for if, and, or, define and set!, and
+// nullptr for other syntax or an unbound head.
+Ptr<Object> ExpressionArguments(const Ptr<Cell>& cell, const Ptr<Environemnt>& env);
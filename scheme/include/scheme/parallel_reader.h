@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "object.h"
+
+// Reads every top-level datum of text, in order, on up to threads threads (as many as the
+// hardware runs when zero). The text is first scanned for places between top-level data: a
+// block at a time while only the bracket depth matters, byte by byte near the places wanted
+// and inside string literals. Each chunk between two such places is then read by a thread of
+// its own into that thread's pools, and the chunks are joined in order.
+//
+// Reading stops at the first datum which can not be read, as it would reading the text in
+// one go: its SyntaxError is thrown. Text under kMinChunkSize is read on the calling thread.
+std::vector<Ptr<Object>> ReadParallel(std::string_view text, size_t threads = 0);
+
+constexpr size_t kMinChunkSize = size_t{1} << 16;
+
+// Binds load-all-data, which reads every datum of a text file with ReadParallel and returns
+// the list of them. The path is a string or a symbol.
+void InstallLoadAllData(Environemnt* env);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "object.h"
+
+class Constant;
+
+// Least recently used cache of optimized forms, keyed by the source text they were read from,
+// so that expressions sent again and again are neither tokenized nor parsed nor optimized
+// again. A cached form is evaluated in place, like a lambda body on every call: the caches it
+// keeps inside are guarded against rebinding of globals the same way.
+//
+// Quoted data is the one part of a form evaluation hands out. Every hit replaces it with a
+// fresh copy of the data as read, so a program changing a literal it got from one run does not
+// change what the next run of the same source sees. Interned data (see hash_cons.h) is
+// immutable and kept as it is.
+class ParseCache {
+public:
+    explicit ParseCache(size_t capacity) : capacity_(capacity) {
+    }
+
+    // Returns the form cached for source, or std::nullopt. Does nothing when capacity is zero.
+    std::optional<Ptr<Object>> Lookup(std::string_view source);
+    // Caches form, the optimized form read from source, which has not been evaluated yet.
+    void Insert(std::string_view source, const Ptr<Object>& form);
+
+    // Zero disables the cache.
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+    size_t GetSize() const {
+        return entries_.size();
+    }
+    size_t GetHits() const {
+        return hits_;
+    }
+    size_t GetMisses() const {
+        return misses_;
+    }
+
+private:
+    // A (quote datum) form whose datum is a list, a copy of that datum nobody can reach and the
+    // Constant the optimizer made of the form, if any.
+    struct Literal {
+        Ptr<Cell> quote;
+        Ptr<Object> datum;
+        Constant* constant;
+    };
+
+    struct Entry {
+        size_t hash;
+        std::string source;
+        Ptr<Object> form;
+        std::vector<Literal> literals;
+    };
+
+    size_t capacity_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<size_t, std::list<Entry>::iterator> index_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
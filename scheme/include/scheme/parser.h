@@ -7,4 +7,15 @@
 
 std::shared_ptr<Object> Read(Tokenizer* tokenizer);
 
-std::shared_ptr<Object> ReadList(Tokenizer* tokenizer);
\ No newline at end of file
+std::shared_ptr<Object> ReadList(Tokenizer* tokenizer);
+
+// Read and ReadList reporting syntax errors in the result instead of throwing them.
+Result<std::shared_ptr<Object>> TryRead(Tokenizer* tokenizer);
+
+Result<std::shared_ptr<Object>> TryReadList(Tokenizer* tokenizer);
+
+// Read for data which is not evaluated: its pairs are plain cells, without the call site cache
+// of the FormCells Read makes.
+std::shared_ptr<Object> ReadDatum(Tokenizer* tokenizer);
+
+Result<std::shared_ptr<Object>> TryReadDatum(Tokenizer* tokenizer);
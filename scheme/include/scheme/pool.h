@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Blocks of Size bytes aligned to Align carved out of large chunks, without the header and
+// rounding of the general allocator. Each thread allocates from and frees to a free list of its
+// own. A thread which frees many more blocks than it allocates, or exits, hands its list over to
+// the others. Chunks are never given back to the system.
+template <size_t Size, size_t Align = alignof(std::max_align_t)>
+class BlockPool {
+public:
+    // At least that of the pointer linking free blocks.
+    static constexpr size_t kAlignment = std::max(Align, alignof(void*));
+    // Size rounded up to the alignment of the type only: on 64-bit targets a pair and its
+    // control block take 72 bytes instead of the 80 of a block aligned for anything.
+    static constexpr size_t kBlockSize =
+        (std::max(Size, sizeof(void*)) + kAlignment - 1) / kAlignment * kAlignment;
+
+    static void* Allocate() {
+        if (local.free == nullptr) {
+            Refill();
+        }
+        Block* block = local.free;
+        local.free = block->next;
+        --local.count;
+        return block;
+    }
+
+    static void Deallocate(void* pointer) {
+        auto* block = static_cast<Block*>(pointer);
+        block->next = local.free;
+        local.free = block;
+        if (++local.count >= kMaxLocal || local.exited) {
+            Release();
+        }
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    static constexpr size_t kChunkBlocks = 1024;
+    static constexpr size_t kMaxLocal = 64 * kChunkBlocks;
+
+    // Trivially destructible, so that blocks can still be freed while the thread exits.
+    struct Local {
+        Block* free = nullptr;
+        size_t count = 0;
+        bool exited = false;
+    };
+
+    struct Shared {
+        std::mutex mutex;
+        // Free lists given up by threads, with their lengths.
+        std::vector<std::pair<Block*, size_t>> lists;
+    };
+
+    struct Exit {
+        ~Exit() {
+            Release();
+            local.exited = true;
+        }
+    };
+
+    static void Refill() {
+        // Hands the free list over when the thread exits; blocks freed after that are handed
+        // over one by one.
+        thread_local Exit exit;
+        Shared& shared = GetShared();
+        {
+            std::lock_guard lock(shared.mutex);
+            if (!shared.lists.empty()) {
+                std::tie(local.free, local.count) = shared.lists.back();
+                shared.lists.pop_back();
+                return;
+            }
+        }
+        char* chunk = static_cast<char*>(::operator new(kBlockSize * kChunkBlocks));
+        for (size_t i = kChunkBlocks; i > 0; --i) {
+            auto* block = reinterpret_cast<Block*>(chunk + (i - 1) * kBlockSize);
+            block->next = local.free;
+            local.free = block;
+        }
+        local.count = kChunkBlocks;
+    }
+
+    static void Release() {
+        if (local.free == nullptr) {
+            return;
+        }
+        Shared& shared = GetShared();
+        std::lock_guard lock(shared.mutex);
+        shared.lists.emplace_back(local.free, local.count);
+        local.free = nullptr;
+        local.count = 0;
+    }
+
+    static Shared& GetShared() {
+        // Leaked: threads may release blocks while static objects are being destroyed.
+        static Shared* shared = new Shared;
+        return *shared;
+    }
+
+    static constinit inline thread_local Local local;
+};
+
+// Allocator serving single objects from a BlockPool, for std::allocate_shared: the object and
+// its control block then take one pool block.
+template <class T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>&) {
+    }
+
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+
+    T* allocate(size_t n) {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(BlockPool<sizeof(T), alignof(T)>::Allocate());
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        if (n != 1) {
+            ::operator delete(pointer);
+            return;
+        }
+        BlockPool<sizeof(T), alignof(T)>::Deallocate(pointer);
+    }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U>&) const {
+        return true;
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+class Object;
+
+// Destroys pairs whose last reference is dropped without recursion, and a bounded number of
+// them at a time. A pair being destroyed hands its car and cdr over here if they are pairs
+// nothing else references; those wait in a queue of the thread and are destroyed one after
+// another, so that neither long nor deeply nested lists grow the stack. With a budget, one
+// release destroys at most that many pairs and leaves the rest waiting: they are destroyed a
+// couple per pair allocated afterwards, or by Collect, e.g. when a server worker is idle.
+//
+// This bounds the pauses of reference counting; there is no tracing collector, so cycles
+// through closures and environments are still never freed.
+class Reclaimer {
+public:
+    // Drops object, destroying it and what only it references if it is the last reference to a
+    // pair.
+    static void Release(std::shared_ptr<Object>&& object);
+    // Destroys up to budget waiting pairs, all of them when zero; returns how many are left
+    // waiting.
+    static size_t Collect(size_t budget = 0);
+    // Called for every pair allocated.
+    static void Step() {
+        if (local.pending != 0 && !local.collecting) {
+            Collect(kStep);
+        }
+    }
+
+    // Pairs waiting, each with what only it references.
+    static size_t GetPending() {
+        return local.pending;
+    }
+    // Pairs one release on the calling thread destroys at most; zero, the default, is no limit.
+    static void SetBudget(size_t budget) {
+        local.budget = budget;
+    }
+    static size_t GetBudget() {
+        return local.budget;
+    }
+
+private:
+    static constexpr size_t kStep = 2;
+
+    // Trivially destructible, so that it can still be read while the thread exits.
+    struct Local {
+        size_t pending = 0;
+        size_t budget = 0;
+        bool collecting = false;
+        bool exited = false;
+    };
+
+    struct Queue;
+    static Queue& GetQueue();
+
+    static constinit thread_local Local local;
+};
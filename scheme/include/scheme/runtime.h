@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Hosts N isolated interpreters, one per worker thread. Every worker owns its own heap
+// (global scope, builtins and all objects created while evaluating), so no Ptr<Object> ever
+// crosses a thread boundary and shared_ptr refcounts stay uncontended. Expressions travel
+// between threads only as source text and results only as strings.
+//
+// Each worker has its own task deque: the owner pops from the back, idle workers steal from
+// the front of their neighbours' deques.
+class Runtime {
+public:
+    explicit Runtime(size_t workers_count = std::thread::hardware_concurrency());
+    Runtime(const Runtime&) = delete;
+    Runtime& operator=(const Runtime&) = delete;
+    ~Runtime();
+
+    // Evaluates expression in the global scope of one of the workers. Errors raised during
+    // evaluation (SyntaxError, RuntimeError, NameError) are rethrown from future::get.
+    std::future<std::string> Submit(std::string expression);
+
+    size_t WorkersCount() const {
+        return workers_.size();
+    }
+
+private:
+    struct Task {
+        std::string expression;
+        std::promise<std::string> promise;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void Loop(size_t index);
+    std::optional<Task> Pop(size_t index);
+    std::optional<Task> Steal(size_t thief);
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    size_t pending_ = 0;
+    bool stop_ = false;
+    std::atomic<size_t> next_worker_ = 0;
+};
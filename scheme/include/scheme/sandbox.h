@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "error.h"
+
+// Resources one Run may use; zero means unlimited.
+struct Limits {
+    // Applications evaluated and data read.
+    size_t steps = 0;
+    // Bytes of pairs, numbers, symbols and call frames allocated, whether freed since or not.
+    size_t heap = 0;
+    // Applications evaluated inside one another, and lists read inside one another.
+    size_t depth = 0;
+    // Wall clock time.
+    std::chrono::milliseconds time{0};
+    // Evaluation stops once another thread sets it; looked at as often as the deadline.
+    const std::atomic<bool>* interrupt = nullptr;
+
+    bool IsUnlimited() const {
+        return steps == 0 && heap == 0 && depth == 0 && time.count() == 0 && interrupt == nullptr;
+    }
+};
+
+// Enforces limits on what is evaluated by the thread which created it, for as long as it lives.
+// The evaluator and the reader call Step, Allocate and Enter at applications, data read and
+// allocations; they do nothing when no sandbox is installed. The worker threads of parallel
+// builtins install sandboxes of their own, see ForWorkers.
+class Sandbox {
+public:
+    explicit Sandbox(const Limits& limits);
+    Sandbox(const Sandbox&) = delete;
+    Sandbox& operator=(const Sandbox&) = delete;
+    ~Sandbox();
+
+    // Throws LimitError once the step budget is spent, the deadline has passed or evaluation is
+    // interrupted.
+    static void Step() {
+        if (current != nullptr) {
+            current->CountStep();
+        }
+    }
+    // Throws LimitError once the heap cap is reached.
+    static void Allocate(size_t bytes) {
+        if (current != nullptr) {
+            current->CountBytes(bytes);
+        }
+    }
+    // The limits of the worker threads a parallel builtin starts under the current sandbox: its
+    // deadline, interrupt and depth. Steps and heap are accounted for on the calling thread only.
+    static Limits ForWorkers();
+
+    // Accounts for one level of nesting while alive. A task may be suspended with it on its stack
+    // and finish under another sandbox (see Scheduler), which it then leaves alone.
+    class Depth {
+    public:
+        Depth() : sandbox_(current), serial_(current != nullptr ? current->serial_ : 0) {
+            if (sandbox_ != nullptr) {
+                ++sandbox_->depth_;
+            }
+        }
+        Depth(const Depth&) = delete;
+        Depth& operator=(const Depth&) = delete;
+        ~Depth() {
+            if (sandbox_ != nullptr && sandbox_ == current && sandbox_->serial_ == serial_) {
+                --sandbox_->depth_;
+            }
+        }
+        bool IsExceeded() const {
+            return sandbox_ != nullptr && sandbox_->limits_.depth != 0 &&
+                   sandbox_->depth_ > sandbox_->limits_.depth;
+        }
+        // Throws LimitError if the nesting is too deep, and RuntimeError if the stack of the
+        // thread has run past its bound (see StackBound).
+        void Check() const {
+            if (IsExceeded()) {
+                throw LimitError("Maximum depth exceeded");
+            }
+            auto frame = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+            if (frame < stack_bound) [[unlikely]] {
+                throw RuntimeError("Stack exhausted");
+            }
+        }
+
+    private:
+        Sandbox* sandbox_;
+        uint64_t serial_;
+    };
+
+    // Lowest address the stack of this thread may grow down to while alive; evaluation fails
+    // past it instead of overflowing a stack smaller than the thread's own (see Scheduler).
+    class StackBound {
+    public:
+        explicit StackBound(const void* bound) : outer_(stack_bound) {
+            stack_bound = reinterpret_cast<uintptr_t>(bound);
+        }
+        StackBound(const StackBound&) = delete;
+        StackBound& operator=(const StackBound&) = delete;
+        ~StackBound() {
+            stack_bound = outer_;
+        }
+
+    private:
+        uintptr_t outer_;
+    };
+
+private:
+    // The deadline and the interrupt are looked at once per this many steps.
+    static constexpr size_t kClockPeriod = 1024;
+
+    void CountStep();
+    void CountBytes(size_t bytes);
+
+    static constinit thread_local Sandbox* current;
+    static constinit thread_local uint64_t next_serial;
+    static constinit inline thread_local uintptr_t stack_bound = 0;
+
+    Limits limits_;
+    std::chrono::steady_clock::time_point deadline_;
+    size_t steps_ = 0;
+    size_t bytes_ = 0;
+    size_t depth_ = 0;
+    // Tells apart sandboxes created one after another at the same address.
+    uint64_t serial_;
+    Sandbox* previous_;
+};
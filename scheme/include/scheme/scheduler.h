@@ -0,0 +1,144 @@
+#pragma once
+
+#include <ucontext.h>
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "object.h"
+
+// A green thread: an expression scheduled for evaluation in the environment it was spawned in.
+class Task : public Object {
+public:
+    enum class State { PENDING, RUNNING, BLOCKED, DONE, FAILED };
+
+    Task(Ptr<Object> expression, Ptr<Environemnt> env);
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Task";
+    }
+    State GetState() const {
+        return state_;
+    }
+    bool IsFinished() const {
+        return state_ == State::DONE || state_ == State::FAILED;
+    }
+    void Run();
+    // Returns the value of the expression or rethrows the error it raised.
+    Ptr<Object> GetResult();
+    ~Task() override;
+
+private:
+    friend class Scheduler;
+    // The stack and the saved registers of a task which has started; see Scheduler.
+    struct Fiber;
+
+    Ptr<Object> expression_;
+    Ptr<Environemnt> env_;
+    Ptr<Object> result_;
+    std::exception_ptr error_;
+    State state_ = State::PENDING;
+    std::unique_ptr<Fiber> fiber_;
+    // Tasks blocked in await on this one.
+    std::vector<std::weak_ptr<Task>> waiters_;
+    // What channel-send handed to this task while it was blocked in channel-receive.
+    Ptr<Object> received_;
+    // Set when the scheduler is destroyed, to unwind the stack of the blocked task.
+    bool cancelled_ = false;
+};
+
+class Channel : public Object {
+public:
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Channel";
+    }
+    std::deque<Ptr<Object>>& GetValues() {
+        return values_;
+    }
+    ~Channel() override = default;
+
+private:
+    friend class Scheduler;
+
+    std::deque<Ptr<Object>> values_;
+    // Tasks blocked in channel-receive, oldest first; they get values before anyone else.
+    std::deque<std::weak_ptr<Task>> receivers_;
+};
+
+// Cooperative scheduler multiplexing tasks onto the interpreter thread. Once started a task runs
+// on a stack of its own until it finishes, yields or blocks in await/channel-receive; then it is
+// suspended and the scheduler goes on with the next ready task in FIFO order. A blocked task is
+// made ready again by whatever it waits for, so that any number of tasks may wait on one another
+// without nesting on the interpreter's stack. Code outside tasks which awaits or receives runs
+// ready tasks until its wait is over, and fails only when every task left is blocked.
+//
+// A pending task costs one small heap object; a started one also a stack, mapped lazily and reused
+// once the task finishes. Stacks are much smaller than the interpreter thread's, so that many
+// tasks can be started at once: a task which recurses past its stack fails with RuntimeError
+// instead of overflowing it.
+class Scheduler {
+public:
+    // Bytes of stack of a task, rounded up to whole pages, plus a guard page below them.
+    static constexpr size_t kDefaultStackSize = size_t{256} << 10;
+    static constexpr size_t kMinStackSize = size_t{64} << 10;
+
+    explicit Scheduler(size_t stack_size = kDefaultStackSize);
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    // Unwinds the stacks of the tasks which have not finished.
+    ~Scheduler();
+
+    Ptr<Task> Spawn(Ptr<Object> expression, Ptr<Environemnt> env);
+    // Runs the oldest ready task until it finishes, yields or blocks. Returns false if there is
+    // none.
+    bool RunOne();
+    size_t RunPending();
+    Ptr<Object> Await(const Ptr<Task>& task);
+    Ptr<Object> Receive(const Ptr<Channel>& channel);
+    void Send(const Ptr<Channel>& channel, Ptr<Object> value);
+    // Lets other tasks run: those ready before the calling task goes on, or the oldest ready one
+    // when called outside a task.
+    void Yield();
+    size_t PendingCount() const {
+        return ready_.size();
+    }
+    size_t BlockedCount() const {
+        return blocked_.size();
+    }
+    size_t GetStackSize() const {
+        return stack_size_;
+    }
+    // Applies to tasks started afterwards; at least kMinStackSize.
+    void SetStackSize(size_t stack_size);
+
+    // Binds spawn, await, yield, task-done?, make-channel, channel-send and channel-receive.
+    void Install(Environemnt* env);
+
+private:
+    static void Start();
+
+    void Resume(const Ptr<Task>& task);
+    // Switches from the running task back to the scheduler until it is resumed.
+    void Suspend();
+    // Suspends the running task until Wake is called on it.
+    void Block();
+    void Wake(const Ptr<Task>& task);
+    Ptr<Task> GetRunning() const;
+
+    std::deque<Ptr<Task>> ready_;
+    std::unordered_map<Task*, Ptr<Task>> blocked_;
+    // The task being run, if any.
+    Task* running_ = nullptr;
+    // Where the running task returns to.
+    ucontext_t context_;
+    size_t stack_size_ = 0;
+    // Stacks of finished tasks, kept for the next ones.
+    std::vector<void*> stacks_;
+};
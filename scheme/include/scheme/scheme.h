@@ -1,9 +1,22 @@
 #pragma once
 
+#include <istream>
 #include <string>
+#include <string_view>
 #include <map>
 #include <functional>
+#include <span>
+#include <vector>
+#include "binary.h"
+#include "hash_cons.h"
+#include "lazy.h"
 #include "object.h"
+#include "parallel_reader.h"
+#include "parse_cache.h"
+#include "sandbox.h"
+#include "scheduler.h"
+#include "text.h"
+#include "tokenizer.h"
 
 class Object;
 class Boolean;
@@ -11,15 +24,91 @@ class Number;
 
 
 
+// Outcome of one expression of a batch: what Run would return, or the message of the error it
+// would throw.
+struct BatchResult {
+    enum class Status { OK, SYNTAX_ERROR, RUNTIME_ERROR, NAME_ERROR, LIMIT_EXCEEDED };
+
+    Status status = Status::OK;
+    std::string value;
+    // Where the expression starts in its input; a form which failed to read starts where reading
+    // it began.
+    Position position = {};
+};
+
 class Interpreter {
 public:
     Interpreter() {
         global_scope_ = std::make_shared<Environemnt>();
         global_scope_->FullfillR5RS();
+        scheduler_.Install(global_scope_.get());
+        InstallBinary(global_scope_.get());
+        InstallLoadData(global_scope_.get());
+        InstallLoadAllData(global_scope_.get());
     }
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
 
     std::string Run(const std::string& s);
 
+    // Runs every expression like Run, back to back in the same global scope, and stores the
+    // outcome of expressions[i] in (*results)[i]. Errors are reported there instead of thrown,
+    // and results keeps its storage from batch to batch.
+    void RunBatch(std::span<const std::string_view> expressions, std::vector<BatchResult>* results);
+    // Runs every form of input in order, one result per form. Input can not be read past a form
+    // which failed to read, so such a failure is the last result.
+    void RunBatch(std::istream* input, std::vector<BatchResult>* results);
+    // RunBatch on a stream without keeping the results: each is handed to consume as soon as its
+    // form has run, and is only valid during the call.
+    void RunStream(std::istream* input, const std::function<void(const BatchResult&)>& consume);
+    // RunBatch on the contents of a file; false if it can not be opened.
+    bool RunFile(const std::string& path, std::vector<BatchResult>* results);
+
+    // Runs tasks spawned by previous calls to Run which nobody has awaited yet.
+    size_t RunPending() {
+        Sandbox sandbox{limits_};
+        return scheduler_.RunPending();
+    }
+
+    // Limits every following Run, RunPending and item of a batch; LimitError is thrown, or
+    // LIMIT_EXCEEDED reported, when one is reached.
+    void SetLimits(const Limits& limits) {
+        limits_ = limits;
+    }
+
+    const Ptr<Environemnt>& GetGlobalScope() const {
+        return global_scope_;
+    }
+    // Forms of the sources given to Run and to RunBatch as strings.
+    ParseCache& GetParseCache() {
+        return parse_cache_;
+    }
+    // Bytes of stack of each task spawned afterwards, see Scheduler.
+    void SetTaskStackSize(size_t bytes) {
+        scheduler_.SetStackSize(bytes);
+    }
+    // With hash-consing on, the quoted data of every form read afterwards is interned in the
+    // table of the interpreter (see hash_cons.h); off by default.
+    void SetHashConsing(bool enabled) {
+        hash_consing_ = enabled;
+    }
+    HashConsTable& GetHashConsTable() {
+        return hash_cons_;
+    }
+
 private:
+    static constexpr size_t kParseCacheCapacity = 256;
+
+    // Reads and optimizes the next form of tokenizer; caches it under source, the text the
+    // tokenizer reads, unless that is nullptr.
+    Result<Ptr<Object>> Compile(Tokenizer* tokenizer, const std::string_view* source);
+    // Evaluates the form compile returns; false if it could not be read.
+    bool Evaluate(const std::function<Result<Ptr<Object>>()>& compile, BatchResult* result);
+
+    Scheduler scheduler_;
     Ptr<Environemnt> global_scope_;
+    Limits limits_;
+    ParseCache parse_cache_{kParseCacheCapacity};
+    bool hash_consing_ = false;
+    HashConsTable hash_cons_;
 };
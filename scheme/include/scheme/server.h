@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "sandbox.h"
+#include "scheme.h"
+
+// Latencies counted in power-of-two buckets: bucket 0 holds those under a microsecond, bucket i
+// those from 2^(i-1) up to 2^i microseconds, and the last one everything longer. Recording is
+// lock free.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 32;
+
+    void Record(std::chrono::nanoseconds latency);
+
+    size_t GetCount() const;
+    std::array<size_t, kBuckets> GetBuckets() const;
+    // Upper bound of the bucket holding the q-quantile, q in [0, 1]; zero when nothing was
+    // recorded.
+    std::chrono::microseconds GetQuantile(double q) const;
+    // The count and the median, 90th and 99th percentiles, on one line.
+    std::string ToString() const;
+
+private:
+    std::array<std::atomic<size_t>, kBuckets> buckets_{};
+};
+
+// Evaluator daemon: keeps interpreters built and warm so that a request costs an evaluation,
+// not a process start and FullfillR5RS.
+//
+// Requests run on a fixed set of worker threads. A session, named by its client, gets an
+// interpreter of its own which lives on one worker, so that like in Runtime objects never cross
+// threads; requests of one session run in order, different sessions and requests without a
+// session run concurrently. A request without a session runs in a fresh interpreter which is
+// thrown away afterwards. Idle workers destroy garbage requests left behind, and build
+// interpreters ahead of need and run the prelude in them.
+//
+// Over a Unix socket every message is a frame: a 4-byte big-endian length, then that many
+// bytes. A request is a kind byte (ServerRequest), a byte with the length of the session name,
+// the name and, for EVAL, the source of one expression. A response is a status byte
+// (BatchResult::Status) and the result or error message. Connections are served concurrently,
+// the requests of one connection in order.
+enum class ServerRequest : uint8_t {
+    // Evaluates the expression, in the session if one is named.
+    EVAL,
+    // Latency statistics as text (see Server::GetStats).
+    STATS,
+    // Drops the session; the result is #t if it existed.
+    CLOSE,
+};
+
+struct ServerOptions {
+    size_t workers = std::thread::hardware_concurrency();
+    // Interpreters each worker keeps built ahead of need.
+    size_t warm_interpreters = 2;
+    // Source of the forms run in every interpreter before it is used.
+    std::string prelude = {};
+    // Limits of every request; the time limit keeps a runaway request from holding its worker
+    // and its session for good.
+    Limits limits = {.time = std::chrono::seconds(10)};
+    // Sessions not used for that long are dropped.
+    std::chrono::seconds session_timeout{600};
+    // Pairs a request destroys at most at once (see Reclaimer); the rest are destroyed while
+    // the worker is idle. Zero is no limit.
+    size_t release_budget = size_t{1} << 14;
+};
+
+class Server {
+public:
+    // Throws the error the prelude raises, if any.
+    explicit Server(ServerOptions options = {});
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+    // Stops serving and waits for requests in flight.
+    ~Server();
+
+    // Serves connections to a Unix socket at path, replacing a file there. Throws
+    // std::system_error if it can not be bound.
+    void Listen(const std::string& path);
+    // Closes the socket and every connection. Evaluations in flight are interrupted and answered
+    // with LIMIT_EXCEEDED, so that Stop does not wait on a request which never ends.
+    void Stop();
+
+    // Evaluates expression like a request over the socket would; an empty session is none.
+    std::future<BatchResult> Submit(std::string expression, std::string session = {});
+    // Drops the session once its submitted requests have run; true if it existed.
+    bool CloseSession(std::string session);
+
+    // From the moment a request was submitted to its result.
+    const LatencyHistogram& GetLatency() const {
+        return latency_;
+    }
+    // Evaluation alone, without waiting for a worker.
+    const LatencyHistogram& GetEvaluationLatency() const {
+        return evaluation_;
+    }
+    // Both histograms, one line each.
+    std::string GetStats() const;
+
+private:
+    struct Task {
+        std::string expression;
+        std::string session;
+        bool close = false;
+        std::chrono::steady_clock::time_point submitted;
+        std::promise<BatchResult> promise;
+    };
+
+    struct Session {
+        std::unique_ptr<Interpreter> interpreter;
+        std::chrono::steady_clock::time_point used;
+    };
+
+    // Everything but the queue belongs to the worker thread.
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Task> tasks;
+        std::unordered_map<std::string, Session> sessions;
+        std::vector<std::unique_ptr<Interpreter>> warm;
+        std::vector<BatchResult> results;
+        std::chrono::steady_clock::time_point swept;
+        std::thread thread;
+    };
+
+    struct Connection {
+        int fd;
+        std::atomic<bool> done = false;
+        std::thread thread;
+    };
+
+    std::unique_ptr<Interpreter> MakeInterpreter() const;
+    void Push(Worker* worker, Task task);
+    Worker* WorkerOf(const std::string& session);
+    void Loop(Worker* worker);
+    void Execute(Worker* worker, Task* task);
+    void Expire(Worker* worker);
+
+    void Accept();
+    // Joins and closes connections which have ended; connections_mutex_ is held.
+    void Reap();
+    void Serve(Connection* connection);
+
+    ServerOptions options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_ = 0;
+    std::atomic<bool> stop_ = false;
+    LatencyHistogram latency_;
+    LatencyHistogram evaluation_;
+
+    std::mutex connections_mutex_;
+    std::list<std::unique_ptr<Connection>> connections_;
+    std::atomic<bool> closing_ = false;
+    // Set by Stop while it waits for connections; every interpreter's limits point to it.
+    std::atomic<bool> interrupt_ = false;
+    int listener_ = -1;
+    std::string path_;
+    std::thread acceptor_;
+};
+
+// A connection to a Server, for one thread at a time. Throws std::system_error when the server
+// can not be reached or hangs up.
+class ServerClient {
+public:
+    explicit ServerClient(const std::string& path);
+    ServerClient(const ServerClient&) = delete;
+    ServerClient& operator=(const ServerClient&) = delete;
+    ~ServerClient();
+
+    BatchResult Eval(std::string_view expression, std::string_view session = {});
+    bool CloseSession(std::string_view session);
+    std::string GetStats();
+
+private:
+    BatchResult Call(ServerRequest kind, std::string_view session, std::string_view expression);
+
+    int fd_;
+};
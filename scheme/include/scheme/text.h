@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include "object.h"
+
+// Immutable string of bytes. Strings up to kInlineSize bytes are kept inside the object. Longer
+// ones are a slice of a buffer shared with every string cut from it, so substring never copies
+// more than an inline string. string-append of long strings makes a rope: a balanced tree of
+// the parts, built in O(log n) pairs per append, with short neighbouring leaves merged so that
+// appending a line at a time does not leave a leaf per line.
+class String : public Object {
+public:
+    static constexpr size_t kInlineSize = 22;
+    // Adjacent leaves are merged while the result fits in that many bytes.
+    static constexpr size_t kLeafSize = 256;
+
+    explicit String(std::string_view text);
+    // Takes over text without copying it when it is too long to be inline.
+    explicit String(std::string&& text);
+
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    // The literal: quoted, with ", \ and control characters escaped.
+    std::string ToString() override;
+
+    size_t GetSize() const {
+        return size_;
+    }
+    // The byte at index, which must be less than the size.
+    char At(size_t index) const;
+    // The bytes as one piece; copies them if the string is a rope.
+    std::string GetText() const;
+    void AppendTo(std::string* out) const;
+    // The bytes in place, unless the string is a rope.
+    std::optional<std::string_view> GetView() const;
+
+    // The bytes from begin to end, sharing storage with this string.
+    Ptr<String> Substring(size_t begin, size_t end) const;
+    static Ptr<String> Append(const Ptr<String>& left, const Ptr<String>& right);
+
+    // Negative, zero or positive as a sorts before, like or after b.
+    static int Compare(const String& a, const String& b);
+
+    ~String() override = default;
+
+private:
+    struct Inline {
+        std::array<char, kInlineSize> data;
+    };
+    struct Slice {
+        Ptr<const std::string> buffer;
+        std::string_view view;
+    };
+    struct Rope {
+        Ptr<String> left;
+        Ptr<String> right;
+    };
+
+    String(Slice slice);
+    String(Ptr<String> left, Ptr<String> right);
+
+    const Rope* GetRope() const {
+        return std::get_if<Rope>(&data_);
+    }
+    static int Height(const Ptr<String>& string) {
+        return string->height_;
+    }
+    static Ptr<String> Node(Ptr<String> left, Ptr<String> right);
+    // Node(left, right) for subtrees whose heights differ by at most two.
+    static Ptr<String> Balance(Ptr<String> left, Ptr<String> right);
+    // Concatenation of two non-empty strings.
+    static Ptr<String> Join(const Ptr<String>& left, const Ptr<String>& right);
+
+    std::variant<Inline, Slice, Rope> data_;
+    size_t size_;
+    // Zero for flat strings.
+    int height_ = 0;
+};
+
+Ptr<String> MakeString(std::string_view text);
+Ptr<String> MakeString(std::string&& text);
+
+// A string port: open-output-string makes one to write to, open-input-string one to read from.
+// Writes append to a growing buffer, so building text piece by piece is linear.
+class StringPort : public Object {
+public:
+    StringPort() = default;
+    // An input port reading source.
+    explicit StringPort(Ptr<String> source);
+
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "String Port";
+    }
+
+    bool IsInput() const {
+        return input_ != nullptr;
+    }
+    void Write(std::string_view text) {
+        output_ += text;
+    }
+    void Write(const String& text) {
+        text.AppendTo(&output_);
+    }
+    // What was written so far.
+    Ptr<String> GetOutput() const {
+        return MakeString(std::string_view(output_));
+    }
+    // The next line without its end, sharing storage with the source, or nullptr at the end.
+    Ptr<String> ReadLine();
+
+    ~StringPort() override = default;
+
+private:
+    std::string output_;
+    // Flat, so that lines can be cut from it.
+    Ptr<String> input_;
+    size_t position_ = 0;
+};
@@ -4,6 +4,8 @@
 #include <optional>
 #include <istream>
 #include <array>
+#include <string>
+#include <string_view>
 
 struct SymbolToken {
     std::string name;
@@ -34,7 +36,42 @@ struct ConstantToken {
     }
 };
 
-using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken>;
+// A string literal with its escapes (\", \\, \n, \t, \r) resolved. Input ending inside the
+// literal makes an unterminated token, which the parser rejects.
+struct StringToken {
+    std::string value;
+    bool terminated = true;
+
+    bool operator==(const StringToken& other) const = default;
+};
+
+// Input which makes no valid token: a character no token begins with, or an integer literal
+// which does not fit an int. The parser rejects it with message.
+struct InvalidToken {
+    std::string message;
+
+    bool operator==(const InvalidToken& other) const = default;
+};
+
+// A place in the input: line and column, both counted from 1, the column in bytes.
+struct Position {
+    size_t line = 1;
+    size_t column = 1;
+
+    bool operator==(const Position& other) const = default;
+};
+
+using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken,
+                           StringToken, InvalidToken>;
+
+// Lets an istream read strings in place, one after another.
+class ViewBuffer : public std::streambuf {
+public:
+    void Reset(std::string_view view) {
+        char* data = const_cast<char*>(view.data());
+        setg(data, data, data + view.size());
+    }
+};
 
 class Tokenizer {
 public:
@@ -48,6 +85,19 @@ public:
 
     void Next();
 
+    // Starts over from the current position of the stream, e.g. once it was given new input.
+    // Positions are counted from there.
+    void Reset() {
+        current_token_.reset();
+        position_ = Position();
+        Next();
+    }
+
+    // Where the current token starts, or where the input ends once there is none.
+    Position GetPosition() const {
+        return token_position_;
+    }
+
     Token GetToken() {
         return current_token_.value();
     }
@@ -62,9 +112,23 @@ private:
         }
         return false;
     }
+    // Takes the next character off the stream, keeping track of its position.
+    int Get() {
+        int c = s_->get();
+        if (c == '\n') {
+            ++position_.line;
+            position_.column = 1;
+        } else if (c != std::char_traits<char>::eof()) {
+            ++position_.column;
+        }
+        return c;
+    }
+
 private:
     std::istream* s_;
     std::optional<Token> current_token_;
+    Position position_;
+    Position token_position_;
     constexpr static std::array first_might_begin_ = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h',
                                                       'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
                                                       'q', 'r', 's', 't', 'u', 'v', 'w', 'x',
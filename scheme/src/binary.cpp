@@ -0,0 +1,253 @@
+#include "scheme/binary.h"
+#include "scheme/text.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace {
+using enum BinaryTag;
+
+char Put(BinaryTag tag) {
+    return static_cast<char>(tag);
+}
+
+void WriteVarint(uint64_t value, std::string* out) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+class Writer {
+public:
+    explicit Writer(std::string* out) : out_(out) {
+    }
+
+    void Write(const Ptr<Object>& datum) {
+        if (datum == nullptr) {
+            out_->push_back(Put(NIL));
+        } else if (auto* number = dynamic_cast<Number*>(datum.get())) {
+            out_->push_back(Put(FIXNUM));
+            int64_t value = number->GetValue();
+            WriteVarint(static_cast<uint64_t>((value << 1) ^ (value >> 63)), out_);
+        } else if (auto* boolean = dynamic_cast<Boolean*>(datum.get())) {
+            out_->push_back(Put(boolean->var_ ? TRUE : FALSE));
+        } else if (auto* symbol = dynamic_cast<Symbol*>(datum.get())) {
+            auto [it, inserted] = symbols_.emplace(symbol->GetName(), symbols_.size());
+            if (inserted) {
+                out_->push_back(Put(SYMBOL));
+                WriteVarint(symbol->GetName().size(), out_);
+                out_->append(symbol->GetName());
+            } else {
+                out_->push_back(Put(SYMBOL_REF));
+                WriteVarint(it->second, out_);
+            }
+        } else if (auto* string = dynamic_cast<String*>(datum.get())) {
+            out_->push_back(Put(STRING));
+            WriteVarint(string->GetSize(), out_);
+            string->AppendTo(out_);
+        } else if (Is<Cell>(datum)) {
+            WriteList(datum);
+        } else {
+            throw RuntimeError("Only data can be written in binary");
+        }
+    }
+
+private:
+    void WriteList(const Ptr<Object>& list) {
+        size_t count = 0;
+        Ptr<Object> cur = list;
+        for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+            ++count;
+        }
+        out_->push_back(Put(LIST));
+        WriteVarint(count, out_);
+        for (cur = list; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+            Write(As<Cell>(cur)->GetFirst());
+        }
+        Write(cur);
+    }
+
+    std::string* out_;
+    std::unordered_map<std::string, size_t> symbols_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {
+    }
+
+    Ptr<Object> Read() {
+        switch (static_cast<BinaryTag>(Next())) {
+            case NIL:
+                return nullptr;
+            case TRUE:
+                return MakeBoolean(true);
+            case FALSE:
+                return MakeBoolean(false);
+            case FIXNUM:
+                return MakeNumber(DecodeFixnum(ReadVarint(data_, &pos_)));
+            case SYMBOL: {
+                uint64_t size = ReadVarint(data_, &pos_);
+                if (size > data_.size() - pos_) {
+                    throw SyntaxError("Binary data ends inside a symbol");
+                }
+                symbols_.push_back(std::make_shared<Symbol>(std::string(data_.substr(pos_, size))));
+                pos_ += size;
+                return symbols_.back();
+            }
+            case SYMBOL_REF: {
+                uint64_t index = ReadVarint(data_, &pos_);
+                if (index >= symbols_.size()) {
+                    throw SyntaxError("Binary symbol reference out of range");
+                }
+                return symbols_[index];
+            }
+            case LIST:
+                return ReadList();
+            case STRING: {
+                uint64_t size = ReadVarint(data_, &pos_);
+                if (size > data_.size() - pos_) {
+                    throw SyntaxError("Binary data ends inside a string");
+                }
+                pos_ += size;
+                return MakeString(data_.substr(pos_ - size, size));
+            }
+            default:
+                throw SyntaxError("Unknown tag in binary data");
+        }
+    }
+
+    bool IsEnd() const {
+        return pos_ == data_.size();
+    }
+
+private:
+    Ptr<Object> ReadList() {
+        Sandbox::Depth depth;
+        depth.Check();
+        uint64_t count = ReadVarint(data_, &pos_);
+        // Every element takes at least a byte: a larger count can only be garbage.
+        if (count > data_.size() - pos_) {
+            throw SyntaxError("Binary list longer than its data");
+        }
+        Ptr<Object> root = nullptr;
+        Ptr<Cell> tail = nullptr;
+        for (uint64_t i = 0; i < count; ++i) {
+            auto cell = MakeCell(Read(), nullptr);
+            if (tail == nullptr) {
+                root = cell;
+            } else {
+                tail->GetSecond() = cell;
+            }
+            tail = cell;
+        }
+        Ptr<Object> last = Read();
+        if (tail == nullptr) {
+            return last;
+        }
+        tail->GetSecond() = std::move(last);
+        return root;
+    }
+
+    char Next() {
+        if (pos_ == data_.size()) {
+            throw SyntaxError("Binary data ends inside a datum");
+        }
+        return data_[pos_++];
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+    std::vector<Ptr<Object>> symbols_;
+};
+}  // namespace
+
+uint64_t ReadVarint(std::string_view data, size_t* pos) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos == data.size()) {
+            throw SyntaxError("Binary data ends inside a datum");
+        }
+        auto byte = static_cast<unsigned char>(data[(*pos)++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw SyntaxError("Binary varint too long");
+}
+
+int DecodeFixnum(uint64_t value) {
+    int64_t decoded = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    if (decoded < INT32_MIN || decoded > INT32_MAX) {
+        throw SyntaxError("Binary fixnum out of range");
+    }
+    return static_cast<int>(decoded);
+}
+
+void WriteBinary(const Ptr<Object>& datum, std::string* out) {
+    out->append(kBinaryMagic);
+    out->push_back(kBinaryVersion);
+    Writer(out).Write(datum);
+}
+
+Ptr<Object> ReadBinary(std::string_view data) {
+    if (data.size() <= kBinaryMagic.size() || data.substr(0, kBinaryMagic.size()) != kBinaryMagic ||
+        data[kBinaryMagic.size()] != kBinaryVersion) {
+        throw SyntaxError("Not binary data of this version");
+    }
+    Reader reader(data.substr(kBinaryMagic.size() + 1));
+    Ptr<Object> datum = reader.Read();
+    if (!reader.IsEnd()) {
+        throw SyntaxError("Trailing bytes after binary datum");
+    }
+    return datum;
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw RuntimeError("Can not open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw RuntimeError("Can not open " + path);
+    }
+    size_ = info.st_size;
+    if (size_ != 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw RuntimeError("Can not map " + path);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void InstallBinary(Environemnt* env) {
+    env->Define("write-binary", std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            std::string data;
+            WriteBinary(args.front(), &data);
+            return std::make_shared<Bytes>(std::move(data));
+        }, false, Arity::Exactly("write-binary", 1)));
+    env->Define("read-binary", std::make_shared<Procedure<Bytes>>(
+        [](const std::vector<Ptr<Bytes>>& args) {
+            return ReadBinary(args.front()->GetData());
+        }, false, Arity::Exactly("read-binary", 1)));
+}
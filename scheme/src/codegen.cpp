@@ -0,0 +1,566 @@
+#include "scheme/codegen.h"
+#include "scheme/parser.h"
+#include "scheme/scheme.h"
+
+#include <map>
+#include <set>
+
+namespace {
+// Thrown for a form the translator does not handle: the top-level form containing it is
+// interpreted instead.
+struct Untranslatable {};
+
+struct FixnumBuiltin {
+    const char* name;
+    const char* op;
+    bool comparison;
+};
+
+const FixnumBuiltin kFixnumBuiltins[] = {
+    {"+", "ADD", false},   {"-", "SUB", false},         {"*", "MUL", false},
+    {"=", "EQUAL", true},  {"<", "LESS", true},         {">", "GREATER", true},
+    {"<=", "LESS_EQUAL", true}, {">=", "GREATER_EQUAL", true}};
+
+std::string Quote(const std::string& str) {
+    std::string res = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        } else if (c == '\n') {
+            res += "\\n";
+        } else {
+            res += c;
+        }
+    }
+    return res + '"';
+}
+
+std::vector<Ptr<Object>> ListToVector(const Ptr<Object>& list) {
+    std::vector<Ptr<Object>> res;
+    Ptr<Object> cur = list;
+    for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        res.push_back(As<Cell>(cur)->GetFirst());
+    }
+    if (cur != nullptr) {
+        throw Untranslatable{};
+    }
+    return res;
+}
+
+const std::string* HeadName(const Ptr<Object>& ast) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr || !Is<Symbol>(cell->GetFirst())) {
+        return nullptr;
+    }
+    return &As<Symbol>(cell->GetFirst())->GetName();
+}
+
+// Names given to define and set! anywhere in ast.
+void CollectTargets(const Ptr<Object>& ast, std::map<std::string, int>* defines,
+                    std::set<std::string>* sets) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        return;
+    }
+    const std::string* head = HeadName(cell);
+    auto args = std::dynamic_pointer_cast<Cell>(cell->GetSecond());
+    if (head != nullptr && args != nullptr && (*head == "define" || *head == "set!")) {
+        Ptr<Object> target = args->GetFirst();
+        if (Is<Cell>(target)) {
+            target = As<Cell>(target)->GetFirst();
+        }
+        if (Is<Symbol>(target)) {
+            const std::string& name = As<Symbol>(target)->GetName();
+            *head == "define" ? ++(*defines)[name] : (sets->insert(name), 0);
+        }
+    }
+    Ptr<Object> cur = cell;
+    for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        CollectTargets(As<Cell>(cur)->GetFirst(), defines, sets);
+    }
+}
+
+class Generator {
+public:
+    Generator() : env_(interpreter_.GetGlobalScope()) {
+    }
+
+    Translation Translate(const std::vector<Ptr<Object>>& forms, const std::string& name) {
+        for (const Ptr<Object>& form : forms) {
+            CollectTargets(form, &defines_, &sets_);
+        }
+        Translation res;
+        std::string functions;
+        std::string table;
+        for (size_t i = 0; i < forms.size(); ++i) {
+            std::string source = Object::ToString(forms[i]);
+            try {
+                scopes_.clear();
+                std::string body = TopLevel(forms[i]);
+                std::string function = "Form" + std::to_string(i);
+                functions += "// " + source.substr(0, 100) + "\n";
+                functions += "Ptr<Object> " + function + "() {\n" + body + "}\n\n";
+                table += "        {" + function + ", nullptr},\n";
+                ++res.translated;
+            } catch (const Untranslatable&) {
+                table += "        {nullptr, " + Quote(source) + "},\n";
+                ++res.interpreted;
+            }
+        }
+
+        res.code = "// Translated by schemec from " + name + ".\n";
+        res.code += "#include <scheme/compiled.h>\n\nnamespace {\n";
+        res.code += "compiled::Program program;\n\n";
+        res.code += declarations_ + "\n" + functions;
+        res.code += "}  // namespace\n\nint main() {\n    return program.Main({\n" + table;
+        res.code += "    });\n}\n";
+        return res;
+    }
+
+private:
+    struct Variable {
+        std::string name;
+        std::string cpp;
+        bool boxed;
+    };
+
+    // A procedure whose self calls in tail position jump back to its start.
+    struct Loop {
+        std::string name;
+        std::vector<Variable> params;
+    };
+
+    std::string TopLevel(const Ptr<Object>& form) {
+        const std::string* head = HeadName(form);
+        if (head == nullptr || *head != "define" || !IsSpecial(*head)) {
+            return "    return " + Expr(form) + ";\n";
+        }
+        std::vector<Ptr<Object>> args = ListToVector(As<Cell>(form)->GetSecond());
+        if (args.size() < 2) {
+            throw Untranslatable{};
+        }
+        std::string value;
+        if (auto target = std::dynamic_pointer_cast<Cell>(args[0])) {
+            // (define (name params...) body...)
+            if (!Is<Symbol>(target->GetFirst())) {
+                throw Untranslatable{};
+            }
+            const std::string& name = As<Symbol>(target->GetFirst())->GetName();
+            value = Lambda(target->GetSecond(), As<Cell>(As<Cell>(form)->GetSecond())->GetSecond(),
+                           LoopName(name));
+            return "    program.Define(" + Quote(name) + ", " + value + ");\n    return nullptr;\n";
+        }
+        if (!Is<Symbol>(args[0]) || args.size() != 2) {
+            throw Untranslatable{};
+        }
+        const std::string& name = As<Symbol>(args[0])->GetName();
+        const std::string* value_head = HeadName(args[1]);
+        if (value_head != nullptr && *value_head == "lambda" && IsSpecial(*value_head)) {
+            auto lambda = As<Cell>(As<Cell>(args[1])->GetSecond());
+            value = Lambda(lambda->GetFirst(), lambda->GetSecond(), LoopName(name));
+        } else {
+            value = Expr(args[1]);
+        }
+        return "    program.Define(" + Quote(name) + ", " + value + ");\n    return nullptr;\n";
+    }
+
+    // Self calls of a global procedure may loop if nothing else ever binds its name.
+    std::string LoopName(const std::string& name) {
+        return defines_[name] == 1 && sets_.count(name) == 0 ? name : "";
+    }
+
+    std::string Expr(const Ptr<Object>& ast) {
+        if (ast == nullptr) {
+            return "compiled::EvalEmpty()";
+        }
+        if (Is<Number>(ast) || Is<String>(ast)) {
+            return Constant(ast);
+        }
+        if (auto symbol = std::dynamic_pointer_cast<Symbol>(ast)) {
+            if (const Variable* var = FindLocal(symbol->GetName())) {
+                return var->boxed ? "compiled::Get(" + var->cpp + ")" : var->cpp;
+            }
+            return GlobalRef(symbol->GetName()) + ".Get()";
+        }
+        auto cell = std::dynamic_pointer_cast<Cell>(ast);
+        if (cell == nullptr) {
+            throw Untranslatable{};
+        }
+        if (const std::string* head = HeadName(cell); head != nullptr && FindLocal(*head) == nullptr) {
+            if (IsSpecial(*head)) {
+                return SpecialForm(*head, ListToVector(cell->GetSecond()), cell);
+            }
+            if (IsSyntaxName(*head)) {
+                throw Untranslatable{};
+            }
+            if (IsDirectBuiltin(*head)) {
+                return BuiltinCall(*head, ListToVector(cell->GetSecond()));
+            }
+        }
+        return "compiled::Call(" + Application(cell) + ")";
+    }
+
+    // Whether Expr translates ast into compiled::Call.
+    bool IsCall(const Ptr<Object>& ast) {
+        auto cell = std::dynamic_pointer_cast<Cell>(ast);
+        if (cell == nullptr) {
+            return false;
+        }
+        const std::string* head = HeadName(cell);
+        return head == nullptr || FindLocal(*head) != nullptr ||
+               !(IsSpecial(*head) || IsSyntaxName(*head) || IsDirectBuiltin(*head));
+    }
+
+    std::string Application(const Ptr<Cell>& cell) {
+        return "{compiled::Callee(" + Expr(cell->GetFirst()) + "), {" +
+               Join(ListToVector(cell->GetSecond())) + "}}";
+    }
+
+    // A call in tail position is left to the closure which returns it.
+    std::string TailExpr(const Ptr<Object>& ast) {
+        if (IsCall(ast)) {
+            return "compiled::DeferCall(" + Application(As<Cell>(ast)) + ")";
+        }
+        return Expr(ast);
+    }
+
+    std::string Join(const std::vector<Ptr<Object>>& args) {
+        std::string res;
+        for (size_t i = 0; i < args.size(); ++i) {
+            res += (i == 0 ? "" : ", ") + Expr(args[i]);
+        }
+        return res;
+    }
+
+    std::string BuiltinCall(const std::string& name, const std::vector<Ptr<Object>>& args) {
+        std::string builtin = Builtin(name);
+        for (const FixnumBuiltin& fixnum : kFixnumBuiltins) {
+            if (name == fixnum.name && args.size() == 2) {
+                return std::string("compiled::") + (fixnum.comparison ? "Compare" : "Arithmetic") +
+                       "(compiled::Fixnum::" + fixnum.op + ", {" + Join(args) + "}, " + builtin +
+                       ")";
+            }
+        }
+        if ((name == "car" || name == "cdr") && args.size() == 1) {
+            return std::string("compiled::") + (name == "car" ? "Car(" : "Cdr(") + Expr(args[0]) +
+                   ", " + builtin + ")";
+        }
+        return builtin + "->Apply({" + Join(args) + "})";
+    }
+
+    // A condition as a C++ bool.
+    std::string Condition(const Ptr<Object>& ast) {
+        const std::string* head = HeadName(ast);
+        if (head != nullptr && FindLocal(*head) == nullptr && IsDirectBuiltin(*head)) {
+            std::vector<Ptr<Object>> args = ListToVector(As<Cell>(ast)->GetSecond());
+            for (const FixnumBuiltin& fixnum : kFixnumBuiltins) {
+                if (*head == fixnum.name && fixnum.comparison && args.size() == 2) {
+                    return std::string("compiled::Test(compiled::Fixnum::") + fixnum.op + ", {" +
+                           Join(args) + "}, " + Builtin(*head) + ")";
+                }
+            }
+        }
+        return "compiled::IsTrue(" + Expr(ast) + ")";
+    }
+
+    std::string SpecialForm(const std::string& name, const std::vector<Ptr<Object>>& args,
+                            const Ptr<Cell>& cell) {
+        if (name == "quote" && args.size() == 1) {
+            return args[0] == nullptr ? "Ptr<Object>()" : Constant(args[0]);
+        }
+        if (name == "if" && (args.size() == 2 || args.size() == 3)) {
+            return "(" + Condition(args[0]) + " ? " + Expr(args[1]) + " : " +
+                   (args.size() == 3 ? Expr(args[2]) : "Ptr<Object>()") + ")";
+        }
+        if (name == "lambda" && args.size() >= 2) {
+            auto lambda = As<Cell>(cell->GetSecond());
+            return Lambda(lambda->GetFirst(), lambda->GetSecond(), "");
+        }
+        if (name == "let" && args.size() >= 2) {
+            return "[&]() -> Ptr<Object> {\n" + Let(As<Cell>(cell->GetSecond()), nullptr) + "}()";
+        }
+        if (name == "set!" && args.size() == 2 && Is<Symbol>(args[0])) {
+            const std::string& target = As<Symbol>(args[0])->GetName();
+            std::string value = Expr(args[1]);
+            if (const Variable* var = FindLocal(target)) {
+                return "compiled::Set(" + var->cpp + ", " + value + ")";
+            }
+            return GlobalRef(target) + ".Set(" + value + ")";
+        }
+        if (name == "and") {
+            std::string res = "[&]() -> Ptr<Object> {\n        Ptr<Object> value;\n";
+            for (const Ptr<Object>& arg : args) {
+                res += "        value = " + Expr(arg) + ";\n";
+                res += "        if (!compiled::IsTrue(value)) {\n";
+                res += "            return MakeBoolean(false);\n        }\n";
+            }
+            // The builtin evaluates the last argument once more for the result.
+            res += "        return " +
+                   (args.empty() ? "MakeBoolean(true)" : Expr(args.back())) + ";\n";
+            return res + "    }()";
+        }
+        if (name == "or") {
+            std::string res = "[&]() -> Ptr<Object> {\n        Ptr<Object> value;\n";
+            for (const Ptr<Object>& arg : args) {
+                res += "        value = " + Expr(arg) + ";\n";
+                res += "        if (!Is<Boolean>(value)) {\n";
+                res += "            return compiled::Reevaluate(value, &program);\n        }\n";
+                res += "        if (As<Boolean>(value)->var_) {\n";
+                res += "            return MakeBoolean(true);\n        }\n";
+            }
+            return res + "        return MakeBoolean(false);\n    }()";
+        }
+        throw Untranslatable{};
+    }
+
+    std::string Lambda(const Ptr<Object>& params, const Ptr<Object>& body,
+                       const std::string& loop_name) {
+        std::vector<Ptr<Object>> names = ListToVector(params);
+        std::vector<Ptr<Object>> forms = ListToVector(body);
+        if (forms.empty()) {
+            throw Untranslatable{};
+        }
+        scopes_.emplace_back();
+        std::string res = "compiled::MakeClosure(" + std::to_string(names.size()) +
+                          ", [=](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {\n";
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (!Is<Symbol>(names[i])) {
+                throw Untranslatable{};
+            }
+            res += Declare(As<Symbol>(names[i])->GetName(), forms, "args[" + std::to_string(i) + "]");
+        }
+        if (loop_name.empty()) {
+            res += Body(forms, nullptr);
+        } else {
+            Loop loop{loop_name, scopes_.back()};
+            res += "    while (true) {\n" + Body(forms, &loop) + "    }\n";
+        }
+        scopes_.pop_back();
+        return res + "})";
+    }
+
+    // (let ((name value)...) body...) as statements, in a new scope.
+    std::string Let(const Ptr<Cell>& args, const Loop* loop) {
+        std::vector<Ptr<Object>> bindings = ListToVector(args->GetFirst());
+        std::vector<Ptr<Object>> forms = ListToVector(args->GetSecond());
+        if (forms.empty()) {
+            throw Untranslatable{};
+        }
+        std::vector<std::pair<std::string, std::string>> values;
+        for (const Ptr<Object>& binding : bindings) {
+            std::vector<Ptr<Object>> pair = ListToVector(binding);
+            if (pair.size() != 2 || !Is<Symbol>(pair[0])) {
+                throw Untranslatable{};
+            }
+            values.emplace_back(As<Symbol>(pair[0])->GetName(), Expr(pair[1]));
+        }
+        scopes_.emplace_back();
+        std::string res;
+        for (const auto& [name, value] : values) {
+            res += Declare(name, forms, value);
+        }
+        res += Body(forms, loop);
+        scopes_.pop_back();
+        return res;
+    }
+
+    // Statements running a body, whose last form returns (or loops).
+    std::string Body(const std::vector<Ptr<Object>>& forms, const Loop* loop) {
+        std::string res;
+        std::vector<std::string> defined;
+        for (const Ptr<Object>& form : forms) {
+            const std::string* head = HeadName(form);
+            if (head == nullptr || *head != "define" || !IsSpecial(*head)) {
+                continue;
+            }
+            std::vector<Ptr<Object>> args = ListToVector(As<Cell>(form)->GetSecond());
+            if (args.empty()) {
+                throw Untranslatable{};
+            }
+            Ptr<Object> target = Is<Cell>(args[0]) ? As<Cell>(args[0])->GetFirst() : args[0];
+            if (!Is<Symbol>(target)) {
+                throw Untranslatable{};
+            }
+            const std::string& name = As<Symbol>(target)->GetName();
+            // A define of a parameter assigns it instead.
+            for (const Variable& var : scopes_.back()) {
+                if (var.name == name) {
+                    throw Untranslatable{};
+                }
+            }
+            std::string cpp = NewName();
+            scopes_.back().push_back({name, cpp, true});
+            res += "    compiled::Box " + cpp + " = compiled::MakeUndefinedBox();\n";
+        }
+        for (size_t i = 0; i < forms.size(); ++i) {
+            const std::string* head = HeadName(forms[i]);
+            bool last = i + 1 == forms.size();
+            if (head != nullptr && *head == "define" && IsSpecial(*head)) {
+                res += "    " + InternalDefine(As<Cell>(forms[i])) + ";\n";
+                if (last) {
+                    res += "    return nullptr;\n";
+                }
+            } else if (last) {
+                res += Tail(forms[i], loop);
+            } else {
+                res += "    " + Expr(forms[i]) + ";\n";
+            }
+        }
+        return res;
+    }
+
+    std::string InternalDefine(const Ptr<Cell>& form) {
+        auto args = As<Cell>(form->GetSecond());
+        if (auto target = std::dynamic_pointer_cast<Cell>(args->GetFirst())) {
+            const Variable* var = FindLocal(As<Symbol>(target->GetFirst())->GetName());
+            return "compiled::Set(" + var->cpp + ", " +
+                   Lambda(target->GetSecond(), args->GetSecond(), "") + ")";
+        }
+        std::vector<Ptr<Object>> rest = ListToVector(args->GetSecond());
+        if (rest.size() != 1) {
+            throw Untranslatable{};
+        }
+        const Variable* var = FindLocal(As<Symbol>(args->GetFirst())->GetName());
+        return "compiled::Set(" + var->cpp + ", " + Expr(rest[0]) + ")";
+    }
+
+    // Statements for a form in tail position.
+    std::string Tail(const Ptr<Object>& ast, const Loop* loop) {
+        const std::string* head = HeadName(ast);
+        if (head == nullptr || FindLocal(*head) != nullptr) {
+            return "    return " + TailExpr(ast) + ";\n";
+        }
+        std::vector<Ptr<Object>> args = ListToVector(As<Cell>(ast)->GetSecond());
+        if (*head == "if" && IsSpecial(*head) && (args.size() == 2 || args.size() == 3)) {
+            std::string res = "    if (" + Condition(args[0]) + ") {\n" + Tail(args[1], loop);
+            res += "    } else {\n";
+            res += args.size() == 3 ? Tail(args[2], loop) : "    return nullptr;\n";
+            return res + "    }\n";
+        }
+        if (*head == "let" && IsSpecial(*head) && args.size() >= 2) {
+            return "    {\n" + Let(As<Cell>(As<Cell>(ast)->GetSecond()), loop) + "    }\n";
+        }
+        if (loop != nullptr && *head == loop->name && args.size() == loop->params.size()) {
+            std::string res = "    {\n";
+            for (size_t i = 0; i < args.size(); ++i) {
+                res += "        Ptr<Object> next" + std::to_string(i) + " = " + Expr(args[i]) + ";\n";
+            }
+            for (size_t i = 0; i < args.size(); ++i) {
+                const Variable& param = loop->params[i];
+                std::string next = "std::move(next" + std::to_string(i) + ")";
+                res += "        " + param.cpp + " = " +
+                       (param.boxed ? "compiled::MakeBox(" + next + ")" : next) + ";\n";
+            }
+            return res + "        continue;\n    }\n";
+        }
+        return "    return " + TailExpr(ast) + ";\n";
+    }
+
+    // Declares a local initialized with value; it is boxed if body assigns it.
+    std::string Declare(const std::string& name, const std::vector<Ptr<Object>>& body,
+                        const std::string& value) {
+        std::map<std::string, int> defines;
+        std::set<std::string> sets;
+        for (const Ptr<Object>& form : body) {
+            CollectTargets(form, &defines, &sets);
+        }
+        bool boxed = sets.count(name) > 0;
+        std::string cpp = NewName();
+        scopes_.back().push_back({name, cpp, boxed});
+        if (boxed) {
+            return "    compiled::Box " + cpp + " = compiled::MakeBox(" + value + ");\n";
+        }
+        return "    Ptr<Object> " + cpp + " = " + value + ";\n";
+    }
+
+    const Variable* FindLocal(const std::string& name) const {
+        for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+            for (auto var = scope->rbegin(); var != scope->rend(); ++var) {
+                if (var->name == name) {
+                    return &*var;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    bool IsSyntaxName(const std::string& name) {
+        Binding* binding = env_->Lookup(name);
+        return binding != nullptr && Is<Syntax>(binding->value);
+    }
+
+    // A special form the translator knows, not rebound anywhere in the program.
+    bool IsSpecial(const std::string& name) {
+        static const std::set<std::string> kSpecial = {"quote", "if",  "lambda", "let",
+                                                       "define", "set!", "and",   "or"};
+        return kSpecial.count(name) > 0 && IsSyntaxName(name) && !IsRebound(name);
+    }
+
+    bool IsDirectBuiltin(const std::string& name) {
+        Ptr<Object> builtin = env_->GetBuiltin(name);
+        return Is<Callable>(builtin) && !Is<Syntax>(builtin) && !IsRebound(name);
+    }
+
+    bool IsRebound(const std::string& name) {
+        return defines_.count(name) > 0 || sets_.count(name) > 0;
+    }
+
+    std::string NewName() {
+        return "v" + std::to_string(next_local_++);
+    }
+
+    // Numbers and symbols are shared. Every literal pair or string is an object of its own, as
+    // when read by the interpreter, so that eq? tells them apart.
+    std::string Constant(const Ptr<Object>& datum) {
+        std::string source = Object::ToString(datum);
+        if (Is<Number>(datum) || Is<Symbol>(datum)) {
+            if (auto it = constants_.find(source); it != constants_.end()) {
+                return it->second;
+            }
+        }
+        std::string name = "k" + std::to_string(next_constant_++);
+        constants_.emplace(source, name);
+        declarations_ += "const Ptr<Object> " + name + " = program.Datum(" + Quote(source) + ");\n";
+        return name;
+    }
+
+    std::string GlobalRef(const std::string& name) {
+        auto [it, inserted] = globals_.emplace(name, "g" + std::to_string(globals_.size()));
+        if (inserted) {
+            declarations_ += "compiled::Global " + it->second + "{&program, " + Quote(name) + "};\n";
+        }
+        return it->second;
+    }
+
+    std::string Builtin(const std::string& name) {
+        auto [it, inserted] = builtins_.emplace(name, "b" + std::to_string(builtins_.size()));
+        if (inserted) {
+            declarations_ += "Callable* const " + it->second + " = program.Builtin(" +
+                             Quote(name) + ");\n";
+        }
+        return it->second;
+    }
+
+    Interpreter interpreter_;
+    Ptr<Environemnt> env_;
+    std::map<std::string, int> defines_;
+    std::set<std::string> sets_;
+    std::vector<std::vector<Variable>> scopes_;
+    size_t next_local_ = 0;
+    size_t next_constant_ = 0;
+    std::map<std::string, std::string> constants_;
+    std::map<std::string, std::string> globals_;
+    std::map<std::string, std::string> builtins_;
+    std::string declarations_;
+};
+}  // namespace
+
+Translation TranslateToCpp(std::istream* source, const std::string& name) {
+    Tokenizer tokenizer{source};
+    std::vector<Ptr<Object>> forms;
+    while (!tokenizer.IsEnd()) {
+        forms.push_back(Read(&tokenizer));
+    }
+    return Generator().Translate(forms, name);
+}
@@ -0,0 +1,121 @@
+#include "scheme/compiled.h"
+#include "scheme/error.h"
+#include "scheme/parser.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace compiled {
+
+int Program::Main(const std::vector<Form>& forms) {
+    for (const Form& form : forms) {
+        try {
+            if (form.function != nullptr) {
+                std::cout << Object::ToString(form.function()) << std::endl;
+            } else {
+                std::cout << interpreter_.Run(form.source) << std::endl;
+            }
+            interpreter_.RunPending();
+        } catch (RuntimeError& e) {
+            std::cerr << e.what() << std::endl;
+        } catch (NameError& e) {
+            std::cerr << e.what() << std::endl;
+        } catch (SyntaxError& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    return 0;
+}
+
+Ptr<Object> Program::Datum(const std::string& datum) {
+    std::stringstream ss{datum};
+    Tokenizer tokenizer{&ss};
+    return ReadDatum(&tokenizer);
+}
+
+Callable* Program::Builtin(const std::string& name) {
+    return As<Callable>(GetGlobalScope()->GetBuiltin(name)).get();
+}
+
+Ptr<Object> Global::Set(Ptr<Object> value) {
+    Binding* binding = program_->GetGlobalScope()->Lookup(name_);
+    if (binding == nullptr) {
+        throw RuntimeError("set! of an undefined variable");
+    }
+    binding->value = std::move(value);
+    program_->GetGlobalScope()->Touch();
+    return nullptr;
+}
+
+Binding* Global::Resolve() {
+    if (binding_ != nullptr) {
+        return binding_;
+    }
+    Binding* binding = program_->GetGlobalScope()->Lookup(name_);
+    if (binding == nullptr) {
+        throw RuntimeError("No defined entity in our current environment");
+    }
+    if (!ParallelSection::IsActive()) {
+        binding_ = binding;
+    }
+    return binding;
+}
+
+const Ptr<Object>& Get(const Box& box) {
+    if (!box->defined) {
+        throw RuntimeError("No defined entity in our current environment");
+    }
+    return box->value;
+}
+
+Ptr<Object> Call(const Application& application) {
+    return As<Callable>(application.callee)->Apply(application.args);
+}
+
+Ptr<Object> Reevaluate(const Ptr<Object>& value, Program* program) {
+    return Object::Eval(value, program->GetGlobalScope());
+}
+
+Ptr<Object> EvalEmpty() {
+    throw RuntimeError("Empty list can not be evaluated");
+}
+
+Ptr<Object> Closure::Call(Ptr<Object> ast, Ptr<Environemnt> env) {
+    ScratchVector<Object> args;
+    for (Ptr<Object> cur = ast; cur != nullptr;) {
+        auto* cell = dynamic_cast<Cell*>(cur.get());
+        if (cell == nullptr) {
+            args->push_back(Object::Eval(cur, env));
+            break;
+        }
+        args->push_back(Object::Eval(cell->GetFirst(), env));
+        cur = cell->GetSecond();
+    }
+    return Apply(*args);
+}
+
+Ptr<Object> DeferCall(Application application) {
+    if (Is<Closure>(application.callee)) {
+        return std::make_shared<DeferredCall>(std::move(application));
+    }
+    return Call(application);
+}
+
+Ptr<Object> Closure::Apply(const std::vector<Ptr<Object>>& args) {
+    if (args.size() != arity_) {
+        throw RuntimeError("Wrong number of arguments");
+    }
+    Ptr<Object> res = function_(args);
+    while (auto* deferred = dynamic_cast<DeferredCall*>(res.get())) {
+        // Keeps the callee and the arguments alive while the result replaces them.
+        Application next = std::move(deferred->GetApplication());
+        auto* closure = As<Closure>(next.callee).get();
+        if (next.args.size() != closure->arity_) {
+            throw RuntimeError("Wrong number of arguments");
+        }
+        res = closure->function_(next.args);
+    }
+    return res;
+}
+
+}  // namespace compiled
@@ -0,0 +1,104 @@
+#include "scheme/equality.h"
+#include "scheme/hash_cons.h"
+#include "scheme/text.h"
+
+#include <unordered_set>
+#include <utility>
+
+namespace {
+struct PairHash {
+    size_t operator()(const std::pair<const Object*, const Object*>& key) const {
+        size_t first = std::hash<const Object*>{}(key.first);
+        return first ^ (std::hash<const Object*>{}(key.second) + 0x9e3779b9 + (first << 6) +
+                        (first >> 2));
+    }
+};
+
+// eqv?, or strings with the same bytes.
+bool IsEqualAtom(const Ptr<Object>& a, const Ptr<Object>& b) {
+    auto* string = dynamic_cast<String*>(a.get());
+    auto* other = dynamic_cast<String*>(b.get());
+    if (string != nullptr && other != nullptr) {
+        return string->GetSize() == other->GetSize() && String::Compare(*string, *other) == 0;
+    }
+    return IsEqv(a, b);
+}
+
+Ptr<Object> EqualityPredicate(bool (*predicate)(const Ptr<Object>&, const Ptr<Object>&),
+                              const char* name) {
+    return std::make_shared<Procedure<Object>>(
+        [predicate, name](const std::vector<Ptr<Object>>& args) {
+            return MakeBoolean(predicate(args[0], args[1]));
+        }, true, Arity::Exactly(name, 2));
+}
+}  // namespace
+
+bool IsEq(const Ptr<Object>& a, const Ptr<Object>& b) {
+    if (a == b) {
+        return true;
+    }
+    if (auto* symbol = dynamic_cast<Symbol*>(a.get())) {
+        auto* other = dynamic_cast<Symbol*>(b.get());
+        return other != nullptr && symbol->GetName() == other->GetName();
+    }
+    if (auto* boolean = dynamic_cast<Boolean*>(a.get())) {
+        auto* other = dynamic_cast<Boolean*>(b.get());
+        return other != nullptr && boolean->var_ == other->var_;
+    }
+    return false;
+}
+
+bool IsEqv(const Ptr<Object>& a, const Ptr<Object>& b) {
+    if (auto* number = dynamic_cast<Number*>(a.get())) {
+        auto* other = dynamic_cast<Number*>(b.get());
+        return other != nullptr && number->GetValue() == other->GetValue();
+    }
+    return IsEq(a, b);
+}
+
+bool IsEqual(const Ptr<Object>& a, const Ptr<Object>& b) {
+    // Pairs whose cars are pairs still to compare; cdrs are followed in place.
+    std::vector<std::pair<Cell*, Cell*>> stack;
+    std::unordered_set<std::pair<const Object*, const Object*>, PairHash> compared;
+    size_t steps = 0;
+    Ptr<Object> x = a;
+    Ptr<Object> y = b;
+    while (true) {
+        if (std::optional<bool> known = CompareConsed(x, y); known.has_value() && !*known) {
+            return false;
+        } else if (!known.has_value()) {
+            auto* first = dynamic_cast<Cell*>(x.get());
+            auto* second = dynamic_cast<Cell*>(y.get());
+            if (first == nullptr || second == nullptr) {
+                if (!IsEqualAtom(x, y)) {
+                    return false;
+                }
+            } else if (++steps <= kAcyclicSteps || compared.emplace(first, second).second) {
+                const Ptr<Object>& car = first->GetFirst();
+                const Ptr<Object>& other = second->GetFirst();
+                if (Is<Cell>(car) && Is<Cell>(other)) {
+                    if (car != other) {
+                        stack.emplace_back(first, second);
+                    }
+                } else if (!IsEqualAtom(car, other)) {
+                    return false;
+                }
+                x = first->GetSecond();
+                y = second->GetSecond();
+                continue;
+            }
+        }
+        if (stack.empty()) {
+            return true;
+        }
+        x = stack.back().first->GetFirst();
+        y = stack.back().second->GetFirst();
+        stack.pop_back();
+    }
+}
+
+void Environemnt::FullfillEquality() {
+    bindings_["eq?"] = EqualityPredicate(IsEq, "eq?");
+    bindings_["eqv?"] = EqualityPredicate(IsEqv, "eqv?");
+    bindings_["equal?"] = EqualityPredicate(IsEqual, "equal?");
+}
@@ -0,0 +1,162 @@
+#include "scheme/hash_cons.h"
+#include "scheme/text.h"
+
+#include <atomic>
+#include <string_view>
+#include <vector>
+
+namespace {
+uint64_t NextTableId() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id++;
+}
+
+bool IsSymbol(const Ptr<Object>& object, std::string_view name) {
+    auto* symbol = dynamic_cast<Symbol*>(object.get());
+    return symbol != nullptr && symbol->GetName() == name;
+}
+
+// Whether the list or improper list of parameters names quote.
+bool NamesQuote(const Ptr<Object>& params) {
+    Ptr<Object> cur = params;
+    for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        if (IsSymbol(As<Cell>(cur)->GetFirst(), "quote")) {
+            return true;
+        }
+    }
+    return IsSymbol(cur, "quote");
+}
+
+// Whether body, a list of forms, defines quote at its top.
+bool DefinesQuote(const Ptr<Object>& body) {
+    for (Ptr<Object> cur = body; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        auto* form = dynamic_cast<Cell*>(As<Cell>(cur)->GetFirst().get());
+        if (form != nullptr && IsSymbol(form->GetFirst(), "define") &&
+            Is<Cell>(form->GetSecond())) {
+            const Ptr<Object>& target = As<Cell>(form->GetSecond())->GetFirst();
+            if (IsSymbol(target, "quote") ||
+                (Is<Cell>(target) && IsSymbol(As<Cell>(target)->GetFirst(), "quote"))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Whether cell is a lambda, a function define or a let in which quote is bound lexically, by a
+// parameter, a let binding or a define in the body.
+bool BindsQuote(Cell* cell) {
+    auto* args = dynamic_cast<Cell*>(cell->GetSecond().get());
+    if (args == nullptr) {
+        return false;
+    }
+    const Ptr<Object>& head = cell->GetFirst();
+    if (IsSymbol(head, "lambda")) {
+        return NamesQuote(args->GetFirst()) || DefinesQuote(args->GetSecond());
+    }
+    if (IsSymbol(head, "define") && Is<Cell>(args->GetFirst())) {
+        return NamesQuote(As<Cell>(args->GetFirst())->GetSecond()) ||
+               DefinesQuote(args->GetSecond());
+    }
+    if (IsSymbol(head, "let")) {
+        for (Ptr<Object> cur = args->GetFirst(); Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+            auto* binding = dynamic_cast<Cell*>(As<Cell>(cur)->GetFirst().get());
+            if (binding != nullptr && IsSymbol(binding->GetFirst(), "quote")) {
+                return true;
+            }
+        }
+        return DefinesQuote(args->GetSecond());
+    }
+    return false;
+}
+}  // namespace
+
+HashConsTable::HashConsTable() : id_(NextTableId()) {
+}
+
+void HashConsTable::Clear() {
+    numbers_.clear();
+    symbols_.clear();
+    strings_.clear();
+    pairs_.clear();
+    id_ = NextTableId();
+}
+
+Ptr<Object> HashConsTable::Intern(const Ptr<Object>& datum) {
+    // The elements of a list are interned first, then its pairs from the last one back, in a
+    // loop: long lists do not recurse. Nested lists do, as deep as the reader did.
+    std::vector<Ptr<Object>> elements;
+    Ptr<Object> cur = datum;
+    for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        auto* consed = dynamic_cast<ConsedCell*>(cur.get());
+        if (consed != nullptr && consed->GetTable() == id_) {
+            break;
+        }
+        elements.push_back(Intern(As<Cell>(cur)->GetFirst()));
+    }
+    Ptr<Object> res = Is<Cell>(cur) ? cur : InternAtom(cur);
+    // Pairs of the table compare equal only if they are the same pair, which does not hold for
+    // a pair with a part the table could not intern.
+    bool interned = IsInterned(res);
+    for (size_t i = elements.size(); i > 0; --i) {
+        interned = interned && IsInterned(elements[i - 1]);
+        res = interned ? InternPair(elements[i - 1], res) : MakeCell(elements[i - 1], res);
+    }
+    return res;
+}
+
+bool HashConsTable::IsInterned(const Ptr<Object>& datum) const {
+    if (datum == nullptr || Is<Number>(datum) || Is<Symbol>(datum) || Is<String>(datum)) {
+        return true;
+    }
+    auto* consed = dynamic_cast<ConsedCell*>(datum.get());
+    return consed != nullptr && consed->GetTable() == id_;
+}
+
+Ptr<Object> HashConsTable::InternAtom(const Ptr<Object>& atom) {
+    if (auto* number = dynamic_cast<Number*>(atom.get())) {
+        return numbers_.try_emplace(number->GetValue(), atom).first->second;
+    }
+    if (auto* symbol = dynamic_cast<Symbol*>(atom.get())) {
+        return symbols_.try_emplace(symbol->GetName(), atom).first->second;
+    }
+    if (auto* string = dynamic_cast<String*>(atom.get())) {
+        return strings_.try_emplace(string->GetText(), atom).first->second;
+    }
+    return atom;
+}
+
+Ptr<Object> HashConsTable::InternPair(const Ptr<Object>& first, const Ptr<Object>& second) {
+    Ptr<Object>& pair = pairs_[{first.get(), second.get()}];
+    if (pair == nullptr) {
+        pair = std::allocate_shared<ConsedCell>(PoolAllocator<ConsedCell>(), first, second, id_);
+    }
+    return pair;
+}
+
+void HashConsTable::InternQuoted(const Ptr<Object>& form) {
+    std::vector<Cell*> stack;
+    if (auto* cell = dynamic_cast<Cell*>(form.get())) {
+        stack.push_back(cell);
+    }
+    while (!stack.empty()) {
+        Cell* cell = stack.back();
+        stack.pop_back();
+        auto* head = dynamic_cast<Symbol*>(cell->GetFirst().get());
+        auto* args = dynamic_cast<Cell*>(cell->GetSecond().get());
+        if (head != nullptr && head->GetName() == "quote" && args != nullptr) {
+            args->GetFirst() = Intern(args->GetFirst());
+            continue;
+        }
+        // Inside, quote is a variable and its arguments may be code.
+        if (BindsQuote(cell)) {
+            continue;
+        }
+        // Elements are forms themselves, the pairs linking them are not.
+        for (Cell* cur = cell; cur != nullptr; cur = dynamic_cast<Cell*>(cur->GetSecond().get())) {
+            if (auto* element = dynamic_cast<Cell*>(cur->GetFirst().get())) {
+                stack.push_back(element);
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#include "scheme/jit.h"
+#include "scheme/optimizer.h"
+
+namespace {
+struct Builtin {
+    const char* name;
+    FixnumOp::Op op;
+};
+
+const Builtin kFixnumOps[] = {
+    {"+", FixnumOp::Op::ADD},          {"-", FixnumOp::Op::SUB},
+    {"*", FixnumOp::Op::MUL},          {"=", FixnumOp::Op::EQUAL},
+    {"<", FixnumOp::Op::LESS},         {">", FixnumOp::Op::GREATER},
+    {"<=", FixnumOp::Op::LESS_EQUAL},  {">=", FixnumOp::Op::GREATER_EQUAL}};
+
+// Returns the arguments of a proper argument list.
+std::vector<Ptr<Object>> Arguments(const Ptr<Object>& args) {
+    std::vector<Ptr<Object>> res;
+    Ptr<Object> cur = args;
+    for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        res.push_back(As<Cell>(cur)->GetFirst());
+    }
+    if (cur != nullptr) {
+        res.clear();
+    }
+    return res;
+}
+}  // namespace
+
+Specialized::Specialized(std::string name, Ptr<Object> builtin, Ptr<Object> original,
+                         Environemnt* env)
+    : original_(std::move(original)),
+      name_(std::move(name)),
+      builtin_(std::move(builtin)),
+      env_id_(env->GetGlobal()->GetId()),
+      version_(env->GetGlobal()->GetVersion()) {
+}
+
+bool Specialized::Guard(const Ptr<Environemnt>& env) {
+    Environemnt* global = env->GetGlobal();
+    if (global->GetId() == env_id_ && global->GetVersion() == version_) {
+        return valid_;
+    }
+    Binding* binding = global->Lookup(name_);
+    if (ParallelSection::IsActive()) {
+        return binding != nullptr && binding->value == builtin_;
+    }
+    valid_ = binding != nullptr && binding->value == builtin_;
+    env_id_ = global->GetId();
+    version_ = global->GetVersion();
+    return valid_;
+}
+
+Ptr<Object> Specialized::Deopt(const std::vector<Ptr<Object>>& args) {
+    if (!ParallelSection::IsActive()) {
+        ++deopts_;
+    }
+    return As<Callable>(builtin_)->Apply(args);
+}
+
+Ptr<Object> FixnumOp::Eval(Ptr<Environemnt> env) {
+    if (!Guard(env)) {
+        return Object::Eval(original_, env);
+    }
+    Ptr<Object> lhs = Object::Eval(lhs_, env);
+    Ptr<Object> rhs = Object::Eval(rhs_, env);
+    auto* a = dynamic_cast<Number*>(lhs.get());
+    auto* b = dynamic_cast<Number*>(rhs.get());
+    if (a == nullptr || b == nullptr) {
+        return Deopt({lhs, rhs});
+    }
+    int x = a->GetValue();
+    int y = b->GetValue();
+    int res;
+    bool overflow = false;
+    switch (op_) {
+        case Op::ADD:
+            overflow = __builtin_add_overflow(x, y, &res);
+            break;
+        case Op::SUB:
+            overflow = __builtin_sub_overflow(x, y, &res);
+            break;
+        case Op::MUL:
+            overflow = __builtin_mul_overflow(x, y, &res);
+            break;
+        case Op::EQUAL:
+            return x == y ? true_ : false_;
+        case Op::LESS:
+            return x < y ? true_ : false_;
+        case Op::GREATER:
+            return x > y ? true_ : false_;
+        case Op::LESS_EQUAL:
+            return x <= y ? true_ : false_;
+        case Op::GREATER_EQUAL:
+            return x >= y ? true_ : false_;
+    }
+    if (overflow) {
+        return Deopt({lhs, rhs});
+    }
+    return MakeNumber(res);
+}
+
+Ptr<Object> PairAccess::Eval(Ptr<Environemnt> env) {
+    if (!Guard(env)) {
+        return Object::Eval(original_, env);
+    }
+    Ptr<Object> pair = Object::Eval(pair_, env);
+    auto* cell = dynamic_cast<Cell*>(pair.get());
+    if (cell == nullptr) {
+        return Deopt({pair});
+    }
+    return first_ ? cell->GetFirst() : cell->GetSecond();
+}
+
+Ptr<Object> LocalRef::Eval(Ptr<Environemnt> env) {
+    Binding* binding = env->GetSlots()[slot_].get();
+    if (!binding->defined) {
+        // Reports the error the way the symbol does.
+        return Object::Eval(original_, env);
+    }
+    return binding->value;
+}
+
+Ptr<Object> Specialize(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    if (auto symbol = std::dynamic_pointer_cast<Symbol>(ast)) {
+        int slot = env->FindSlot(symbol->GetName());
+        return slot < 0 ? ast : std::make_shared<LocalRef>(slot, ast);
+    }
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        return ast;
+    }
+    for (Ptr<Object> cur = ExpressionArguments(cell, env); Is<Cell>(cur);
+         cur = As<Cell>(cur)->GetSecond()) {
+        Ptr<Object>& arg = As<Cell>(cur)->GetFirst();
+        arg = Specialize(arg, env);
+    }
+    Ptr<Object> callee = ResolveHead(cell->GetFirst(), env);
+    if (callee == nullptr) {
+        return ast;
+    }
+    const std::string& name = As<Symbol>(cell->GetFirst())->GetName();
+    if (callee != env->GetBuiltin(name)) {
+        return ast;
+    }
+    std::vector<Ptr<Object>> args = Arguments(cell->GetSecond());
+    if ((name == "car" || name == "cdr") && args.size() == 1) {
+        return std::make_shared<PairAccess>(name == "car", args[0], name, callee, ast, env.get());
+    }
+    for (const Builtin& builtin : kFixnumOps) {
+        if (name == builtin.name && args.size() == 2) {
+            return std::make_shared<FixnumOp>(builtin.op, args[0], args[1], name, callee, ast,
+                                              env.get());
+        }
+    }
+    return ast;
+}
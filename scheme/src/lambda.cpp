@@ -0,0 +1,492 @@
+#include "scheme/lambda.h"
+#include "scheme/error.h"
+#include "scheme/jit.h"
+#include "scheme/native.h"
+#include "scheme/optimizer.h"
+
+#include <algorithm>
+
+namespace {
+bool IsForm(const Ptr<Object>& ast, const std::string& name) {
+    auto* cell = dynamic_cast<Cell*>(ast.get());
+    if (cell == nullptr) {
+        return false;
+    }
+    auto* head = dynamic_cast<Symbol*>(cell->GetFirst().get());
+    return head != nullptr && head->GetName() == name;
+}
+
+bool Contains(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+Ptr<Environemnt> GlobalOf(const Ptr<Environemnt>& env) {
+    return env->IsGlobal() ? env : env->GetGlobalPtr();
+}
+
+// Parses (a b c), (a b . rest) or args.
+void ParseParams(const Ptr<Object>& params, std::vector<std::string>* names, bool* variadic) {
+    *variadic = false;
+    Ptr<Object> cur = params;
+    while (cur != nullptr) {
+        if (auto symbol = std::dynamic_pointer_cast<Symbol>(cur)) {
+            names->push_back(symbol->GetName());
+            *variadic = true;
+            return;
+        }
+        auto cell = std::dynamic_pointer_cast<Cell>(cur);
+        if (cell == nullptr || !Is<Symbol>(cell->GetFirst())) {
+            throw SyntaxError("Parameters must be symbols");
+        }
+        names->push_back(As<Symbol>(cell->GetFirst())->GetName());
+        cur = cell->GetSecond();
+    }
+}
+
+// Names introduced by (define ...) forms at the top level of body.
+void CollectDefines(const Ptr<Object>& body, std::vector<std::string>* names) {
+    for (Ptr<Object> cur = body; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        const Ptr<Object>& form = As<Cell>(cur)->GetFirst();
+        if (!IsForm(form, "define") || !Is<Cell>(As<Cell>(form)->GetSecond())) {
+            continue;
+        }
+        Ptr<Object> target = As<Cell>(As<Cell>(form)->GetSecond())->GetFirst();
+        if (Is<Cell>(target)) {
+            target = As<Cell>(target)->GetFirst();
+        }
+        if (Is<Symbol>(target) && !Contains(*names, As<Symbol>(target)->GetName())) {
+            names->push_back(As<Symbol>(target)->GetName());
+        }
+    }
+}
+
+// Collects symbols a body refers to but does not bind itself. Errs on the side of reporting
+// too much: a name which is not really a variable reference only costs a useless capture.
+class FreeVariables {
+public:
+    // Variables of enclosing, a frame or the global scope, shadow special forms.
+    FreeVariables(std::vector<std::string> bound, const Environemnt* enclosing)
+        : bound_(std::move(bound)), enclosing_(enclosing) {
+    }
+
+    void Walk(const Ptr<Object>& ast) {
+        if (auto symbol = std::dynamic_pointer_cast<Symbol>(ast)) {
+            if (!Contains(bound_, symbol->GetName()) && !Contains(free_, symbol->GetName())) {
+                free_.push_back(symbol->GetName());
+            }
+            return;
+        }
+        auto cell = std::dynamic_pointer_cast<Cell>(ast);
+        if (cell == nullptr || IsSpecial(cell, "quote")) {
+            return;
+        }
+        auto args = std::dynamic_pointer_cast<Cell>(cell->GetSecond());
+        if (args != nullptr && IsSpecial(cell, "lambda")) {
+            WalkScope(ParamNames(args->GetFirst()), args->GetSecond());
+            return;
+        }
+        if (args != nullptr && IsSpecial(cell, "define") && Is<Cell>(args->GetFirst())) {
+            Walk(As<Cell>(args->GetFirst())->GetFirst());
+            WalkScope(ParamNames(As<Cell>(args->GetFirst())->GetSecond()), args->GetSecond());
+            return;
+        }
+        if (args != nullptr && IsSpecial(cell, "let")) {
+            std::vector<std::string> names;
+            for (Ptr<Object> cur = args->GetFirst(); Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+                auto binding = std::dynamic_pointer_cast<Cell>(As<Cell>(cur)->GetFirst());
+                if (binding == nullptr) {
+                    continue;
+                }
+                if (Is<Symbol>(binding->GetFirst())) {
+                    names.push_back(As<Symbol>(binding->GetFirst())->GetName());
+                }
+                Walk(binding->GetSecond());
+            }
+            WalkScope(names, args->GetSecond());
+            return;
+        }
+        Ptr<Object> cur = cell;
+        while (Is<Cell>(cur)) {
+            Walk(As<Cell>(cur)->GetFirst());
+            cur = As<Cell>(cur)->GetSecond();
+        }
+        Walk(cur);
+    }
+
+    void WalkScope(std::vector<std::string> names, const Ptr<Object>& body) {
+        size_t size = bound_.size();
+        CollectDefines(body, &names);
+        bound_.insert(bound_.end(), names.begin(), names.end());
+        for (Ptr<Object> cur = body; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+            Walk(As<Cell>(cur)->GetFirst());
+        }
+        bound_.resize(size);
+    }
+
+    const std::vector<std::string>& GetFree() const {
+        return free_;
+    }
+
+private:
+    bool IsSpecial(const Ptr<Cell>& cell, const std::string& name) const {
+        return IsForm(cell, name) && !Contains(bound_, name) && !enclosing_->IsLocal(name);
+    }
+
+    static std::vector<std::string> ParamNames(const Ptr<Object>& params) {
+        std::vector<std::string> names;
+        Ptr<Object> cur = params;
+        while (Is<Cell>(cur)) {
+            if (Is<Symbol>(As<Cell>(cur)->GetFirst())) {
+                names.push_back(As<Symbol>(As<Cell>(cur)->GetFirst())->GetName());
+            }
+            cur = As<Cell>(cur)->GetSecond();
+        }
+        if (Is<Symbol>(cur)) {
+            names.push_back(As<Symbol>(cur)->GetName());
+        }
+        return names;
+    }
+
+    std::vector<std::string> bound_;
+    std::vector<std::string> free_;
+    const Environemnt* enclosing_;
+};
+
+// Returns the form preprocessed at the arguments cell of a special form, building it with make
+// the first time the cell is evaluated in the scope of env. A cell without a call site cache
+// builds it every time.
+template <typename F>
+Ptr<LambdaForm> CachedForm(Cell* cell, Environemnt* env, F make) {
+    CallSite* site = cell->GetSite();
+    if (site == nullptr) {
+        return make();
+    }
+    auto form = std::dynamic_pointer_cast<LambdaForm>(site->form);
+    if (form == nullptr || form->GetEnclosingScopeId() != env->GetScopeId()) {
+        form = make();
+        if (!ParallelSection::IsActive()) {
+            site->form = form;
+        }
+    }
+    return form;
+}
+
+Ptr<Object> MakeClosure(const Ptr<Cell>& cell, const Ptr<Object>& params, const Ptr<Object>& body,
+                        const Ptr<Environemnt>& env) {
+    Ptr<LambdaForm> form = CachedForm(cell.get(), env.get(), [&] {
+        std::vector<std::string> names;
+        bool variadic;
+        ParseParams(params, &names, &variadic);
+        return std::make_shared<LambdaForm>(std::move(names), variadic, body, env.get());
+    });
+    return std::make_shared<Lambda>(form, form->Capture(env.get()), GlobalOf(env));
+}
+
+// Returns the error of the first argument which fails to evaluate, if any.
+std::optional<Error> EvalArguments(const Ptr<Object>& ast, const Ptr<Environemnt>& env,
+                                   std::vector<Ptr<Object>>* args) {
+    const Ptr<Object>* cur = &ast;
+    while (*cur != nullptr) {
+        auto* cell = dynamic_cast<Cell*>(cur->get());
+        Result<Ptr<Object>> value = Object::TryEval(cell == nullptr ? *cur : cell->GetFirst(), env);
+        if (!value.IsOk()) {
+            return std::move(value.GetError());
+        }
+        args->push_back(std::move(value.GetValue()));
+        if (cell == nullptr) {
+            break;
+        }
+        cur = &cell->GetSecond();
+    }
+    return std::nullopt;
+}
+}  // namespace
+
+LambdaForm::LambdaForm(std::vector<std::string> params, bool variadic, const Ptr<Object>& body,
+                       Environemnt* env)
+    : shape_(std::make_shared<Shape>()),
+      params_count_(params.size()),
+      variadic_(variadic),
+      enclosing_scope_(env->GetScopeId()) {
+    Ptr<Object> cur = body;
+    while (cur != nullptr) {
+        auto cell = std::dynamic_pointer_cast<Cell>(cur);
+        if (cell == nullptr) {
+            throw SyntaxError("Body must be a proper list");
+        }
+        body_.push_back(cell->GetFirst());
+        cur = cell->GetSecond();
+    }
+    if (body_.empty()) {
+        throw SyntaxError("Body must not be empty");
+    }
+
+    shape_->names = std::move(params);
+    CollectDefines(body, &shape_->names);
+    defines_count_ = shape_->names.size() - params_count_;
+
+    FreeVariables free(shape_->names, env);
+    for (const Ptr<Object>& form : body_) {
+        free.Walk(form);
+    }
+    for (const std::string& name : free.GetFree()) {
+        int slot = env->FindSlot(name);
+        if (slot >= 0) {
+            shape_->names.push_back(name);
+            capture_slots_.push_back(slot);
+        }
+    }
+}
+
+std::vector<Ptr<Binding>> LambdaForm::Capture(Environemnt* env) const {
+    std::vector<Ptr<Binding>> captures;
+    captures.reserve(capture_slots_.size());
+    for (int slot : capture_slots_) {
+        captures.push_back(env->GetSlots()[slot]);
+    }
+    return captures;
+}
+
+Result<Ptr<Environemnt>> LambdaForm::MakeFrame(const std::vector<Ptr<Binding>>& captures,
+                                               const std::vector<Ptr<Object>>& args,
+                                               const Ptr<Environemnt>& global) {
+    size_t fixed = variadic_ ? params_count_ - 1 : params_count_;
+    if (args.size() < fixed || (!variadic_ && args.size() != fixed)) {
+        return Error{Error::Kind::RUNTIME, "Wrong number of arguments"};
+    }
+    auto frame = std::make_shared<Environemnt>(shape_, global);
+    std::vector<Ptr<Binding>>& slots = frame->GetSlots();
+    size_t slot = 0;
+    for (; slot < fixed; ++slot) {
+        slots[slot] = std::make_shared<Binding>();
+        slots[slot]->value = args[slot];
+    }
+    if (variadic_) {
+        Ptr<Object> rest = nullptr;
+        for (size_t i = args.size(); i > fixed; --i) {
+            rest = MakeCell(args[i - 1], rest);
+        }
+        slots[slot] = std::make_shared<Binding>();
+        slots[slot]->value = rest;
+        ++slot;
+    }
+    for (size_t i = 0; i < defines_count_; ++i, ++slot) {
+        slots[slot] = std::make_shared<Binding>();
+        slots[slot]->defined = false;
+    }
+    for (const Ptr<Binding>& capture : captures) {
+        slots[slot++] = capture;
+    }
+    return frame;
+}
+
+Result<Ptr<Object>> LambdaForm::RunBody(const Ptr<Environemnt>& frame, TailCall* tail) {
+    // Threads sharing the body run it as it is.
+    if (!ParallelSection::IsActive()) {
+        if (!optimized_) {
+            optimized_ = true;
+            for (Ptr<Object>& form : body_) {
+                form = Optimize(form, frame);
+            }
+        }
+        if (++calls_ == kHotCalls) {
+            for (Ptr<Object>& form : body_) {
+                form = CompileNative(Specialize(form, frame), frame);
+            }
+        }
+    }
+    for (size_t i = 0; i + 1 < body_.size(); ++i) {
+        Result<Ptr<Object>> value = Object::TryEval(body_[i], frame);
+        if (!value.IsOk()) {
+            return value;
+        }
+    }
+    return Object::TryEvalTail(body_.back(), frame, tail);
+}
+
+Ptr<Object> LambdaForm::Run(const std::vector<Ptr<Binding>>& captures,
+                            const std::vector<Ptr<Object>>& args, const Ptr<Environemnt>& global) {
+    return TryRun(captures, args, global).ValueOrThrow();
+}
+
+Result<Ptr<Object>> LambdaForm::TryRun(const std::vector<Ptr<Binding>>& captures,
+                                       const std::vector<Ptr<Object>>& args,
+                                       const Ptr<Environemnt>& global) {
+    TailCall tail;
+    Result<Ptr<Environemnt>> frame = MakeFrame(captures, args, global);
+    LambdaForm* current = this;
+    // Keeps the form of a tail call alive while its body runs.
+    Ptr<LambdaForm> form;
+    while (frame.IsOk()) {
+        Result<Ptr<Object>> res = current->RunBody(frame.GetValue(), &tail);
+        if (!res.IsOk() || !tail.pending) {
+            return res;
+        }
+        tail.pending = false;
+        // Moved out first: the next body may leave its own tail call in tail.
+        form = std::move(tail.form);
+        current = form.get();
+        frame = current->MakeFrame(tail.captures, tail.args, tail.global);
+    }
+    return std::move(frame.GetError());
+}
+
+Ptr<Environemnt> Lambda::LockGlobal() const {
+    Ptr<Environemnt> global = global_.lock();
+    if (global == nullptr) {
+        throw RuntimeError("Procedure outlived its interpreter");
+    }
+    return global;
+}
+
+Ptr<Object> Lambda::Call(Ptr<Object> ast, Ptr<Environemnt> env) {
+    return TryCall(std::move(ast), std::move(env)).ValueOrThrow();
+}
+
+Ptr<Object> Lambda::CallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) {
+    return TryCallTail(std::move(ast), std::move(env), tail).ValueOrThrow();
+}
+
+Ptr<Object> Lambda::Apply(const std::vector<Ptr<Object>>& args) {
+    return TryApply(args).ValueOrThrow();
+}
+
+Result<Ptr<Object>> Lambda::TryCall(Ptr<Object> ast, Ptr<Environemnt> env) {
+    ScratchVector<Object> args;
+    if (std::optional<Error> error = EvalArguments(ast, env, &*args)) {
+        return std::move(*error);
+    }
+    return TryApply(*args);
+}
+
+Result<Ptr<Object>> Lambda::TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) {
+    if (tail == nullptr) {
+        return TryCall(std::move(ast), std::move(env));
+    }
+    std::vector<Ptr<Object>> args;
+    if (std::optional<Error> error = EvalArguments(ast, env, &args)) {
+        return std::move(*error);
+    }
+    tail->form = form_;
+    tail->captures = captures_;
+    tail->args = std::move(args);
+    tail->global = LockGlobal();
+    tail->pending = true;
+    return Ptr<Object>();
+}
+
+Result<Ptr<Object>> Lambda::TryApply(const std::vector<Ptr<Object>>& args) {
+    return form_->TryRun(captures_, args, LockGlobal());
+}
+
+Ptr<Object> EvalLambda(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        throw SyntaxError("lambda must have parameters and a body");
+    }
+    return MakeClosure(cell, cell->GetFirst(), cell->GetSecond(), env);
+}
+
+Ptr<Object> EvalDefine(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        throw SyntaxError("define must have a name and a value");
+    }
+    if (auto target = std::dynamic_pointer_cast<Cell>(cell->GetFirst())) {
+        // (define (name . params) body...)
+        auto name = std::dynamic_pointer_cast<Symbol>(target->GetFirst());
+        if (name == nullptr) {
+            throw SyntaxError("Name in define must be a symbol");
+        }
+        env->Define(name->GetName(), MakeClosure(cell, target->GetSecond(), cell->GetSecond(), env));
+        return nullptr;
+    }
+    auto name = std::dynamic_pointer_cast<Symbol>(cell->GetFirst());
+    auto value = std::dynamic_pointer_cast<Cell>(cell->GetSecond());
+    if (name == nullptr || value == nullptr || value->GetSecond() != nullptr) {
+        throw SyntaxError("define must have a name and a value");
+    }
+    env->Define(name->GetName(), Object::Eval(value->GetFirst(), env));
+    return nullptr;
+}
+
+Ptr<Object> EvalSet(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        throw SyntaxError("set! must have a name and a value");
+    }
+    auto name = std::dynamic_pointer_cast<Symbol>(cell->GetFirst());
+    auto value = std::dynamic_pointer_cast<Cell>(cell->GetSecond());
+    if (name == nullptr || value == nullptr || value->GetSecond() != nullptr) {
+        throw SyntaxError("set! must have a name and a value");
+    }
+    Ptr<Object> res = Object::Eval(value->GetFirst(), env);
+    Binding* binding = name->Resolve(env.get());
+    if (binding == nullptr) {
+        throw RuntimeError("set! of an undefined variable");
+    }
+    binding->value = std::move(res);
+    if (name->IsResolvedGlobal()) {
+        env->GetGlobal()->Touch();
+    }
+    return nullptr;
+}
+
+Ptr<Object> EvalLet(const Ptr<Object>& ast, const Ptr<Environemnt>& env, TailCall* tail) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        throw SyntaxError("let must have bindings and a body");
+    }
+    Ptr<LambdaForm> form = CachedForm(cell.get(), env.get(), [&] {
+        std::vector<std::string> names;
+        for (Ptr<Object> cur = cell->GetFirst(); cur != nullptr; cur = As<Cell>(cur)->GetSecond()) {
+            if (!Is<Cell>(cur)) {
+                throw SyntaxError("let bindings must be a list");
+            }
+            auto binding = std::dynamic_pointer_cast<Cell>(As<Cell>(cur)->GetFirst());
+            if (binding == nullptr || !Is<Symbol>(binding->GetFirst()) ||
+                !Is<Cell>(binding->GetSecond()) ||
+                As<Cell>(binding->GetSecond())->GetSecond() != nullptr) {
+                throw SyntaxError("let binding must be (name value)");
+            }
+            names.push_back(As<Symbol>(binding->GetFirst())->GetName());
+        }
+        return std::make_shared<LambdaForm>(std::move(names), false, cell->GetSecond(), env.get());
+    });
+    std::vector<Ptr<Object>> values;
+    for (Ptr<Object> cur = cell->GetFirst(); cur != nullptr; cur = As<Cell>(cur)->GetSecond()) {
+        Ptr<Cell> binding = As<Cell>(As<Cell>(cur)->GetFirst());
+        values.push_back(Object::Eval(As<Cell>(binding->GetSecond())->GetFirst(), env));
+    }
+    if (tail != nullptr) {
+        tail->form = form;
+        tail->captures = form->Capture(env.get());
+        tail->args = std::move(values);
+        tail->global = GlobalOf(env);
+        tail->pending = true;
+        return nullptr;
+    }
+    return form->Run(form->Capture(env.get()), values, GlobalOf(env));
+}
+
+Ptr<Object> EvalIf(const Ptr<Object>& ast, const Ptr<Environemnt>& env, TailCall* tail) {
+    auto* condition = dynamic_cast<Cell*>(ast.get());
+    auto* then_branch = condition ? dynamic_cast<Cell*>(condition->GetSecond().get()) : nullptr;
+    if (then_branch == nullptr) {
+        throw SyntaxError("if must have a condition and a branch");
+    }
+    auto* else_branch = dynamic_cast<Cell*>(then_branch->GetSecond().get());
+    if ((else_branch == nullptr && then_branch->GetSecond() != nullptr) ||
+        (else_branch != nullptr && else_branch->GetSecond() != nullptr)) {
+        throw SyntaxError("if must have at most two branches");
+    }
+    Ptr<Object> value = Object::Eval(condition->GetFirst(), env);
+    auto* boolean = dynamic_cast<Boolean*>(value.get());
+    if (boolean == nullptr || boolean->var_) {
+        return Object::EvalTail(then_branch->GetFirst(), env, tail);
+    }
+    if (else_branch == nullptr) {
+        return nullptr;
+    }
+    return Object::EvalTail(else_branch->GetFirst(), env, tail);
+}
@@ -0,0 +1,308 @@
+#include "scheme/lazy.h"
+#include "scheme/binary.h"
+#include "scheme/parser.h"
+#include "scheme/text.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Positions of the lists of a file and of where each one ends, in the order lists start.
+class ListIndex {
+public:
+    size_t Add(size_t start) {
+        lists_.emplace_back(start, 0);
+        return lists_.size() - 1;
+    }
+    void SetEnd(size_t list, size_t end) {
+        lists_[list].second = end;
+    }
+    size_t GetEnd(size_t start) const {
+        auto it = std::lower_bound(lists_.begin(), lists_.end(), std::make_pair(start, size_t{0}));
+        return it->second;
+    }
+
+private:
+    std::vector<std::pair<size_t, size_t>> lists_;
+};
+
+class TextSource : public LazySource {
+public:
+    explicit TextSource(Ptr<MappedFile> file) : file_(std::move(file)), data_(file_->GetData()) {
+        std::vector<size_t> open;
+        for (size_t pos = 0; pos < data_.size(); ++pos) {
+            if (data_[pos] == '"') {
+                pos = StringEnd(pos) - 1;
+            } else if (data_[pos] == '(') {
+                open.push_back(index_.Add(pos));
+            } else if (data_[pos] == ')') {
+                if (open.empty()) {
+                    throw SyntaxError("No matching open bracket");
+                }
+                index_.SetEnd(open.back(), pos + 1);
+                open.pop_back();
+            }
+        }
+        if (!open.empty()) {
+            throw SyntaxError("ReadList reached the end, but not Close Bracket found");
+        }
+        start_ = SkipSpace(0);
+        if (start_ == data_.size()) {
+            throw SyntaxError("Read reached the end, but not Close Bracket found");
+        }
+        if (SkipSpace(End(start_)) != data_.size()) {
+            throw SyntaxError("Data files hold one datum");
+        }
+    }
+
+    size_t GetStart() const {
+        return start_;
+    }
+
+    Ptr<Object> Element(size_t pos) override {
+        if (data_[pos] != '(') {
+            ViewBuffer buffer;
+            buffer.Reset(data_.substr(pos, End(pos) - pos));
+            std::istream stream(&buffer);
+            Tokenizer tokenizer(&stream);
+            return ReadDatum(&tokenizer);
+        }
+        size_t first = SkipSpace(pos + 1);
+        if (data_[first] == ')') {
+            return nullptr;
+        }
+        if (data_[first] == '.') {
+            throw SyntaxError("Dot should be before last element of list");
+        }
+        return std::make_shared<LazyCell>(shared_from_this(), first, 0);
+    }
+
+    Ptr<Object> Rest(size_t pos, size_t) override {
+        size_t next = SkipSpace(End(pos));
+        if (data_[next] == ')') {
+            return nullptr;
+        }
+        if (data_[next] != '.') {
+            return std::make_shared<LazyCell>(shared_from_this(), next, 0);
+        }
+        size_t tail = SkipSpace(next + 1);
+        if (data_[tail] == ')' || data_[tail] == '.') {
+            throw SyntaxError("No closing bracket in pair");
+        }
+        if (data_[SkipSpace(End(tail))] != ')') {
+            throw SyntaxError("No closing bracket in pair");
+        }
+        return Element(tail);
+    }
+
+private:
+    size_t SkipSpace(size_t pos) const {
+        while (pos < data_.size() && std::isspace(static_cast<unsigned char>(data_[pos]))) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    // Position right after the string literal starting at pos.
+    size_t StringEnd(size_t pos) const {
+        for (++pos; pos < data_.size(); ++pos) {
+            if (data_[pos] == '\\') {
+                ++pos;
+            } else if (data_[pos] == '"') {
+                return pos + 1;
+            }
+        }
+        throw SyntaxError("Read reached the end inside a string");
+    }
+
+    // Position right after the datum at pos.
+    size_t End(size_t pos) const {
+        if (data_[pos] == '(') {
+            return index_.GetEnd(pos);
+        }
+        if (data_[pos] == '\'') {
+            size_t quoted = SkipSpace(pos + 1);
+            if (quoted == data_.size() || data_[quoted] == ')') {
+                throw SyntaxError("Read reached the end, but not Close Bracket found");
+            }
+            return End(quoted);
+        }
+        if (data_[pos] == ')' || data_[pos] == '.') {
+            return pos + 1;
+        }
+        if (data_[pos] == '"') {
+            return StringEnd(pos);
+        }
+        while (pos < data_.size() && !std::isspace(static_cast<unsigned char>(data_[pos])) &&
+               data_[pos] != '(' && data_[pos] != ')' && data_[pos] != '\'' && data_[pos] != '"') {
+            ++pos;
+        }
+        return pos;
+    }
+
+    Ptr<MappedFile> file_;
+    std::string_view data_;
+    ListIndex index_;
+    size_t start_;
+};
+
+class BinarySource : public LazySource {
+public:
+    explicit BinarySource(Ptr<MappedFile> file) : file_(std::move(file)), data_(file_->GetData()) {
+        data_.remove_prefix(kBinaryMagic.size() + 1);
+        // Lists being scanned and how many of their elements and tail are left.
+        std::vector<std::pair<size_t, size_t>> open;
+        size_t pos = 0;
+        while (true) {
+            size_t start = pos;
+            if (pos == data_.size()) {
+                throw SyntaxError("Binary data ends inside a datum");
+            }
+            auto tag = static_cast<BinaryTag>(data_[pos++]);
+            if (tag == BinaryTag::LIST) {
+                uint64_t count = ReadVarint(data_, &pos);
+                if (count > data_.size() - pos) {
+                    throw SyntaxError("Binary list longer than its data");
+                }
+                open.emplace_back(index_.Add(start), count + 1);
+                continue;
+            }
+            if (tag == BinaryTag::SYMBOL) {
+                uint64_t size = ReadVarint(data_, &pos);
+                if (size > data_.size() - pos) {
+                    throw SyntaxError("Binary data ends inside a symbol");
+                }
+                symbols_.emplace_back(start, std::make_shared<Symbol>(std::string(data_.substr(pos, size))));
+                pos += size;
+            } else if (tag == BinaryTag::STRING) {
+                uint64_t size = ReadVarint(data_, &pos);
+                if (size > data_.size() - pos) {
+                    throw SyntaxError("Binary data ends inside a string");
+                }
+                pos += size;
+            } else if (tag == BinaryTag::SYMBOL_REF) {
+                if (ReadVarint(data_, &pos) >= symbols_.size()) {
+                    throw SyntaxError("Binary symbol reference out of range");
+                }
+            } else if (tag == BinaryTag::FIXNUM) {
+                DecodeFixnum(ReadVarint(data_, &pos));
+            } else if (tag != BinaryTag::NIL && tag != BinaryTag::TRUE && tag != BinaryTag::FALSE) {
+                throw SyntaxError("Unknown tag in binary data");
+            }
+            // The datum is complete, and so are the lists it was the last part of.
+            while (!open.empty() && --open.back().second == 0) {
+                index_.SetEnd(open.back().first, pos);
+                open.pop_back();
+            }
+            if (open.empty()) {
+                break;
+            }
+        }
+        if (pos != data_.size()) {
+            throw SyntaxError("Trailing bytes after binary datum");
+        }
+    }
+
+    Ptr<Object> Element(size_t pos) override {
+        auto tag = static_cast<BinaryTag>(data_[pos++]);
+        switch (tag) {
+            case BinaryTag::NIL:
+                return nullptr;
+            case BinaryTag::TRUE:
+                return MakeBoolean(true);
+            case BinaryTag::FALSE:
+                return MakeBoolean(false);
+            case BinaryTag::FIXNUM:
+                return MakeNumber(DecodeFixnum(ReadVarint(data_, &pos)));
+            case BinaryTag::SYMBOL: {
+                auto it = std::lower_bound(symbols_.begin(), symbols_.end(), pos - 1,
+                                           [](const auto& symbol, size_t start) {
+                                               return symbol.first < start;
+                                           });
+                return it->second;
+            }
+            case BinaryTag::SYMBOL_REF:
+                return symbols_[ReadVarint(data_, &pos)].second;
+            case BinaryTag::STRING: {
+                uint64_t size = ReadVarint(data_, &pos);
+                return MakeString(data_.substr(pos, size));
+            }
+            default: {
+                uint64_t count = ReadVarint(data_, &pos);
+                if (count == 0) {
+                    return Element(pos);
+                }
+                return std::make_shared<LazyCell>(shared_from_this(), pos, count - 1);
+            }
+        }
+    }
+
+    Ptr<Object> Rest(size_t pos, size_t remaining) override {
+        size_t next = End(pos);
+        if (remaining == 0) {
+            return Element(next);
+        }
+        return std::make_shared<LazyCell>(shared_from_this(), next, remaining - 1);
+    }
+
+private:
+    size_t End(size_t pos) const {
+        auto tag = static_cast<BinaryTag>(data_[pos]);
+        if (tag == BinaryTag::LIST) {
+            return index_.GetEnd(pos);
+        }
+        ++pos;
+        if (tag == BinaryTag::FIXNUM || tag == BinaryTag::SYMBOL_REF) {
+            ReadVarint(data_, &pos);
+        } else if (tag == BinaryTag::SYMBOL || tag == BinaryTag::STRING) {
+            pos += ReadVarint(data_, &pos);
+        }
+        return pos;
+    }
+
+    Ptr<MappedFile> file_;
+    std::string_view data_;
+    ListIndex index_;
+    // Symbols in the order they are defined, with where they are.
+    std::vector<std::pair<size_t, Ptr<Object>>> symbols_;
+};
+
+bool IsBinary(std::string_view data) {
+    return data.size() > kBinaryMagic.size() && data.substr(0, kBinaryMagic.size()) == kBinaryMagic &&
+           data[kBinaryMagic.size()] == kBinaryVersion;
+}
+}  // namespace
+
+void LazyCell::RealizeFirst() {
+    first_ = source_->Element(pos_);
+    if (second_ != kUnrealized) {
+        source_ = nullptr;
+    }
+}
+
+void LazyCell::RealizeSecond() {
+    second_ = source_->Rest(pos_, remaining_);
+    if (first_ != kUnrealized) {
+        source_ = nullptr;
+    }
+}
+
+Ptr<Object> LoadData(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    if (IsBinary(file->GetData())) {
+        return std::make_shared<BinarySource>(std::move(file))->Element(0);
+    }
+    auto source = std::make_shared<TextSource>(std::move(file));
+    return source->Element(source->GetStart());
+}
+
+void InstallLoadData(Environemnt* env) {
+    env->Define("load-data", std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            if (auto* path = dynamic_cast<String*>(args.front().get())) {
+                return LoadData(path->GetText());
+            }
+            return LoadData(As<Symbol>(args.front())->GetName());
+        },
+        false, Arity::Exactly("load-data", 1)));
+}
@@ -0,0 +1,314 @@
+#include "scheme/equality.h"
+#include "scheme/object.h"
+
+namespace {
+// Builds a list front to back, appending in constant time.
+class ListBuilder {
+public:
+    void Push(Ptr<Object> value) {
+        Ptr<Cell> cell = MakeCell(std::move(value), nullptr);
+        if (tail_ == nullptr) {
+            root_ = cell;
+        } else {
+            tail_->GetSecond() = cell;
+        }
+        tail_ = cell.get();
+    }
+    // Returns the list, ending with tail.
+    Ptr<Object> Finish(Ptr<Object> tail = nullptr) {
+        if (tail_ == nullptr) {
+            return tail;
+        }
+        tail_->GetSecond() = std::move(tail);
+        return root_;
+    }
+
+private:
+    Ptr<Object> root_;
+    Cell* tail_ = nullptr;
+};
+
+// Returns the pair list is, or nullptr at the end of a proper list.
+Cell* Walk(const Ptr<Object>& list, const char* name) {
+    if (list == nullptr) {
+        return nullptr;
+    }
+    auto* cell = dynamic_cast<Cell*>(list.get());
+    if (cell == nullptr) {
+        throw RuntimeError(std::string(name) + " needs proper lists");
+    }
+    return cell;
+}
+
+// Iterates over lists args[first..] in step: holds the elements at the current position of each
+// of them, until the shortest one ends.
+class Zip {
+public:
+    Zip(const std::vector<Ptr<Object>>& args, size_t first, const char* name)
+        : lists_(args.begin() + first, args.end()), name_(name) {
+    }
+    // Moves to the next position and stores the elements there after prefix in *out; false
+    // once a list has ended.
+    bool Next(std::vector<Ptr<Object>>* out, size_t prefix) {
+        out->resize(prefix + lists_.size());
+        for (size_t i = 0; i < lists_.size(); ++i) {
+            Cell* cell = Walk(lists_[i], name_);
+            if (cell == nullptr) {
+                return false;
+            }
+            (*out)[prefix + i] = cell->GetFirst();
+            lists_[i] = cell->GetSecond();
+        }
+        return true;
+    }
+
+private:
+    std::vector<Ptr<Object>> lists_;
+    const char* name_;
+};
+
+// A stage of list-transduce: (tmap f) replaces each element with (f element), and (tfilter pred)
+// drops the elements pred returns #f for.
+class Transducer : public Object {
+public:
+    Transducer(bool filter, Ptr<Object> procedure)
+        : filter_(filter), procedure_(std::move(procedure)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return "Transducer";
+    }
+    // Runs value through this stage; false if it is dropped.
+    bool Pass(Ptr<Object>* value, std::vector<Ptr<Object>>* call) const {
+        *call = {*value};
+        Ptr<Object> res = As<Callable>(procedure_)->Apply(*call);
+        if (!filter_) {
+            *value = std::move(res);
+            return true;
+        }
+        return !Is<Boolean>(res) || As<Boolean>(res)->var_;
+    }
+    ~Transducer() override = default;
+
+private:
+    bool filter_;
+    Ptr<Object> procedure_;
+};
+
+template <bool (*Same)(const Ptr<Object>&, const Ptr<Object>&)>
+Ptr<Object> Assoc(const std::vector<Ptr<Object>>& args, const char* name) {
+    for (Cell* cell = Walk(args[1], name); cell != nullptr; cell = Walk(cell->GetSecond(), name)) {
+        auto* pair = dynamic_cast<Cell*>(cell->GetFirst().get());
+        if (pair == nullptr) {
+            throw RuntimeError(std::string(name) + " needs a list of pairs");
+        }
+        if (Same(args[0], pair->GetFirst())) {
+            return cell->GetFirst();
+        }
+    }
+    return MakeBoolean(false);
+}
+
+template <bool (*Same)(const Ptr<Object>&, const Ptr<Object>&)>
+Ptr<Object> Member(const std::vector<Ptr<Object>>& args, const char* name) {
+    for (Ptr<Object> cur = args[1]; Walk(cur, name) != nullptr; cur = As<Cell>(cur)->GetSecond()) {
+        if (Same(args[0], As<Cell>(cur)->GetFirst())) {
+            return cur;
+        }
+    }
+    return MakeBoolean(false);
+}
+}  // namespace
+
+void Environemnt::FullfillLists() {
+    bindings_["length"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            size_t length = 0;
+            for (Cell* cell = Walk(args[0], "length"); cell != nullptr;
+                 cell = Walk(cell->GetSecond(), "length")) {
+                ++length;
+            }
+            return MakeSize(length, "length");
+        }, false, Arity::Exactly("length", 1));
+    bindings_["append"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            if (args.empty()) {
+                return Ptr<Object>();
+            }
+            ListBuilder res;
+            for (size_t i = 0; i + 1 < args.size(); ++i) {
+                for (Cell* cell = Walk(args[i], "append"); cell != nullptr;
+                     cell = Walk(cell->GetSecond(), "append")) {
+                    res.Push(cell->GetFirst());
+                }
+            }
+            // The last list is shared, not copied.
+            return res.Finish(args.back());
+        });
+    bindings_["reverse"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            Ptr<Object> res = nullptr;
+            for (Cell* cell = Walk(args[0], "reverse"); cell != nullptr;
+                 cell = Walk(cell->GetSecond(), "reverse")) {
+                res = MakeCell(cell->GetFirst(), res);
+            }
+            return res;
+        }, false, Arity::Exactly("reverse", 1));
+    bindings_["list-copy"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            ListBuilder res;
+            Ptr<Object> cur = args[0];
+            for (; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+                res.Push(As<Cell>(cur)->GetFirst());
+            }
+            return res.Finish(cur);
+        }, false, Arity::Exactly("list-copy", 1));
+    // (map f list...) and (for-each f list...) stop at the end of the shortest list.
+    bindings_["map"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            Callable* callable = As<Callable>(args[0]).get();
+            Zip zip(args, 1, "map");
+            ScratchVector<Object> call;
+            ListBuilder res;
+            while (zip.Next(&*call, 0)) {
+                res.Push(callable->Apply(*call));
+            }
+            return res.Finish();
+        },
+        false, Arity::AtLeast("map", 2));
+    bindings_["for-each"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            Callable* callable = As<Callable>(args[0]).get();
+            Zip zip(args, 1, "for-each");
+            ScratchVector<Object> call;
+            while (zip.Next(&*call, 0)) {
+                callable->Apply(*call);
+            }
+            return nullptr;
+        },
+        false, Arity::AtLeast("for-each", 2));
+    bindings_["filter"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            Callable* callable = As<Callable>(args[0]).get();
+            ScratchVector<Object> call;
+            call->resize(1);
+            ListBuilder res;
+            for (Cell* cell = Walk(args[1], "filter"); cell != nullptr;
+                 cell = Walk(cell->GetSecond(), "filter")) {
+                (*call)[0] = cell->GetFirst();
+                Ptr<Object> keep = callable->Apply(*call);
+                if (!Is<Boolean>(keep) || As<Boolean>(keep)->var_) {
+                    res.Push(cell->GetFirst());
+                }
+            }
+            return res.Finish();
+        },
+        false, Arity::Exactly("filter", 2));
+    // (fold-left f init list...) computes (f (f init a1 b1...) a2 b2...)...
+    bindings_["fold-left"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            Callable* callable = As<Callable>(args[0]).get();
+            Zip zip(args, 2, "fold-left");
+            ScratchVector<Object> call;
+            Ptr<Object> res = args[1];
+            while (zip.Next(&*call, 1)) {
+                (*call)[0] = std::move(res);
+                res = callable->Apply(*call);
+            }
+            return res;
+        },
+        false, Arity::AtLeast("fold-left", 3));
+    // ...and (fold-right f init list...) computes (f a1 b1... (f a2 b2... init)).
+    bindings_["fold-right"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            Callable* callable = As<Callable>(args[0]).get();
+            size_t lists = args.size() - 2;
+            // Elements are applied last to first: they have to be kept somewhere first, and a
+            // vector of them is five times smaller than a reversed list.
+            Zip zip(args, 2, "fold-right");
+            std::vector<Ptr<Object>> elements;
+            ScratchVector<Object> call;
+            while (zip.Next(&*call, 0)) {
+                elements.insert(elements.end(), call->begin(), call->end());
+            }
+            Ptr<Object> res = args[1];
+            call->resize(lists + 1);
+            for (size_t end = elements.size(); end > 0; end -= lists) {
+                std::move(elements.begin() + (end - lists), elements.begin() + end, call->begin());
+                (*call)[lists] = std::move(res);
+                res = callable->Apply(*call);
+            }
+            return res;
+        },
+        false, Arity::AtLeast("fold-right", 3));
+    bindings_["tmap"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            As<Callable>(args[0]);
+            return std::make_shared<Transducer>(false, args[0]);
+        }, false, Arity::Exactly("tmap", 1));
+    bindings_["tfilter"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            As<Callable>(args[0]);
+            return std::make_shared<Transducer>(true, args[0]);
+        }, false, Arity::Exactly("tfilter", 1));
+    // (list-transduce stages f init list) folds the elements of list coming out of stages, a
+    // transducer or a list of them applied first to last, like fold-left. Each element goes
+    // through every stage and f before the next one is read, so no intermediate list is built.
+    // Optimize fuses chains of map and filter this way only when every procedure is pure;
+    // list-transduce does it for any procedures, in this documented order.
+    bindings_["list-transduce"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            std::vector<Ptr<Transducer>> stages;
+            if (Is<Transducer>(args[0])) {
+                stages.push_back(As<Transducer>(args[0]));
+            } else {
+                for (Cell* cell = Walk(args[0], "list-transduce"); cell != nullptr;
+                     cell = Walk(cell->GetSecond(), "list-transduce")) {
+                    stages.push_back(As<Transducer>(cell->GetFirst()));
+                }
+            }
+            Callable* callable = As<Callable>(args[1]).get();
+            ScratchVector<Object> call;
+            Ptr<Object> res = args[2];
+            for (Cell* cell = Walk(args[3], "list-transduce"); cell != nullptr;
+                 cell = Walk(cell->GetSecond(), "list-transduce")) {
+                Ptr<Object> value = cell->GetFirst();
+                bool kept = true;
+                for (size_t i = 0; kept && i < stages.size(); ++i) {
+                    kept = stages[i]->Pass(&value, &*call);
+                }
+                if (kept) {
+                    *call = {std::move(res), std::move(value)};
+                    res = callable->Apply(*call);
+                }
+            }
+            return res;
+        },
+        false, Arity::Exactly("list-transduce", 4));
+    bindings_["assoc"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return Assoc<IsEqual>(args, "assoc");
+        }, false, Arity::Exactly("assoc", 2));
+    bindings_["assv"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return Assoc<IsEqv>(args, "assv");
+        }, false, Arity::Exactly("assv", 2));
+    bindings_["assq"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return Assoc<IsEq>(args, "assq");
+        }, false, Arity::Exactly("assq", 2));
+    bindings_["member"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return Member<IsEqual>(args, "member");
+        }, false, Arity::Exactly("member", 2));
+    bindings_["memv"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return Member<IsEqv>(args, "memv");
+        }, false, Arity::Exactly("memv", 2));
+    bindings_["memq"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return Member<IsEq>(args, "memq");
+        }, false, Arity::Exactly("memq", 2));
+}
@@ -0,0 +1,271 @@
+#include "scheme/native.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <initializer_list>
+
+#include "scheme/optimizer.h"
+
+namespace {
+
+bool IsArithmetic(FixnumOp::Op op) {
+    return op == FixnumOp::Op::ADD || op == FixnumOp::Op::SUB || op == FixnumOp::Op::MUL;
+}
+
+#if defined(__x86_64__)
+
+// Emits the few instructions fixnum trees need, for the System V calling convention of
+// NativeFixnum::Code: operands in rdi, result in rsi. A value is computed into eax; the left
+// operand of an operation waits on the stack while the right one is computed.
+class Assembler {
+public:
+    Assembler() {
+        // push rbp; mov rbp, rsp
+        Emit({0x55, 0x48, 0x89, 0xE5});
+    }
+
+    // mov eax, [rdi + 4 * index]
+    void LoadOperand(size_t index) {
+        Emit({0x8B, 0x87});
+        Emit32(static_cast<int32_t>(4 * index));
+    }
+    // mov eax, value
+    void LoadConstant(int32_t value) {
+        Emit({0xB8});
+        Emit32(value);
+    }
+    // push rax
+    void PushLhs() {
+        Emit({0x50});
+    }
+    // mov ecx, eax; pop rax
+    void PopLhs() {
+        Emit({0x89, 0xC1, 0x58});
+    }
+    // eax = eax op ecx; leaves through the overflow exit if the result does not fit.
+    void Arithmetic(FixnumOp::Op op) {
+        switch (op) {
+            case FixnumOp::Op::ADD:
+                Emit({0x01, 0xC8});
+                break;
+            case FixnumOp::Op::SUB:
+                Emit({0x29, 0xC8});
+                break;
+            default:
+                Emit({0x0F, 0xAF, 0xC1});
+                break;
+        }
+        // jo rel32, patched by Finish.
+        Emit({0x0F, 0x80});
+        overflows_.push_back(code_.size());
+        Emit32(0);
+    }
+    // eax = eax op ecx ? 1 : 0, signed.
+    void Compare(FixnumOp::Op op) {
+        uint8_t setcc = 0x94;
+        switch (op) {
+            case FixnumOp::Op::LESS:
+                setcc = 0x9C;
+                break;
+            case FixnumOp::Op::GREATER:
+                setcc = 0x9F;
+                break;
+            case FixnumOp::Op::LESS_EQUAL:
+                setcc = 0x9E;
+                break;
+            case FixnumOp::Op::GREATER_EQUAL:
+                setcc = 0x9D;
+                break;
+            default:
+                break;
+        }
+        // cmp eax, ecx; setcc al; movzx eax, al
+        Emit({0x39, 0xC8, 0x0F, setcc, 0xC0, 0x0F, 0xB6, 0xC0});
+    }
+
+    // Stores eax to the result and returns true, or false from the overflow exit.
+    std::vector<uint8_t> Finish() {
+        // mov [rsi], eax; mov eax, 1; mov rsp, rbp; pop rbp; ret
+        Emit({0x89, 0x06, 0xB8, 0x01, 0x00, 0x00, 0x00, 0x48, 0x89, 0xEC, 0x5D, 0xC3});
+        size_t exit = code_.size();
+        // xor eax, eax; mov rsp, rbp; pop rbp; ret
+        Emit({0x31, 0xC0, 0x48, 0x89, 0xEC, 0x5D, 0xC3});
+        for (size_t at : overflows_) {
+            auto offset = static_cast<int32_t>(exit - (at + 4));
+            std::memcpy(&code_[at], &offset, sizeof(offset));
+        }
+        return std::move(code_);
+    }
+
+private:
+    void Emit(std::initializer_list<uint8_t> bytes) {
+        code_.insert(code_.end(), bytes);
+    }
+    void Emit32(int32_t value) {
+        uint8_t bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        code_.insert(code_.end(), bytes, bytes + sizeof(bytes));
+    }
+
+    std::vector<uint8_t> code_;
+    // Offsets of the jumps to the overflow exit.
+    std::vector<size_t> overflows_;
+};
+
+// What the tree rooted at op needs to be compiled.
+struct Tree {
+    std::vector<Ptr<FixnumOp>> ops;
+    std::vector<int> slots;
+};
+
+// Returns false if the tree has anything but arithmetic on frame variables and constants below
+// its root.
+bool Collect(const Ptr<FixnumOp>& op, Tree* tree) {
+    tree->ops.push_back(op);
+    for (const Ptr<Object>& operand : {op->GetLhs(), op->GetRhs()}) {
+        if (auto inner = std::dynamic_pointer_cast<FixnumOp>(operand)) {
+            if (!IsArithmetic(inner->GetOp()) || !Collect(inner, tree)) {
+                return false;
+            }
+        } else if (auto local = std::dynamic_pointer_cast<LocalRef>(operand)) {
+            if (tree->slots.size() == kMaxNativeOperands) {
+                return false;
+            }
+            tree->slots.push_back(local->GetSlot());
+        } else if (!Is<Number>(operand)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Assemble(const Ptr<Object>& operand, Assembler* assembler, size_t* leaf) {
+    if (auto op = std::dynamic_pointer_cast<FixnumOp>(operand)) {
+        Assemble(op->GetLhs(), assembler, leaf);
+        assembler->PushLhs();
+        Assemble(op->GetRhs(), assembler, leaf);
+        assembler->PopLhs();
+        if (IsArithmetic(op->GetOp())) {
+            assembler->Arithmetic(op->GetOp());
+        } else {
+            assembler->Compare(op->GetOp());
+        }
+    } else if (Is<LocalRef>(operand)) {
+        assembler->LoadOperand((*leaf)++);
+    } else {
+        assembler->LoadConstant(As<Number>(operand)->GetValue());
+    }
+}
+
+// Copies code to pages of its own and makes them executable; nullptr if that fails.
+void* MapCode(const std::vector<uint8_t>& code, size_t* size) {
+    auto page = static_cast<size_t>(getpagesize());
+    *size = (code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, *size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, *size);
+        return nullptr;
+    }
+    return memory;
+}
+
+Ptr<Object> Compile(const Ptr<FixnumOp>& op) {
+    Tree tree;
+    if (!Collect(op, &tree)) {
+        return nullptr;
+    }
+    Assembler assembler;
+    size_t leaf = 0;
+    Assemble(op, &assembler, &leaf);
+    size_t size;
+    void* code = MapCode(assembler.Finish(), &size);
+    if (code == nullptr) {
+        return nullptr;
+    }
+    return std::make_shared<NativeFixnum>(op, std::move(tree.ops), std::move(tree.slots), code,
+                                          size);
+}
+
+#endif
+
+}  // namespace
+
+NativeFixnum::NativeFixnum(Ptr<FixnumOp> tree, std::vector<Ptr<FixnumOp>> ops,
+                           std::vector<int> slots, void* code, size_t size)
+    : tree_(std::move(tree)),
+      ops_(std::move(ops)),
+      slots_(std::move(slots)),
+      comparison_(!IsArithmetic(tree_->GetOp())),
+      code_(reinterpret_cast<Code>(code)),
+      size_(size) {
+}
+
+NativeFixnum::~NativeFixnum() {
+    munmap(reinterpret_cast<void*>(code_), size_);
+}
+
+Ptr<Object> NativeFixnum::Eval(Ptr<Environemnt> env) {
+    for (const Ptr<FixnumOp>& op : ops_) {
+        if (!op->Guard(env)) {
+            return Object::Eval(tree_, env);
+        }
+    }
+    int32_t operands[kMaxNativeOperands];
+    const std::vector<Ptr<Binding>>& frame = env->GetSlots();
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        const Binding& binding = *frame[slots_[i]];
+        auto* number = dynamic_cast<Number*>(binding.value.get());
+        if (!binding.defined || number == nullptr) {
+            // The tree reports an undefined variable the way the symbol does.
+            if (!ParallelSection::IsActive()) {
+                ++deopts_;
+            }
+            return Object::Eval(tree_, env);
+        }
+        operands[i] = number->GetValue();
+    }
+    int32_t result;
+    if (!code_(operands, &result)) {
+        if (!ParallelSection::IsActive()) {
+            ++deopts_;
+        }
+        return Object::Eval(tree_, env);
+    }
+    if (comparison_) {
+        return result != 0 ? true_ : false_;
+    }
+    return MakeNumber(result);
+}
+
+Ptr<Object> CompileNative(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    if (auto op = std::dynamic_pointer_cast<FixnumOp>(ast)) {
+#if defined(__x86_64__)
+        if (Ptr<Object> native = Compile(op)) {
+            return native;
+        }
+#endif
+        op->GetLhs() = CompileNative(op->GetLhs(), env);
+        op->GetRhs() = CompileNative(op->GetRhs(), env);
+        return ast;
+    }
+    if (auto access = std::dynamic_pointer_cast<PairAccess>(ast)) {
+        access->GetPair() = CompileNative(access->GetPair(), env);
+        return ast;
+    }
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        return ast;
+    }
+    for (Ptr<Object> cur = ExpressionArguments(cell, env); Is<Cell>(cur);
+         cur = As<Cell>(cur)->GetSecond()) {
+        Ptr<Object>& arg = As<Cell>(cur)->GetFirst();
+        arg = CompileNative(arg, env);
+    }
+    return ast;
+}
@@ -1,11 +1,162 @@
 #include "scheme/object.h"
+#include "scheme/lambda.h"
 #include "error.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <optional>
+#include <thread>
+
+namespace {
+std::atomic<uint64_t> next_environment_id = 1;
+
+std::atomic<size_t> parallelism = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+// Lists shorter than this are processed by parallel builtins on the calling thread: spawning
+// workers costs more than the work itself.
+constexpr size_t kSequentialCutoff = 2048;
+
+std::vector<Ptr<Object>> ListToVector(Ptr<Object> list, const std::string& name) {
+    std::vector<Ptr<Object>> res;
+    while (list != nullptr) {
+        auto* cell = dynamic_cast<Cell*>(list.get());
+        if (cell == nullptr) {
+            throw RuntimeError(name + " needs proper lists");
+        }
+        res.push_back(cell->GetFirst());
+        list = cell->GetSecond();
+    }
+    return res;
+}
+
+Ptr<Object> VectorToList(const std::vector<Ptr<Object>>& array) {
+    Ptr<Object> res = nullptr;
+    for (auto it = array.rbegin(); it != array.rend(); ++it) {
+        res = MakeCell(*it, res);
+    }
+    return res;
+}
+
+// Splits [0, size) into contiguous chunks and runs function(begin, end, chunk) for each of them,
+// at most threads of them. Chunks run on separate threads only when callable may be
+// applied concurrently and the input is large enough; returns the number of chunks. Workers run
+// under the limits Sandbox::ForWorkers gives.
+template <typename F>
+size_t RunInChunks(size_t size, size_t threads, const Ptr<Callable>& callable, F function) {
+    size_t chunks = 1;
+    if (callable->IsPure()) {
+        chunks = std::clamp<size_t>(size / kSequentialCutoff, 1, threads);
+    }
+    if (chunks == 1) {
+        function(0, size, 0);
+        return 1;
+    }
+    size_t step = (size + chunks - 1) / chunks;
+    ParallelSection section;
+    Limits limits = Sandbox::ForWorkers();
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < chunks; ++i) {
+        size_t begin = i * step;
+        size_t end = std::min(size, (i + 1) * step);
+        workers.push_back(std::async(std::launch::async, [&function, &limits, begin, end, i] {
+            ParallelSection section;
+            Sandbox sandbox{limits};
+            function(begin, end, i);
+        }));
+    }
+    function(0, step, 0);
+    for (std::future<void>& worker : workers) {
+        worker.get();
+    }
+    return chunks;
+}
+
+Ptr<Object> ParallelMap(const std::vector<Ptr<Object>>& args, const std::string& name) {
+    Ptr<Callable> callable = As<Callable>(args.front());
+    std::vector<Ptr<Object>> array = ListToVector(args.back(), name);
+    RunInChunks(array.size(), GetParallelism(), callable, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            array[i] = callable->Apply({array[i]});
+        }
+    });
+    return VectorToList(array);
+}
+
+// What (pure proc) returns: proc, declared to have no side effects. Nothing checks the
+// declaration; parallel builtins then apply proc from several threads at once, and the optimizer
+// may call it ahead of time or element by element (see Optimize).
+class PureProcedure : public Callable {
+public:
+    explicit PureProcedure(Ptr<Callable> procedure) : procedure_(std::move(procedure)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        return shared_from_this();
+    }
+    std::string ToString() override {
+        return procedure_->ToString();
+    }
+    Ptr<Object> Call(Ptr<Object> ast, Ptr<Environemnt> env) override {
+        return procedure_->Call(std::move(ast), std::move(env));
+    }
+    Ptr<Object> CallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) override {
+        return procedure_->CallTail(std::move(ast), std::move(env), tail);
+    }
+    Ptr<Object> Apply(const std::vector<Ptr<Object>>& args) override {
+        return procedure_->Apply(args);
+    }
+    Result<Ptr<Object>> TryCall(Ptr<Object> ast, Ptr<Environemnt> env) override {
+        return procedure_->TryCall(std::move(ast), std::move(env));
+    }
+    Result<Ptr<Object>> TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env,
+                                    TailCall* tail) override {
+        return procedure_->TryCallTail(std::move(ast), std::move(env), tail);
+    }
+    Result<Ptr<Object>> TryApply(const std::vector<Ptr<Object>>& args) override {
+        return procedure_->TryApply(args);
+    }
+    bool IsPure() const override {
+        return true;
+    }
+    ~PureProcedure() override = default;
+
+private:
+    Ptr<Callable> procedure_;
+};
+}  // namespace
+
+size_t GetParallelism() {
+    return parallelism.load(std::memory_order_relaxed);
+}
+void SetParallelism(size_t threads) {
+    parallelism.store(std::max<size_t>(threads, 1), std::memory_order_relaxed);
+}
+
 Ptr<Object> Object::Eval(Ptr<Object> ast, Ptr<Environemnt> env) {
     if (ast == nullptr) {
         throw RuntimeError("Empty list can not be evaluated");
     }
-    return ast->Eval(env);
+    // Straight to TryEval: a call through Cell::Eval would cost a frame more per nested call.
+    return ast->TryEval(std::move(env)).ValueOrThrow();
+}
+Ptr<Object> Object::EvalTail(const Ptr<Object>& ast, Ptr<Environemnt> env, TailCall* tail) {
+    if (ast == nullptr) {
+        throw RuntimeError("Empty list can not be evaluated");
+    }
+    return ast->TryEvalTail(std::move(env), tail).ValueOrThrow();
+}
+Result<Ptr<Object>> Object::TryEval(const Ptr<Object>& ast, Ptr<Environemnt> env) {
+    if (ast == nullptr) {
+        return Error{Error::Kind::RUNTIME, "Empty list can not be evaluated"};
+    }
+    return ast->TryEval(std::move(env));
+}
+Result<Ptr<Object>> Object::TryEvalTail(const Ptr<Object>& ast, Ptr<Environemnt> env,
+                                        TailCall* tail) {
+    if (ast == nullptr) {
+        return Error{Error::Kind::RUNTIME, "Empty list can not be evaluated"};
+    }
+    return ast->TryEvalTail(std::move(env), tail);
 }
 std::string Object::ToString(Ptr<Object> object) {
     if (object == nullptr) {
@@ -14,26 +165,117 @@ std::string Object::ToString(Ptr<Object> object) {
     return object->ToString();
 }
 Ptr<Object> Symbol::Eval(Ptr<Environemnt> env) {
-    return env->operator[](name_);
+    return TryEval(std::move(env)).ValueOrThrow();
+}
+Result<Ptr<Object>> Symbol::TryEval(Ptr<Environemnt> env) {
+    Binding* binding = Resolve(env.get());
+    if (binding == nullptr) {
+        return Error{Error::Kind::RUNTIME, "No defined entity in our current environment"};
+    }
+    return binding->value;
+}
+Binding* Symbol::Resolve(Environemnt* env) {
+    Environemnt* global = env->GetGlobal();
+    if (env->GetScopeId() != cached_scope_ || global->GetId() != cached_global_) {
+        int slot = env->FindSlot(name_);
+        Binding* binding = nullptr;
+        if (slot < 0) {
+            binding = global->Lookup(name_);
+            if (binding == nullptr) {
+                return nullptr;
+            }
+        }
+        if (ParallelSection::IsActive()) {
+            binding = slot < 0 ? binding : env->GetSlots()[slot].get();
+            return binding->defined ? binding : nullptr;
+        }
+        cached_scope_ = env->GetScopeId();
+        cached_global_ = global->GetId();
+        cached_slot_ = slot;
+        cached_binding_ = binding;
+    }
+    Binding* binding = cached_slot_ < 0 ? cached_binding_ : env->GetSlots()[cached_slot_].get();
+    if (!binding->defined) {
+        return nullptr;
+    }
+    return binding;
+}
+Shape::Shape() : id(next_environment_id.fetch_add(1, std::memory_order_relaxed)) {
+}
+int Shape::Find(const std::string& name) const {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+Environemnt::Environemnt() : id_(next_environment_id.fetch_add(1, std::memory_order_relaxed)) {
+}
+Environemnt::Environemnt(Ptr<const Shape> shape, Ptr<Environemnt> global)
+    : shape_(std::move(shape)), slots_(shape_->names.size()), global_(std::move(global)) {
+    Sandbox::Allocate(sizeof(Environemnt) + slots_.size() * sizeof(Binding));
 }
 Ptr<Object> Environemnt::Eval(Ptr<Environemnt> env) {
     return shared_from_this();
 }
 std::string Environemnt::ToString() {
     std::string res;
+    if (!IsGlobal()) {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            res += shape_->names[i];
+            res += " : ";
+            if (slots_[i] != nullptr && slots_[i]->defined) {
+                res += Object::ToString(slots_[i]->value);
+            }
+            res += '\n';
+        }
+        return res;
+    }
     for (const auto& [symbol, binding] : bindings_) {
         res += symbol;
         res += " : ";
-        res += Object::ToString(binding);
+        res += Object::ToString(binding.value);
         res += '\n';
     }
     return res;
 }
 Ptr<Object> Environemnt::operator[](const std::string& symbol) {
-    if (!bindings_.contains(symbol)) {
-        throw RuntimeError("No defined entity in our current environment");
+    return Find(symbol).ValueOrThrow();
+}
+Result<Ptr<Object>> Environemnt::Find(const std::string& symbol) {
+    Binding* binding = Lookup(symbol);
+    if (binding == nullptr) {
+        return Error{Error::Kind::RUNTIME, "No defined entity in our current environment"};
     }
-    return bindings_[symbol];
+    return binding->value;
+}
+Binding* Environemnt::Lookup(const std::string& symbol) {
+    if (!IsGlobal()) {
+        int slot = shape_->Find(symbol);
+        if (slot < 0) {
+            return global_->Lookup(symbol);
+        }
+        Binding* binding = slots_[slot].get();
+        return binding->defined ? binding : nullptr;
+    }
+    auto it = bindings_.find(symbol);
+    if (it == bindings_.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+void Environemnt::Define(const std::string& symbol, Ptr<Object> value) {
+    if (!IsGlobal()) {
+        int slot = shape_->Find(symbol);
+        if (slot < 0) {
+            throw SyntaxError("define is allowed only at the top level of a body");
+        }
+        *slots_[slot] = std::move(value);
+        return;
+    }
+    bindings_[symbol] = std::move(value);
+    ++version_;
 }
 void Environemnt::FullfillR5RS() {
     bindings_["+"] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
@@ -41,142 +283,126 @@ void Environemnt::FullfillR5RS() {
         for (Ptr<Number> ptr : args) {
             res += ptr->GetValue();
         }
-        return std::make_shared<Number>(res);
-    });
+        return MakeNumber(res);
+    }, true);
     bindings_["-"] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
-        if (args.empty()) {
-            throw RuntimeError("Too few arguments");
-        }
         int res = args.front()->GetValue();
         for (size_t i = 1; i < args.size(); ++i) {
             res -= args[i]->GetValue();
         }
-        return std::make_shared<Number>(res);
-    });
+        return MakeNumber(res);
+    }, true, Arity::AtLeast("-", 1));
     bindings_["*"] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
         int res = 1;
         for (Ptr<Number> ptr : args) {
             res *= ptr->GetValue();
         }
-        return std::make_shared<Number>(res);
-    });
+        return MakeNumber(res);
+    }, true);
     bindings_["/"] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
-        if (args.empty()) {
-            throw RuntimeError("Too few arguments");
-        }
         int res = args.front()->GetValue();
         for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i]->GetValue() == 0) {
+                throw RuntimeError("Division by zero");
+            }
             res /= args[i]->GetValue();
         }
-        return std::make_shared<Number>(res);
-    });
+        return MakeNumber(res);
+    }, true, Arity::AtLeast("/", 1));
     bindings_[">"] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
         for (size_t i = 1; i < args.size(); ++i) {
             if (args[i - 1]->GetValue() <= args[i]->GetValue()) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
         }
-        return std::make_shared<Boolean>(true);
-    });
+        return MakeBoolean(true);
+    }, true);
     bindings_["<"] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
         for (size_t i = 1; i < args.size(); ++i) {
             if (args[i - 1]->GetValue() >= args[i]->GetValue()) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
         }
-        return std::make_shared<Boolean>(true);
-    });
+        return MakeBoolean(true);
+    }, true);
     bindings_[">="] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
         for (size_t i = 1; i < args.size(); ++i) {
             if (args[i - 1]->GetValue() < args[i]->GetValue()) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
         }
-        return std::make_shared<Boolean>(true);
-    });
+        return MakeBoolean(true);
+    }, true);
     bindings_["<="] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
         for (size_t i = 1; i < args.size(); ++i) {
             if (args[i - 1]->GetValue() > args[i]->GetValue()) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
         }
-        return std::make_shared<Boolean>(true);
-    });
+        return MakeBoolean(true);
+    }, true);
     bindings_["="] = std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
         for (size_t i = 1; i < args.size(); ++i) {
             if (args[i - 1]->GetValue() != args[i]->GetValue()) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
         }
-        return std::make_shared<Boolean>(true);
-    });
+        return MakeBoolean(true);
+    }, true);
     bindings_["max"] =
         std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
-            if (args.empty()) {
-                throw RuntimeError("max should have at least 1 argument");
-            }
             int maximum = INT_MIN;
             for (const Ptr<Number>& ptr : args) {
                 maximum = std::max(maximum, ptr->GetValue());
             }
-            return std::make_shared<Number>(maximum);
-        });
+            return MakeNumber(maximum);
+        }, true, Arity::AtLeast("max", 1));
     bindings_["min"] =
         std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
-            if (args.empty()) {
-                throw RuntimeError("min should have at least 1 argument");
-            }
             int minimum = INT_MAX;
             for (const Ptr<Number>& ptr : args) {
                 minimum = std::min(minimum, ptr->GetValue());
             }
-            return std::make_shared<Number>(minimum);
-        });
+            return MakeNumber(minimum);
+        }, true, Arity::AtLeast("min", 1));
     bindings_["abs"] =
         std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
-            if (args.empty() || args.size() >= 2) {
-                throw RuntimeError("abs should have 1 argument");
-            }
-            return std::make_shared<Number>(abs(args.front()->GetValue()));
-        });
+            return MakeNumber(abs(args.front()->GetValue()));
+        }, true, Arity::Exactly("abs", 1));
     bindings_["number?"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 1) {
-                throw RuntimeError("number? should have exact 1 argument");
-            }
-            return std::make_shared<Boolean>(Is<Number>(args.front()));
-        });
+            return MakeBoolean(Is<Number>(args.front()));
+        }, true, Arity::Exactly("number?", 1));
     bindings_["boolean?"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 1) {
-                throw RuntimeError("number? should have exact 1 argument");
-            }
-            return std::make_shared<Boolean>(Is<Boolean>(args.front()));
-        });
-    bindings_["#t"] = std::make_shared<Boolean>(true);
-    bindings_["#f"] = std::make_shared<Boolean>(false);
+            return MakeBoolean(Is<Boolean>(args.front()));
+        }, true, Arity::Exactly("boolean?", 1));
+    bindings_["#t"] = MakeBoolean(true);
+    bindings_["#f"] = MakeBoolean(false);
     bindings_["quote"] = std::make_shared<Syntax>(
         [](Ptr<Object> ast, Ptr<Environemnt> env) { return As<Cell>(ast)->GetFirst(); });
+    bindings_["lambda"] = std::make_shared<Syntax>(EvalLambda);
+    bindings_["define"] = std::make_shared<Syntax>(EvalDefine);
+    bindings_["set!"] = std::make_shared<Syntax>(EvalSet);
+    bindings_["let"] = std::make_shared<Syntax>(EvalLet);
+    bindings_["if"] = std::make_shared<Syntax>(EvalIf);
     bindings_["not"] = std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>> args) {
-        if (args.size() != 1) {
-            throw RuntimeError("not must have exact one argument");
-        }
         if (Is<Boolean>(args.front())) {
-            return std::make_shared<Boolean>(!As<Boolean>(args.front())->var_);
+            return MakeBoolean(!As<Boolean>(args.front())->var_);
         }
-        return std::make_shared<Boolean>(false);
-    });
+        return MakeBoolean(false);
+    }, true, Arity::Exactly("not", 1));
     bindings_["and"] =
         std::make_shared<Syntax>([](Ptr<Object> ast, Ptr<Environemnt> env) -> Ptr<Object> {
             std::vector<Ptr<Object>> args = CollectArguments(ast);
             for (const Ptr<Object>& ptr : args) {
                 Ptr<Object> arg = Object::Eval(ptr, env);
                 if (Is<Boolean>(arg) && !As<Boolean>(arg)->var_) {
-                    return std::make_shared<Boolean>(false);
+                    return MakeBoolean(false);
                 }
             }
             if (args.empty()) {
-                return std::make_shared<Boolean>(true);
+                return MakeBoolean(true);
             }
             return Object::Eval(args.back(), env);
         });
@@ -186,78 +412,60 @@ void Environemnt::FullfillR5RS() {
             for (const Ptr<Object>& ptr : args) {
                 Ptr<Object> arg = Object::Eval(ptr, env);
                 if (Is<Boolean>(arg) && As<Boolean>(arg)->var_) {
-                    return std::make_shared<Boolean>(true);
+                    return MakeBoolean(true);
                 }
                 if (!Is<Boolean>(arg)) {
                     return Object::Eval(arg, env);
                 }
             }
-            return std::make_shared<Boolean>(false);
+            return MakeBoolean(false);
         });
     bindings_["pair?"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 1) {
-                throw RuntimeError("pair? should have at least one argument");
-            }
             Ptr<Object> arg = args.front();
             if (!Is<Cell>(arg)) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
-            return std::make_shared<Boolean>(true);
-        });
+            return MakeBoolean(true);
+        }, true, Arity::Exactly("pair?", 1));
     bindings_["null?"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 1) {
-                throw RuntimeError("null? should have at least one argument");
-            }
             Ptr<Object> arg = args.front();
             if (arg != nullptr) {
-                return std::make_shared<Boolean>(false);
+                return MakeBoolean(false);
             }
-            return std::make_shared<Boolean>(true);
-        });
+            return MakeBoolean(true);
+        }, true, Arity::Exactly("null?", 1));
     bindings_["list?"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 1) {
-                throw RuntimeError("list? should have at least one argument");
-            }
             Ptr<Object> arg = args.front();
 
             while (Is<Cell>(arg)) {
                 arg = As<Cell>(arg)->GetSecond();
             }
-            return std::make_shared<Boolean>(arg == nullptr);
-        });
+            return MakeBoolean(arg == nullptr);
+        }, true, Arity::Exactly("list?", 1));
     bindings_["cons"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 2) {
-                throw RuntimeError("cons must have at least 2 arguments");
-            }
-            return std::make_shared<Cell>(args.front(), args.back());
-        });
+            return MakeCell(args.front(), args.back());
+        }, false, Arity::Exactly("cons", 2));
     bindings_["car"] = std::make_shared<Procedure<Cell>>([](const std::vector<Ptr<Cell>>& args) {
-        if (args.size() != 1) {
-            throw RuntimeError("cons must have at least 2 arguments");
-        }
         return args.front()->GetFirst();
-    });
+    }, false, Arity::Exactly("car", 1));
     bindings_["cdr"] = std::make_shared<Procedure<Cell>>([](const std::vector<Ptr<Cell>>& args) {
-        if (args.size() != 1) {
-            throw RuntimeError("cons must have at least 2 arguments");
-        }
         return args.front()->GetSecond();
-    });
+    }, false, Arity::Exactly("cdr", 1));
     bindings_["list"] = std::make_shared<Procedure<Object>> ([](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
         if (args.empty()) {
             return nullptr;
         }
-        Ptr<Cell> next = std::make_shared<Cell>(nullptr, nullptr);
+        Ptr<Cell> next = MakeCell(nullptr, nullptr);
         Ptr<Cell> cur;
         Ptr<Cell> root = next;
         for (const Ptr<Object>& ptr : args) {
           cur = next;
           cur->GetFirst() = ptr;
-          next =  std::make_shared<Cell>(nullptr, nullptr);
+          next =  MakeCell(nullptr, nullptr);
           cur->GetSecond() = next;
         }
         cur->GetSecond() = nullptr;
@@ -265,51 +473,158 @@ void Environemnt::FullfillR5RS() {
     });
     bindings_["list-ref"] =
         std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
-            if (args.size() != 2) {
-                throw RuntimeError("list-ref must have exactly 2 arguments");
-            }
             if (!Is<Number>(args.back())) {
                 throw RuntimeError("Index in list-ref must be integer");
             }
             if (As<Number>(args.back())->GetValue() < 0) {
                 throw RuntimeError("Index in list-ref must be positive integer");
             }
-            std::vector<Ptr<Object>> array = CollectArguments(args.front());
-            if (As<Number>(args.back())->GetValue() >= array.size()) {
+            Ptr<Object> cur = args.front();
+            for (int i = As<Number>(args.back())->GetValue(); i > 0 && Is<Cell>(cur); --i) {
+                cur = As<Cell>(cur)->GetSecond();
+            }
+            if (!Is<Cell>(cur)) {
                 throw RuntimeError("Index out of bound in list-ref");
             }
-            return array[As<Number>(args.back())->GetValue()];
-        });
+            return As<Cell>(cur)->GetFirst();
+        }, false, Arity::Exactly("list-ref", 2));
     bindings_["list-tail"] =
-        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
-            if (args.size() != 2) {
-                throw RuntimeError("list-ref must have exactly 2 arguments");
-            }
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
             if (!Is<Number>(args.back())) {
                 throw RuntimeError("Index in list-ref must be integer");
             }
             if (As<Number>(args.back())->GetValue() < 0) {
                 throw RuntimeError("Index in list-ref must be positive integer");
             }
-          std::vector<Ptr<Object>> array = CollectArguments(args.front());
-          if (As<Number>(args.back())->GetValue() - array.size() == 0) {
-              return nullptr;
-          }
-          if (As<Number>(args.back())->GetValue() >= array.size()) {
-                throw RuntimeError("Index out of bound in list-ref");
+            Ptr<Object> cur = args.front();
+            for (int i = As<Number>(args.back())->GetValue(); i > 0; --i) {
+                if (!Is<Cell>(cur)) {
+                    throw RuntimeError("Index out of bound in list-ref");
+                }
+                cur = As<Cell>(cur)->GetSecond();
             }
-            Ptr<Cell> root = nullptr;
-            Ptr<Cell> cur = As<Cell>(args.front());
-            for (size_t i = 0; i <= As<Number>(args.back())->GetValue(); ++i) {
-                root = cur;
-                cur = As<Cell>(cur->GetSecond());
+            return cur;
+        }, false, Arity::Exactly("list-tail", 2));
+    // (pure f) declares f free of side effects. (parallel-map f list), (parallel-for-each f list)
+    // and (parallel-reduce f init list) split long lists between threads only for pure f: pure
+    // builtins such as abs, and procedures declared with pure.
+    bindings_["pure"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            if (Is<Syntax>(args[0])) {
+                throw RuntimeError("pure needs a procedure");
             }
-            return root;
-        });
+            return std::make_shared<PureProcedure>(As<Callable>(args[0]));
+        }, false, Arity::Exactly("pure", 1));
+    bindings_["parallel-map"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return ParallelMap(args, "parallel-map");
+        }, false, Arity::Exactly("parallel-map", 2));
+    bindings_["parallel-for-each"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            ParallelMap(args, "parallel-for-each");
+            return nullptr;
+        }, false, Arity::Exactly("parallel-for-each", 2));
+    // (parallel-reduce f init list): f must be associative, init is used once.
+    bindings_["parallel-reduce"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            Ptr<Callable> callable = As<Callable>(args[0]);
+            std::vector<Ptr<Object>> array = ListToVector(args[2], "parallel-reduce");
+            size_t threads = GetParallelism();
+            std::vector<std::optional<Ptr<Object>>> partial(threads);
+            auto reduce = [&](size_t begin, size_t end, size_t chunk) {
+                if (begin == end) {
+                    return;
+                }
+                Ptr<Object> accumulator = array[begin];
+                for (size_t i = begin + 1; i < end; ++i) {
+                    accumulator = callable->Apply({accumulator, array[i]});
+                }
+                partial[chunk] = accumulator;
+            };
+            size_t chunks = RunInChunks(array.size(), threads, callable, reduce);
+            Ptr<Object> res = args[1];
+            for (size_t i = 0; i < chunks; ++i) {
+                if (partial[i].has_value()) {
+                    res = callable->Apply({res, *partial[i]});
+                }
+            }
+            return res;
+        }, false, Arity::Exactly("parallel-reduce", 3));
+    FullfillLists();
+    FullfillEquality();
+    FullfillStrings();
+
+    for (const auto& [symbol, binding] : bindings_) {
+        builtins_[symbol] = binding.value;
+    }
+}
+Ptr<Object> Environemnt::GetBuiltin(const std::string& name) const {
+    const Environemnt* global = IsGlobal() ? this : global_.get();
+    auto it = global->builtins_.find(name);
+    return it == global->builtins_.end() ? nullptr : it->second;
 }
 std::shared_ptr<Object> Cell::Eval(Ptr<Environemnt> env) {
-    Ptr<Object> f = Object::Eval(GetFirst(), env);
-    return As<Callable>(f)->Call(GetSecond(), env);
+    return TryEval(std::move(env)).ValueOrThrow();
+}
+Ptr<Object> Cell::EvalTail(Ptr<Environemnt> env, TailCall* tail) {
+    return TryEvalTail(std::move(env), tail).ValueOrThrow();
+}
+Result<Ptr<Object>> Cell::TryEval(Ptr<Environemnt> env) {
+    Sandbox::Depth depth;
+    depth.Check();
+    Sandbox::Step();
+    Ptr<Object> callee;
+    Result<Callable*> callable = ResolveCallee(env, &callee);
+    if (!callable.IsOk()) {
+        return std::move(callable.GetError());
+    }
+    return callable.GetValue()->TryCall(GetSecond(), env);
+}
+Result<Ptr<Object>> Cell::TryEvalTail(Ptr<Environemnt> env, TailCall* tail) {
+    Sandbox::Depth depth;
+    depth.Check();
+    Sandbox::Step();
+    Ptr<Object> callee;
+    Result<Callable*> callable = ResolveCallee(env, &callee);
+    if (!callable.IsOk()) {
+        return std::move(callable.GetError());
+    }
+    return callable.GetValue()->TryCallTail(GetSecond(), env, tail);
+}
+Result<Callable*> Cell::ResolveCallee(const Ptr<Environemnt>& env, Ptr<Object>* callee) {
+    Environemnt* global = env->GetGlobal();
+    CallSite* site = GetSite();
+    if (site != nullptr && site->callable != nullptr && site->scope == env->GetScopeId() &&
+        site->global == global->GetId() && site->version == global->GetVersion()) {
+        // Keeps the callee alive even if the call itself rebinds its name.
+        *callee = site->callee;
+        return site->callable;
+    }
+    Result<Ptr<Object>> head = Object::TryEval(GetFirst(), env);
+    if (!head.IsOk()) {
+        return std::move(head.GetError());
+    }
+    *callee = std::move(head.GetValue());
+    auto* callable = dynamic_cast<Callable*>(callee->get());
+    if (callable == nullptr) {
+        return Error{Error::Kind::RUNTIME, "Types don't match"};
+    }
+    // Only a callee named by a global stays the same as long as globals are not rebound.
+    auto* symbol = dynamic_cast<Symbol*>(GetFirst().get());
+    if (site != nullptr && symbol != nullptr && symbol->IsResolvedGlobal() &&
+        !ParallelSection::IsActive()) {
+        site->scope = env->GetScopeId();
+        site->global = global->GetId();
+        site->version = global->GetVersion();
+        site->callee = *callee;
+        site->callable = callable;
+    }
+    return callable;
+}
+Cell::~Cell() {
+    // Dropping a long or deeply nested list does not recurse once per pair.
+    Reclaimer::Release(std::move(first_));
+    Reclaimer::Release(std::move(second_));
 }
 std::string Cell::ToString() {
     std::string res = "(";
@@ -350,6 +665,19 @@ std::vector<Ptr<Object>> CollectArguments(Ptr<Object> ast) {
     }
     return res;
 }
+Error Arity::Mismatch() const {
+    std::string message = std::string(name != nullptr ? name : "procedure") + " must have ";
+    if (max == 0) {
+        message += "no arguments";
+    } else if (min == max) {
+        message += "exactly " + std::to_string(min) + (min == 1 ? " argument" : " arguments");
+    } else if (max == kAny) {
+        message += "at least " + std::to_string(min) + (min == 1 ? " argument" : " arguments");
+    } else {
+        message += std::to_string(min) + " to " + std::to_string(max) + " arguments";
+    }
+    return Error{Error::Kind::RUNTIME, std::move(message)};
+}
 Ptr<Object> Syntax::Eval(Ptr<Environemnt> env) {
     return shared_from_this();
 }
@@ -357,5 +685,17 @@ std::string Syntax::ToString() {
     return "BuiltIn Syntax";
 }
 Ptr<Object> Syntax::Call(Ptr<Object> ast, Ptr<Environemnt> env) {
-    return function_(ast, env);
+    return function_(ast, env, nullptr);
+}
+Ptr<Object> Syntax::CallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) {
+    return function_(ast, env, tail);
+}
+Result<Ptr<Object>> Syntax::TryCall(Ptr<Object> ast, Ptr<Environemnt> env) {
+    return function_(std::move(ast), std::move(env), nullptr);
+}
+Result<Ptr<Object>> Syntax::TryCallTail(Ptr<Object> ast, Ptr<Environemnt> env, TailCall* tail) {
+    return function_(std::move(ast), std::move(env), tail);
+}
+Ptr<Object> Syntax::Apply(const std::vector<Ptr<Object>>& args) {
+    throw RuntimeError("Syntax can not be applied to evaluated arguments");
 }
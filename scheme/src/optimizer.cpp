@@ -0,0 +1,598 @@
+#include "scheme/optimizer.h"
+#include "scheme/text.h"
+
+#include <tuple>
+
+namespace {
+bool IsImmutable(const Ptr<Object>& value) {
+    return Is<Number>(value) || Is<Boolean>(value) || Is<String>(value);
+}
+
+bool IsSyntax(const Ptr<Object>& head, const Ptr<Object>& callee, const std::string& name) {
+    return Is<Syntax>(callee) && As<Symbol>(head)->GetName() == name;
+}
+
+bool IsQuote(const Ptr<Object>& head, const Ptr<Object>& callee) {
+    return IsSyntax(head, callee, "quote");
+}
+
+// Returns the first argument of a syntax call which is an expression, or nullptr if none are.
+Ptr<Object> SyntaxArguments(const Ptr<Cell>& cell, const Ptr<Object>& callee) {
+    const Ptr<Object>& head = cell->GetFirst();
+    if (IsSyntax(head, callee, "if") || IsSyntax(head, callee, "and") ||
+        IsSyntax(head, callee, "or")) {
+        return cell->GetSecond();
+    }
+    if (IsSyntax(head, callee, "define") || IsSyntax(head, callee, "set!")) {
+        auto args = std::dynamic_pointer_cast<Cell>(cell->GetSecond());
+        if (args != nullptr && Is<Symbol>(args->GetFirst())) {
+            return args->GetSecond();
+        }
+    }
+    return nullptr;
+}
+
+// Whether ast applies the builtin name, wherever it is bound now; if so stores the arguments.
+bool IsBuiltinCall(const Ptr<Object>& ast, const Ptr<Environemnt>& env, const std::string& name,
+                   std::vector<Ptr<Object>>* args) {
+    // Arguments are optimized first, so inner accesses may already be rewritten.
+    auto rewritten = std::dynamic_pointer_cast<Rewritten>(ast);
+    auto cell = std::dynamic_pointer_cast<Cell>(rewritten ? rewritten->GetOriginal() : ast);
+    if (cell == nullptr) {
+        return false;
+    }
+    Ptr<Object> callee = ResolveHead(cell->GetFirst(), env);
+    if (callee == nullptr || callee != env->GetBuiltin(name)) {
+        return false;
+    }
+    args->clear();
+    Ptr<Object> cur = cell->GetSecond();
+    while (Is<Cell>(cur)) {
+        args->push_back(As<Cell>(cur)->GetFirst());
+        cur = As<Cell>(cur)->GetSecond();
+    }
+    return cur == nullptr;
+}
+
+// Expressions of the elements of a list built by nested cons and list calls, and of its tail
+// if the innermost call is a cons.
+struct ListBuild {
+    std::vector<Ptr<Object>> elements;
+    Ptr<Object> tail;
+    bool has_tail = false;
+};
+
+bool ReadListBuild(Ptr<Object> ast, const Ptr<Environemnt>& env, ListBuild* build) {
+    std::vector<Ptr<Object>> args;
+    while (true) {
+        if (IsBuiltinCall(ast, env, "cons", &args) && args.size() == 2) {
+            build->elements.push_back(args[0]);
+            ast = args[1];
+            continue;
+        }
+        if (IsBuiltinCall(ast, env, "list", &args)) {
+            build->elements.insert(build->elements.end(), args.begin(), args.end());
+            return true;
+        }
+        if (build->elements.empty()) {
+            return false;
+        }
+        build->tail = ast;
+        build->has_tail = true;
+        return true;
+    }
+}
+
+// car, cdr, null? or pair? of a list built in place, after skipping index elements with cdr.
+// Evaluates every expression of the list in order, but allocates only the suffix cdr returns.
+class ListAccess : public Object {
+public:
+    enum class Kind { ELEMENT, SUFFIX, IS_NULL, IS_PAIR };
+
+    ListAccess(ListBuild build, size_t index, Kind kind)
+        : build_(std::move(build)), index_(index), kind_(kind) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        ScratchVector<Object> values;
+        for (const Ptr<Object>& element : build_.elements) {
+            values->push_back(Object::Eval(element, env));
+        }
+        Ptr<Object> tail = build_.has_tail ? Object::Eval(build_.tail, env) : nullptr;
+        size_t size = build_.elements.size();
+        switch (kind_) {
+            case Kind::ELEMENT:
+                return (*values)[index_];
+            case Kind::IS_NULL:
+                return MakeBoolean(index_ == size && tail == nullptr);
+            case Kind::IS_PAIR:
+                return MakeBoolean(index_ < size || Is<Cell>(tail));
+            case Kind::SUFFIX:
+                break;
+        }
+        for (size_t i = size; i > index_; --i) {
+            tail = MakeCell((*values)[i - 1], tail);
+        }
+        return tail;
+    }
+    std::string ToString() override {
+        return "List Access";
+    }
+    ~ListAccess() override = default;
+
+private:
+    ListBuild build_;
+    size_t index_;
+    Kind kind_;
+};
+
+std::optional<Ptr<Object>> RewriteListAccess(const Ptr<Cell>& cell, const Ptr<Environemnt>& env) {
+    static const std::pair<const char*, ListAccess::Kind> kAccessors[] = {
+        {"car", ListAccess::Kind::ELEMENT},
+        {"cdr", ListAccess::Kind::SUFFIX},
+        {"null?", ListAccess::Kind::IS_NULL},
+        {"pair?", ListAccess::Kind::IS_PAIR}};
+    std::vector<Ptr<Object>> args;
+    for (const auto& [name, kind] : kAccessors) {
+        if (!IsBuiltinCall(cell, env, name, &args) || args.size() != 1) {
+            continue;
+        }
+        size_t index = kind == ListAccess::Kind::SUFFIX ? 1 : 0;
+        Ptr<Object> list = args[0];
+        while (IsBuiltinCall(list, env, "cdr", &args) && args.size() == 1) {
+            ++index;
+            list = args[0];
+        }
+        ListBuild build;
+        if (!ReadListBuild(list, env, &build)) {
+            return std::nullopt;
+        }
+        // Past the elements the result depends on the value of the tail, except for cdr.
+        size_t size = build.elements.size();
+        if (index > size || (kind == ListAccess::Kind::ELEMENT && index == size)) {
+            return std::nullopt;
+        }
+        return std::make_shared<ListAccess>(std::move(build), index, kind);
+    }
+    return std::nullopt;
+}
+
+// A chain of map and filter calls over one list feeding fold-left, fold-right, for-each, length,
+// or a last map or filter. Each element goes through every stage before the next one is looked
+// at, so the lists the inner stages would build are never allocated. Every procedure of the chain
+// is pure, a pure builtin or one declared so with pure, so calling them element by element instead of stage by stage can not be
+// observed; when one of them fails, the unfused calls are made again to raise the error they
+// raise. Chains of other procedures can be fused explicitly with list-transduce.
+class ListPipeline : public Object {
+public:
+    enum class Sink { LIST, FOLD_LEFT, FOLD_RIGHT, FOR_EACH, LENGTH };
+
+    struct Stage {
+        bool filter;
+        Ptr<Object> procedure;
+    };
+
+    // stages go from the outermost call in; operands are the arguments of the sink before the
+    // list. builtins are map, filter and the sink's builtin, for the unfused calls.
+    ListPipeline(Sink sink, std::vector<Ptr<Object>> operands, std::vector<Stage> stages,
+                 Ptr<Object> list, std::vector<Ptr<Callable>> builtins)
+        : sink_(sink),
+          operands_(std::move(operands)),
+          stages_(std::move(stages)),
+          list_(std::move(list)),
+          builtins_(std::move(builtins)) {
+    }
+    Ptr<Object> Eval(Ptr<Environemnt> env) override {
+        ScratchVector<Object> operands;
+        for (const Ptr<Object>& operand : operands_) {
+            operands->push_back(Object::Eval(operand, env));
+        }
+        ScratchVector<Object> held;
+        for (const Stage& stage : stages_) {
+            held->push_back(Object::Eval(stage.procedure, env));
+        }
+        Ptr<Object> list = Object::Eval(list_, env);
+        try {
+            return Fused(*operands, *held, list);
+        } catch (const RuntimeError&) {
+            return Unfused(*operands, *held, std::move(list));
+        }
+    }
+    std::string ToString() override {
+        return "List Pipeline";
+    }
+    ~ListPipeline() override = default;
+
+private:
+    Ptr<Object> Fused(const std::vector<Ptr<Object>>& operands,
+                      const std::vector<Ptr<Object>>& held, const Ptr<Object>& list) {
+        std::vector<Callable*> procedures(held.size());
+        for (size_t i = 0; i < held.size(); ++i) {
+            procedures[i] = As<Callable>(held[i]).get();
+        }
+        Callable* sink = operands.empty() ? nullptr : As<Callable>(operands.front()).get();
+
+        Ptr<Object> acc = operands.size() > 1 ? operands[1] : nullptr;
+        Ptr<Object> res;
+        Cell* last = nullptr;
+        std::vector<Ptr<Object>> buffered;
+        size_t length = 0;
+        ScratchVector<Object> call;
+        for (Ptr<Object> cur = list; cur != nullptr;) {
+            auto* cell = dynamic_cast<Cell*>(cur.get());
+            if (cell == nullptr) {
+                throw RuntimeError("Pipeline needs proper lists");
+            }
+            Ptr<Object> value = cell->GetFirst();
+            cur = cell->GetSecond();
+            if (!Pass(procedures, &value, &call)) {
+                continue;
+            }
+            switch (sink_) {
+                case Sink::LIST: {
+                    Ptr<Cell> next = MakeCell(value, nullptr);
+                    if (last == nullptr) {
+                        res = next;
+                    } else {
+                        last->GetSecond() = next;
+                    }
+                    last = next.get();
+                    break;
+                }
+                case Sink::FOLD_LEFT:
+                    *call = {std::move(acc), std::move(value)};
+                    acc = sink->Apply(*call);
+                    break;
+                case Sink::FOLD_RIGHT:
+                    buffered.push_back(std::move(value));
+                    break;
+                case Sink::FOR_EACH:
+                    *call = {std::move(value)};
+                    sink->Apply(*call);
+                    break;
+                case Sink::LENGTH:
+                    ++length;
+                    break;
+            }
+        }
+        switch (sink_) {
+            case Sink::LIST:
+                return res;
+            case Sink::FOLD_LEFT:
+                return acc;
+            case Sink::FOLD_RIGHT:
+                for (size_t i = buffered.size(); i > 0; --i) {
+                    *call = {std::move(buffered[i - 1]), std::move(acc)};
+                    acc = sink->Apply(*call);
+                }
+                return acc;
+            case Sink::FOR_EACH:
+                return nullptr;
+            case Sink::LENGTH:
+                return MakeSize(length, "length");
+        }
+        return nullptr;
+    }
+
+    // Applies the builtins stage by stage, innermost first, as the original calls do.
+    Ptr<Object> Unfused(const std::vector<Ptr<Object>>& operands,
+                        const std::vector<Ptr<Object>>& held, Ptr<Object> list) {
+        // The outermost map or filter of a chain without a sink is the sink.
+        size_t outermost = sink_ == Sink::LIST ? 1 : 0;
+        for (size_t i = stages_.size(); i > outermost; --i) {
+            const Ptr<Callable>& builtin = stages_[i - 1].filter ? builtins_[1] : builtins_[0];
+            list = builtin->Apply({held[i - 1], std::move(list)});
+        }
+        if (sink_ == Sink::LIST) {
+            return builtins_[2]->Apply({held[0], std::move(list)});
+        }
+        std::vector<Ptr<Object>> call(operands);
+        call.push_back(std::move(list));
+        return builtins_[2]->Apply(call);
+    }
+
+    // Runs value through the stages, innermost first; false if a filter drops it.
+    bool Pass(const std::vector<Callable*>& procedures, Ptr<Object>* value,
+              ScratchVector<Object>* call) {
+        for (size_t i = stages_.size(); i > 0; --i) {
+            **call = {*value};
+            Ptr<Object> res = procedures[i - 1]->Apply(**call);
+            if (!stages_[i - 1].filter) {
+                *value = std::move(res);
+            } else if (Is<Boolean>(res) && !As<Boolean>(res)->var_) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Sink sink_;
+    std::vector<Ptr<Object>> operands_;
+    std::vector<Stage> stages_;
+    Ptr<Object> list_;
+    std::vector<Ptr<Callable>> builtins_;
+};
+
+// Whether ast names a procedure without side effects: a pure builtin, or one declared so with
+// pure.
+bool IsPureProcedure(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    auto callable = std::dynamic_pointer_cast<Callable>(ResolveHead(ast, env));
+    return callable != nullptr && callable->IsPure();
+}
+
+std::optional<Ptr<Object>> RewriteListPipeline(const Ptr<Cell>& cell,
+                                               const Ptr<Environemnt>& env) {
+    static const std::tuple<const char*, ListPipeline::Sink, size_t> kSinks[] = {
+        {"fold-left", ListPipeline::Sink::FOLD_LEFT, 3},
+        {"fold-right", ListPipeline::Sink::FOLD_RIGHT, 3},
+        {"for-each", ListPipeline::Sink::FOR_EACH, 2},
+        {"length", ListPipeline::Sink::LENGTH, 1},
+        {"map", ListPipeline::Sink::LIST, 2},
+        {"filter", ListPipeline::Sink::LIST, 2}};
+    std::vector<Ptr<Object>> args;
+    for (const auto& [name, sink, arity] : kSinks) {
+        if (!IsBuiltinCall(cell, env, name, &args) || args.size() != arity) {
+            continue;
+        }
+        std::vector<Ptr<Object>> operands;
+        std::vector<ListPipeline::Stage> stages;
+        if (sink == ListPipeline::Sink::LIST) {
+            stages.push_back({std::string(name) == "filter", args[0]});
+        } else {
+            operands.assign(args.begin(), args.end() - 1);
+        }
+        Ptr<Object> list = args.back();
+        while (true) {
+            if (IsBuiltinCall(list, env, "map", &args) && args.size() == 2) {
+                stages.push_back({false, args[0]});
+            } else if (IsBuiltinCall(list, env, "filter", &args) && args.size() == 2) {
+                stages.push_back({true, args[0]});
+            } else {
+                break;
+            }
+            list = args[1];
+        }
+        // A single map or filter has no intermediate list to save.
+        if (stages.size() < (sink == ListPipeline::Sink::LIST ? 2 : 1)) {
+            return std::nullopt;
+        }
+        bool pure = operands.empty() || IsPureProcedure(operands.front(), env);
+        for (const ListPipeline::Stage& stage : stages) {
+            pure = pure && IsPureProcedure(stage.procedure, env);
+        }
+        if (!pure) {
+            return std::nullopt;
+        }
+        std::vector<Ptr<Callable>> builtins;
+        for (const char* builtin : {"map", "filter", name}) {
+            builtins.push_back(std::dynamic_pointer_cast<Callable>(env->GetBuiltin(builtin)));
+        }
+        return std::make_shared<ListPipeline>(sink, std::move(operands), std::move(stages),
+                                              std::move(list), std::move(builtins));
+    }
+    return std::nullopt;
+}
+
+// ((lambda (params...) body...) args...) becomes (let ((param arg)...) body...), which runs the
+// body without creating a closure. The let builtin itself is put at the head, so that a local
+// variable named let can not capture it.
+std::optional<Ptr<Object>> RewriteImmediateLambda(const Ptr<Cell>& cell,
+                                                  const Ptr<Environemnt>& env) {
+    auto head = std::dynamic_pointer_cast<Cell>(cell->GetFirst());
+    if (head == nullptr) {
+        return std::nullopt;
+    }
+    Ptr<Object> lambda = ResolveHead(head->GetFirst(), env);
+    auto form = std::dynamic_pointer_cast<Cell>(head->GetSecond());
+    if (lambda == nullptr || lambda != env->GetBuiltin("lambda") || form == nullptr ||
+        form->GetSecond() == nullptr) {
+        return std::nullopt;
+    }
+    std::vector<Ptr<Object>> params;
+    Ptr<Object> cur = form->GetFirst();
+    for (; Is<Cell>(cur) && Is<Symbol>(As<Cell>(cur)->GetFirst()); cur = As<Cell>(cur)->GetSecond()) {
+        params.push_back(As<Cell>(cur)->GetFirst());
+    }
+    if (cur != nullptr) {
+        return std::nullopt;
+    }
+    std::vector<Ptr<Object>> args;
+    for (cur = cell->GetSecond(); Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        args.push_back(As<Cell>(cur)->GetFirst());
+    }
+    // A wrong number of arguments is left for the evaluator to report.
+    if (cur != nullptr || args.size() != params.size()) {
+        return std::nullopt;
+    }
+    Ptr<Object> bindings = nullptr;
+    for (size_t i = params.size(); i > 0; --i) {
+        auto binding = MakeFormCell(params[i - 1], MakeFormCell(args[i - 1], nullptr));
+        bindings = MakeFormCell(binding, bindings);
+    }
+    return MakeFormCell(env->GetBuiltin("let"), MakeFormCell(bindings, form->GetSecond()));
+}
+
+std::optional<Ptr<Object>> Rewrite(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        return std::nullopt;
+    }
+    if (Is<Cell>(cell->GetFirst())) {
+        return RewriteImmediateLambda(cell, env);
+    }
+    if (std::optional<Ptr<Object>> rewritten = RewriteListAccess(cell, env)) {
+        return rewritten;
+    }
+    return RewriteListPipeline(cell, env);
+}
+}  // namespace
+
+Ptr<Object> ResolveHead(const Ptr<Object>& head, const Ptr<Environemnt>& env) {
+    auto symbol = std::dynamic_pointer_cast<Symbol>(head);
+    if (symbol == nullptr || env->IsLocal(symbol->GetName())) {
+        return nullptr;
+    }
+    Binding* binding = env->Lookup(symbol->GetName());
+    if (binding == nullptr) {
+        return nullptr;
+    }
+    return binding->value;
+}
+
+Ptr<Object> ExpressionArguments(const Ptr<Cell>& cell, const Ptr<Environemnt>& env) {
+    if (Is<Cell>(cell->GetFirst())) {
+        return cell->GetSecond();
+    }
+    Ptr<Object> callee = ResolveHead(cell->GetFirst(), env);
+    if (Is<Syntax>(callee)) {
+        return SyntaxArguments(cell, callee);
+    }
+    return Is<Callable>(callee) ? cell->GetSecond() : nullptr;
+}
+
+Ptr<Object> Rewritten::Eval(Ptr<Environemnt> env) {
+    Ptr<Object> ast = Select(env);
+    return Object::Eval(ast, env);
+}
+
+Ptr<Object> Rewritten::EvalTail(Ptr<Environemnt> env, TailCall* tail) {
+    Ptr<Object> ast = Select(env);
+    return Object::EvalTail(ast, env, tail);
+}
+
+const Ptr<Object>& Rewritten::Select(const Ptr<Environemnt>& env) {
+    Environemnt* global = env->GetGlobal();
+    if (global->GetId() != env_id_ || global->GetVersion() != version_) {
+        if (ParallelSection::IsActive()) {
+            return original_;
+        }
+        rewritten_ = Rewrite(original_, env).value_or(nullptr);
+        env_id_ = global->GetId();
+        version_ = global->GetVersion();
+    }
+    return rewritten_ != nullptr ? rewritten_ : original_;
+}
+
+Ptr<Object> Constant::Eval(Ptr<Environemnt> env) {
+    Environemnt* global = env->GetGlobal();
+    if (global->GetId() == env_id_ && global->GetVersion() == version_) {
+        return value_;
+    }
+    if (std::optional<Ptr<Object>> value = Refresh(env)) {
+        return *value;
+    }
+    return Object::Eval(original_, env);
+}
+
+std::optional<Ptr<Object>> Constant::Refresh(const Ptr<Environemnt>& env) {
+    Environemnt* global = env->GetGlobal();
+    if (global->GetId() == env_id_ && global->GetVersion() == version_) {
+        return value_;
+    }
+    std::optional<Ptr<Object>> value = Fold(original_, env);
+    if (value.has_value() && !ParallelSection::IsActive()) {
+        value_ = *value;
+        env_id_ = global->GetId();
+        version_ = global->GetVersion();
+    }
+    return value;
+}
+
+std::optional<Ptr<Object>> Fold(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    if (IsImmutable(ast)) {
+        return ast;
+    }
+    if (auto constant = std::dynamic_pointer_cast<Constant>(ast)) {
+        return constant->Refresh(env);
+    }
+    if (auto symbol = std::dynamic_pointer_cast<Symbol>(ast)) {
+        if (env->IsLocal(symbol->GetName())) {
+            return std::nullopt;
+        }
+        Binding* binding = env->Lookup(symbol->GetName());
+        if (binding == nullptr || !IsImmutable(binding->value)) {
+            return std::nullopt;
+        }
+        return binding->value;
+    }
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        return std::nullopt;
+    }
+    Ptr<Object> callee = ResolveHead(cell->GetFirst(), env);
+    if (callee == nullptr) {
+        return std::nullopt;
+    }
+    if (IsQuote(cell->GetFirst(), callee)) {
+        auto args = std::dynamic_pointer_cast<Cell>(cell->GetSecond());
+        if (args == nullptr || args->GetSecond() != nullptr) {
+            return std::nullopt;
+        }
+        return args->GetFirst();
+    }
+    auto callable = std::dynamic_pointer_cast<Callable>(callee);
+    if (callable == nullptr || !callable->IsPure()) {
+        return std::nullopt;
+    }
+    std::vector<Ptr<Object>> values;
+    Ptr<Object> cur = cell->GetSecond();
+    while (cur != nullptr) {
+        auto arg = std::dynamic_pointer_cast<Cell>(cur);
+        if (arg == nullptr) {
+            return std::nullopt;
+        }
+        std::optional<Ptr<Object>> value = Fold(arg->GetFirst(), env);
+        if (!value.has_value()) {
+            return std::nullopt;
+        }
+        values.push_back(*value);
+        cur = arg->GetSecond();
+    }
+    try {
+        Ptr<Object> res = callable->Apply(values);
+        if (!IsImmutable(res)) {
+            return std::nullopt;
+        }
+        return res;
+    } catch (const RuntimeError&) {
+        // Left for the evaluator, which reports the error when (and if) the call is reached.
+        return std::nullopt;
+    }
+}
+
+Ptr<Object> Optimize(const Ptr<Object>& ast, const Ptr<Environemnt>& env) {
+    auto cell = std::dynamic_pointer_cast<Cell>(ast);
+    if (cell == nullptr) {
+        return ast;
+    }
+    if (Is<Cell>(cell->GetFirst())) {
+        for (Ptr<Object> cur = cell->GetSecond(); Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+            Ptr<Object>& arg = As<Cell>(cur)->GetFirst();
+            arg = Optimize(arg, env);
+        }
+        if (std::optional<Ptr<Object>> rewritten = RewriteImmediateLambda(cell, env)) {
+            return std::make_shared<Rewritten>(*rewritten, ast, env.get());
+        }
+        return ast;
+    }
+    Ptr<Object> callee = ResolveHead(cell->GetFirst(), env);
+    auto callable = std::dynamic_pointer_cast<Callable>(callee);
+    if (callable == nullptr) {
+        return ast;
+    }
+    Ptr<Object> args = Is<Syntax>(callable) ? SyntaxArguments(cell, callee) : cell->GetSecond();
+    for (Ptr<Object> cur = args; Is<Cell>(cur); cur = As<Cell>(cur)->GetSecond()) {
+        Ptr<Object>& arg = As<Cell>(cur)->GetFirst();
+        arg = Optimize(arg, env);
+    }
+    if (Is<Syntax>(callable) && !IsQuote(cell->GetFirst(), callee)) {
+        return ast;
+    }
+    std::optional<Ptr<Object>> value = Fold(ast, env);
+    if (value.has_value()) {
+        return std::make_shared<Constant>(*value, ast, env.get());
+    }
+    if (std::optional<Ptr<Object>> rewritten = Rewrite(ast, env)) {
+        return std::make_shared<Rewritten>(*rewritten, ast, env.get());
+    }
+    return ast;
+}
@@ -0,0 +1,174 @@
+#include "scheme/parallel_reader.h"
+#include "scheme/binary.h"
+#include "scheme/parser.h"
+#include "scheme/text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <future>
+#include <istream>
+#include <optional>
+#include <thread>
+
+namespace {
+
+constexpr size_t kBlockSize = 64;
+// Chunks per thread, so that threads done early take over the rest.
+constexpr size_t kChunksPerThread = 4;
+
+struct Block {
+    int64_t depth;
+    bool has_string;
+};
+
+// Straight-line counting the compiler turns into vector instructions.
+Block ScanBlock(const char* data) {
+    int open = 0;
+    int close = 0;
+    int quotes = 0;
+    for (size_t i = 0; i < kBlockSize; ++i) {
+        open += data[i] == '(';
+        close += data[i] == ')';
+        quotes += data[i] == '"';
+    }
+    return {open - close, quotes != 0};
+}
+
+bool IsSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+// Position right after the string literal starting at pos, or the end of text if it is not
+// terminated.
+size_t StringEnd(std::string_view text, size_t pos) {
+    for (++pos; pos < text.size(); ++pos) {
+        if (text[pos] == '\\') {
+            ++pos;
+        } else if (text[pos] == '"') {
+            return pos + 1;
+        }
+    }
+    return text.size();
+}
+
+// Whether the blank at pos, at the top level, separates two data: it does not if it follows
+// the quote of a datum.
+bool Separates(std::string_view text, size_t begin, size_t pos) {
+    while (pos > begin && IsSpace(text[pos - 1])) {
+        --pos;
+    }
+    return pos > begin && text[pos - 1] != '\'';
+}
+
+// Places between top-level data about step bytes apart, starting with 0 and ending with the
+// size of text. Text after a bracket closing nothing is not cut, reading it fails anyway.
+std::vector<size_t> Boundaries(std::string_view text, size_t step) {
+    std::vector<size_t> cuts = {0};
+    int64_t depth = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t target = cuts.back() + step;
+        if (pos + kBlockSize <= std::min(target, text.size())) {
+            Block block = ScanBlock(text.data() + pos);
+            if (!block.has_string) {
+                depth += block.depth;
+                pos += kBlockSize;
+                continue;
+            }
+        }
+        for (size_t end = std::min(pos + kBlockSize, text.size()); pos < end;) {
+            char c = text[pos];
+            if (c == '"') {
+                pos = StringEnd(text, pos);
+                continue;
+            }
+            if (c == '(') {
+                ++depth;
+            } else if (c == ')') {
+                --depth;
+            } else if (depth == 0 && pos >= target && IsSpace(c) &&
+                       Separates(text, cuts.back(), pos)) {
+                cuts.push_back(pos);
+                target = pos + step;
+            }
+            ++pos;
+        }
+    }
+    cuts.push_back(text.size());
+    return cuts;
+}
+
+struct Chunk {
+    std::vector<Ptr<Object>> data;
+    std::optional<Error> error;
+};
+
+void ReadChunk(std::string_view text, Chunk* chunk) {
+    ViewBuffer buffer;
+    buffer.Reset(text);
+    std::istream stream(&buffer);
+    Tokenizer tokenizer(&stream);
+    while (!tokenizer.IsEnd()) {
+        auto datum = TryReadDatum(&tokenizer);
+        if (!datum.IsOk()) {
+            chunk->error = std::move(datum.GetError());
+            return;
+        }
+        chunk->data.push_back(std::move(datum.GetValue()));
+    }
+}
+
+}  // namespace
+
+std::vector<Ptr<Object>> ReadParallel(std::string_view text, size_t threads) {
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    size_t count = std::clamp<size_t>(text.size() / kMinChunkSize, 1, threads * kChunksPerThread);
+    std::vector<size_t> cuts = Boundaries(text, (text.size() + count - 1) / count);
+    std::vector<Chunk> chunks(cuts.size() - 1);
+
+    std::atomic<size_t> next = 0;
+    auto work = [&] {
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            ReadChunk(text.substr(cuts[i], cuts[i + 1] - cuts[i]), &chunks[i]);
+        }
+    };
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < std::min(threads, chunks.size()); ++i) {
+        workers.push_back(std::async(std::launch::async, work));
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    std::vector<Ptr<Object>> res;
+    for (Chunk& chunk : chunks) {
+        std::move(chunk.data.begin(), chunk.data.end(), std::back_inserter(res));
+        if (chunk.error.has_value()) {
+            chunk.error->Raise();
+        }
+    }
+    return res;
+}
+
+void InstallLoadAllData(Environemnt* env) {
+    env->Define("load-all-data", std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            std::string path;
+            if (auto* string = dynamic_cast<String*>(args.front().get())) {
+                path = string->GetText();
+            } else {
+                path = As<Symbol>(args.front())->GetName();
+            }
+            std::vector<Ptr<Object>> data = ReadParallel(MappedFile(path).GetData());
+            Ptr<Object> res = nullptr;
+            for (auto it = data.rbegin(); it != data.rend(); ++it) {
+                res = MakeCell(std::move(*it), std::move(res));
+            }
+            return res;
+        },
+        false, Arity::Exactly("load-all-data", 1)));
+}
@@ -0,0 +1,112 @@
+#include "scheme/parse_cache.h"
+#include "scheme/hash_cons.h"
+#include "scheme/optimizer.h"
+
+namespace {
+// Copies the pairs of datum; atoms are immutable and shared.
+Ptr<Object> CopyDatum(const Ptr<Object>& datum) {
+    auto cell = std::dynamic_pointer_cast<Cell>(datum);
+    if (cell == nullptr) {
+        return datum;
+    }
+    auto root = MakeCell(CopyDatum(cell->GetFirst()), nullptr);
+    Ptr<Cell> tail = root;
+    for (Ptr<Object> cur = cell->GetSecond();; cur = As<Cell>(cur)->GetSecond()) {
+        if (!Is<Cell>(cur)) {
+            tail->GetSecond() = cur;
+            break;
+        }
+        auto next = MakeCell(CopyDatum(As<Cell>(cur)->GetFirst()), nullptr);
+        tail->GetSecond() = next;
+        tail = next;
+    }
+    return root;
+}
+
+// Whether cell is (quote datum) with a list for datum. Whatever quote is bound to: copying an
+// expression which is not data only costs its in-place caches.
+Cell* QuotedList(Cell* cell) {
+    auto* head = dynamic_cast<Symbol*>(cell->GetFirst().get());
+    auto* args = dynamic_cast<Cell*>(cell->GetSecond().get());
+    if (head == nullptr || head->GetName() != "quote" || args == nullptr ||
+        !Is<Cell>(args->GetFirst())) {
+        return nullptr;
+    }
+    return args;
+}
+}  // namespace
+
+std::optional<Ptr<Object>> ParseCache::Lookup(std::string_view source) {
+    if (capacity_ == 0) {
+        return std::nullopt;
+    }
+    auto it = index_.find(std::hash<std::string_view>{}(source));
+    if (it == index_.end() || it->second->source != source) {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    Entry& entry = entries_.front();
+    for (const Literal& literal : entry.literals) {
+        Ptr<Object> copy = CopyDatum(literal.datum);
+        As<Cell>(literal.quote->GetSecond())->GetFirst() = copy;
+        if (literal.constant != nullptr) {
+            literal.constant->Reset(std::move(copy));
+        }
+    }
+    return entry.form;
+}
+
+void ParseCache::Insert(std::string_view source, const Ptr<Object>& form) {
+    if (capacity_ == 0) {
+        return;
+    }
+    size_t hash = std::hash<std::string_view>{}(source);
+    if (auto it = index_.find(hash); it != index_.end()) {
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+    Entry entry{hash, std::string(source), form, {}};
+    auto add_literal = [&entry](const Ptr<Cell>& quote, Constant* constant) {
+        // Interned data is immutable, and shared instead of copied.
+        Ptr<Object>& datum = As<Cell>(quote->GetSecond())->GetFirst();
+        if (!Is<ConsedCell>(datum)) {
+            entry.literals.push_back({quote, CopyDatum(datum), constant});
+        }
+    };
+    // Quoted data is not looked into: a quote inside it is data itself.
+    std::vector<Ptr<Object>> stack = {form};
+    while (!stack.empty()) {
+        Ptr<Object> cur = std::move(stack.back());
+        stack.pop_back();
+        if (auto* constant = dynamic_cast<Constant*>(cur.get())) {
+            auto quote = std::dynamic_pointer_cast<Cell>(constant->GetOriginal());
+            if (quote != nullptr && QuotedList(quote.get()) != nullptr) {
+                add_literal(quote, constant);
+            } else {
+                stack.push_back(constant->GetOriginal());
+            }
+        } else if (auto* rewritten = dynamic_cast<Rewritten*>(cur.get())) {
+            stack.push_back(rewritten->GetOriginal());
+        } else if (auto cell = std::dynamic_pointer_cast<Cell>(cur)) {
+            if (QuotedList(cell.get()) != nullptr) {
+                add_literal(cell, nullptr);
+            } else {
+                stack.push_back(cell->GetFirst());
+                stack.push_back(cell->GetSecond());
+            }
+        }
+    }
+    entries_.push_front(std::move(entry));
+    index_[hash] = entries_.begin();
+    SetCapacity(capacity_);
+}
+
+void ParseCache::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().hash);
+        entries_.pop_back();
+    }
+}
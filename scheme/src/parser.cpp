@@ -1,67 +1,146 @@
 #include <scheme/parser.h>
+#include <scheme/text.h>
 #include <error.h>
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer) {
+#include <optional>
+
+namespace {
+// MakeFormCell for source, MakeCell for data.
+using MakePair = Ptr<Cell> (*)(const Ptr<Object>&, const Ptr<Object>&);
+
+Error Malformed(const char* message) {
+    return Error{Error::Kind::SYNTAX, message};
+}
+
+// Counts a datum read as a step of the sandbox, so that reading obeys its time limit and its
+// interrupt like evaluation does.
+std::optional<Error> Step() {
+    try {
+        Sandbox::Step();
+    } catch (LimitError& e) {
+        return Error{Error::Kind::LIMIT, e.what()};
+    }
+    return std::nullopt;
+}
+
+Result<std::shared_ptr<Object>> ReadListWith(Tokenizer* tokenizer, MakePair make);
+
+Result<std::shared_ptr<Object>> ReadWith(Tokenizer* tokenizer, MakePair make) {
+    if (std::optional<Error> error = Step()) {
+        return std::move(*error);
+    }
     if (tokenizer->IsEnd()) {
-        throw SyntaxError("Read reached the end, but not Close Bracket found");
+        return Malformed("Read reached the end, but not Close Bracket found");
     }
     auto token = tokenizer->GetToken();
     tokenizer->Next();
     if (token == Token{BracketToken::OPEN}) {
-        return ReadList(tokenizer);
+        return ReadListWith(tokenizer, make);
     }
     if (token == Token{BracketToken::CLOSE}) {
-        throw SyntaxError("No matching open bracket");
+        return Malformed("No matching open bracket");
     }
     if (auto* ptr = get_if<ConstantToken>(&token)) {
-        return std::make_shared<Number>(ptr->value);
+        return std::shared_ptr<Object>(MakeNumber(ptr->value));
     }
     if (auto* ptr = get_if<SymbolToken>(&token)) {
-        return std::make_shared<Symbol>(ptr->name);
+        return std::shared_ptr<Object>(std::make_shared<Symbol>(ptr->name));
+    }
+    if (auto* ptr = get_if<StringToken>(&token)) {
+        if (!ptr->terminated) {
+            return Malformed("Read reached the end inside a string");
+        }
+        return std::shared_ptr<Object>(MakeString(std::move(ptr->value)));
+    }
+    if (auto* ptr = get_if<InvalidToken>(&token)) {
+        return Error{Error::Kind::SYNTAX, std::move(ptr->message)};
     }
     if (auto* ptr = get_if<DotToken>(&token)) {
-        throw SyntaxError("Dot should be before last element of list");
+        return Malformed("Dot should be before last element of list");
     }
     if (auto* ptr = get_if<QuoteToken>(&token)) {
-        return std::make_shared<Cell>(std::make_shared<Symbol>("quote"),
-                                      std::make_shared<Cell>(Read(tokenizer), nullptr));
+        auto quoted = ReadWith(tokenizer, make);
+        if (!quoted.IsOk()) {
+            return quoted;
+        }
+        return std::shared_ptr<Object>(
+            make(std::make_shared<Symbol>("quote"), make(std::move(quoted.GetValue()), nullptr)));
     }
-    throw SyntaxError("exception in Read");
+    return Malformed("exception in Read");
 }
 
-std::shared_ptr<Object> ReadList(Tokenizer* tokenizer) {
-    std::shared_ptr<Cell> cell = std::make_shared<Cell>(nullptr, nullptr);
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("ReadList reached the end, but not Close Bracket found");
+Result<std::shared_ptr<Object>> ReadListWith(Tokenizer* tokenizer, MakePair make) {
+    Sandbox::Depth depth;
+    if (depth.IsExceeded()) {
+        return Error{Error::Kind::LIMIT, "Maximum depth exceeded"};
     }
-    Token token = tokenizer->GetToken();
-    if (auto* ptr = std::get_if<BracketToken>(&token)) {
-        if (*ptr == BracketToken::CLOSE) {
+    // Builds the list front to back through a tail pointer, so long lists do not grow the stack.
+    std::shared_ptr<Object> root = nullptr;
+    std::shared_ptr<Cell> tail = nullptr;
+    while (true) {
+        if (tokenizer->IsEnd()) {
+            return Malformed("ReadList reached the end, but not Close Bracket found");
+        }
+        Token token = tokenizer->GetToken();
+        if (auto* ptr = std::get_if<BracketToken>(&token)) {
+            if (*ptr == BracketToken::CLOSE) {
+                tokenizer->Next();
+                return root;
+            }
+        }
+        if (tail != nullptr && get_if<DotToken>(&token)) {
+            tokenizer->Next();
+            auto last = ReadWith(tokenizer, make);
+            if (!last.IsOk()) {
+                return last;
+            }
+            tail->GetSecond() = std::move(last.GetValue());
+            if (tokenizer->IsEnd()) {
+                return Malformed("ReadList reached the end, but not Close Bracket found");
+            }
+            token = tokenizer->GetToken();
+            auto* p = get_if<BracketToken>(&token);
+            if (p == nullptr || *p != BracketToken::CLOSE) {
+                return Malformed("No closing bracket in pair");
+            }
             tokenizer->Next();
-            return nullptr;
+            return root;
         }
-    }
-    Ptr<Object> first = Read(tokenizer);
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("ReadList reached the end, but not Close Bracket found");
-    }
-    token = tokenizer->GetToken();
-    if (auto* ptr = get_if<DotToken>(&token)) {
-        tokenizer->Next();
-        cell->GetSecond() = Read(tokenizer);
-        if (tokenizer->IsEnd()) {
-            throw SyntaxError("ReadList reached the end, but not Close Bracket found");
+        auto element = ReadWith(tokenizer, make);
+        if (!element.IsOk()) {
+            return element;
         }
-        token = tokenizer->GetToken();
-        auto* p = get_if<BracketToken>(&token);
-        if (p == nullptr || *p != BracketToken::CLOSE) {
-            throw SyntaxError("No closing bracket in pair");
+        std::shared_ptr<Cell> cell = make(std::move(element.GetValue()), nullptr);
+        if (tail == nullptr) {
+            root = cell;
+        } else {
+            tail->GetSecond() = cell;
         }
-        tokenizer->Next();
-        cell->GetFirst() = first;
-        return cell;
+        tail = cell;
     }
-    cell->GetFirst() = first;
-    cell->GetSecond() = ReadList(tokenizer);
-    return cell;
+}
+}  // namespace
+
+std::shared_ptr<Object> Read(Tokenizer* tokenizer) {
+    return TryRead(tokenizer).ValueOrThrow();
+}
+
+std::shared_ptr<Object> ReadList(Tokenizer* tokenizer) {
+    return TryReadList(tokenizer).ValueOrThrow();
+}
+
+std::shared_ptr<Object> ReadDatum(Tokenizer* tokenizer) {
+    return TryReadDatum(tokenizer).ValueOrThrow();
+}
+
+Result<std::shared_ptr<Object>> TryRead(Tokenizer* tokenizer) {
+    return ReadWith(tokenizer, MakeFormCell);
+}
+
+Result<std::shared_ptr<Object>> TryReadList(Tokenizer* tokenizer) {
+    return ReadListWith(tokenizer, MakeFormCell);
+}
+
+Result<std::shared_ptr<Object>> TryReadDatum(Tokenizer* tokenizer) {
+    return ReadWith(tokenizer, MakeCell);
 }
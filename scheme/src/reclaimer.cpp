@@ -0,0 +1,50 @@
+#include "scheme/reclaimer.h"
+#include "scheme/object.h"
+
+#include <vector>
+
+struct Reclaimer::Queue {
+    // Destroys what is still waiting; pairs dropped after that are destroyed right away.
+    ~Queue() {
+        Collect();
+        local.exited = true;
+    }
+
+    std::vector<Ptr<Object>> objects;
+};
+
+constinit thread_local Reclaimer::Local Reclaimer::local;
+
+Reclaimer::Queue& Reclaimer::GetQueue() {
+    thread_local Queue queue;
+    return queue;
+}
+
+void Reclaimer::Release(Ptr<Object>&& object) {
+    if (object == nullptr || object.use_count() != 1 || local.exited ||
+        dynamic_cast<Cell*>(object.get()) == nullptr) {
+        object.reset();
+        return;
+    }
+    GetQueue().objects.push_back(std::move(object));
+    ++local.pending;
+    if (!local.collecting) {
+        Collect(local.budget);
+    }
+}
+
+size_t Reclaimer::Collect(size_t budget) {
+    auto& objects = GetQueue().objects;
+    bool collecting = local.collecting;
+    local.collecting = true;
+    for (size_t destroyed = 0; !objects.empty() && (budget == 0 || destroyed < budget);
+         ++destroyed) {
+        // Taken off the queue first: destroying it queues its car and cdr.
+        Ptr<Object> object = std::move(objects.back());
+        objects.pop_back();
+        --local.pending;
+        object.reset();
+    }
+    local.collecting = collecting;
+    return objects.size();
+}
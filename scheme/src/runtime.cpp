@@ -0,0 +1,115 @@
+#include "scheme/runtime.h"
+#include "scheme/scheme.h"
+
+#include <cstdint>
+
+namespace {
+// The worker running on the current thread, used to keep tasks submitted from inside a worker
+// local to it. Its index is only meaningful to the runtime owning it.
+struct CurrentWorker {
+    const Runtime* runtime = nullptr;
+    size_t index = SIZE_MAX;
+};
+thread_local CurrentWorker current_worker;
+}  // namespace
+
+Runtime::Runtime(size_t workers_count) {
+    if (workers_count == 0) {
+        workers_count = 1;
+    }
+    workers_.reserve(workers_count);
+    for (size_t i = 0; i < workers_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workers_count; ++i) {
+        workers_[i]->thread = std::thread([this, i] { Loop(i); });
+    }
+}
+
+Runtime::~Runtime() {
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (const auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+std::future<std::string> Runtime::Submit(std::string expression) {
+    Task task{std::move(expression), {}};
+    std::future<std::string> result = task.promise.get_future();
+    size_t index = current_worker.index;
+    if (current_worker.runtime != this) {
+        index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    {
+        std::lock_guard lock(sleep_mutex_);
+        {
+            std::lock_guard worker_lock(workers_[index]->mutex);
+            workers_[index]->tasks.push_back(std::move(task));
+        }
+        ++pending_;
+    }
+    wake_.notify_one();
+    return result;
+}
+
+std::optional<Runtime::Task> Runtime::Pop(size_t index) {
+    std::optional<Task> task;
+    {
+        std::lock_guard lock(workers_[index]->mutex);
+        if (workers_[index]->tasks.empty()) {
+            return std::nullopt;
+        }
+        task = std::move(workers_[index]->tasks.back());
+        workers_[index]->tasks.pop_back();
+    }
+    std::lock_guard lock(sleep_mutex_);
+    --pending_;
+    return task;
+}
+
+std::optional<Runtime::Task> Runtime::Steal(size_t thief) {
+    for (size_t shift = 1; shift < workers_.size(); ++shift) {
+        Worker& victim = *workers_[(thief + shift) % workers_.size()];
+        std::optional<Task> task;
+        {
+            std::lock_guard lock(victim.mutex);
+            if (victim.tasks.empty()) {
+                continue;
+            }
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+        std::lock_guard lock(sleep_mutex_);
+        --pending_;
+        return task;
+    }
+    return std::nullopt;
+}
+
+void Runtime::Loop(size_t index) {
+    current_worker = {this, index};
+    Interpreter interpreter;
+    while (true) {
+        std::optional<Task> task = Pop(index);
+        if (!task) {
+            task = Steal(index);
+        }
+        if (!task) {
+            std::unique_lock lock(sleep_mutex_);
+            wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+            if (stop_ && pending_ == 0) {
+                return;
+            }
+            continue;
+        }
+        try {
+            task->promise.set_value(interpreter.Run(task->expression));
+        } catch (...) {
+            task->promise.set_exception(std::current_exception());
+        }
+    }
+}
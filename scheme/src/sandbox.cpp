@@ -0,0 +1,56 @@
+#include "scheme/sandbox.h"
+
+#include <algorithm>
+
+constinit thread_local Sandbox* Sandbox::current = nullptr;
+constinit thread_local uint64_t Sandbox::next_serial = 0;
+
+Sandbox::Sandbox(const Limits& limits)
+    : limits_(limits),
+      deadline_(std::chrono::steady_clock::now() + limits.time),
+      serial_(++next_serial),
+      previous_(current) {
+    current = limits.IsUnlimited() ? nullptr : this;
+}
+
+Sandbox::~Sandbox() {
+    current = previous_;
+}
+
+Limits Sandbox::ForWorkers() {
+    Limits limits;
+    if (current == nullptr) {
+        return limits;
+    }
+    limits.depth = current->limits_.depth;
+    limits.interrupt = current->limits_.interrupt;
+    if (current->limits_.time.count() != 0) {
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(
+            current->deadline_ - std::chrono::steady_clock::now());
+        limits.time = std::max(left, std::chrono::milliseconds(1));
+    }
+    return limits;
+}
+
+void Sandbox::CountStep() {
+    ++steps_;
+    if (limits_.steps != 0 && steps_ > limits_.steps) {
+        throw LimitError("Step budget exhausted");
+    }
+    if (steps_ % kClockPeriod != 0) {
+        return;
+    }
+    if (limits_.time.count() != 0 && std::chrono::steady_clock::now() > deadline_) {
+        throw LimitError("Deadline exceeded");
+    }
+    if (limits_.interrupt != nullptr && limits_.interrupt->load(std::memory_order_relaxed)) {
+        throw LimitError("Interrupted");
+    }
+}
+
+void Sandbox::CountBytes(size_t bytes) {
+    bytes_ += bytes;
+    if (limits_.heap != 0 && bytes_ > limits_.heap) {
+        throw LimitError("Heap limit exceeded");
+    }
+}
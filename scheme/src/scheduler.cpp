@@ -0,0 +1,315 @@
+#include "scheme/scheduler.h"
+
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "scheme/error.h"
+
+namespace {
+
+// Thrown into a blocked task to unwind its stack when the scheduler goes away; nothing but
+// Task::Run catches it.
+struct Cancelled {};
+
+// The scheduler whose task Scheduler::Start begins.
+thread_local Scheduler* starting = nullptr;
+
+// Stacks kept for reuse at most.
+constexpr size_t kSpareStacks = 16;
+
+// Stack left below the bound evaluation checks, for the builtins, the optimizer and the unwinder
+// running past the last check.
+constexpr size_t kStackMargin = size_t{32} << 10;
+
+size_t PageSize() {
+    static const size_t size = getpagesize();
+    return size;
+}
+
+// The guard page, then size bytes of stack.
+void* MapStack(size_t size) {
+    void* stack = mmap(nullptr, PageSize() + size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        throw RuntimeError("Can not allocate the stack of a task");
+    }
+    // Overflowing the stack past the margin faults instead of overwriting memory.
+    mprotect(stack, PageSize(), PROT_NONE);
+    return stack;
+}
+
+void UnmapStack(void* stack, size_t size) {
+    munmap(stack, PageSize() + size);
+}
+
+}  // namespace
+
+struct Task::Fiber {
+    ucontext_t context;
+    void* stack = nullptr;
+    size_t size = 0;
+
+    ~Fiber() {
+        if (stack != nullptr) {
+            UnmapStack(stack, size);
+        }
+    }
+};
+
+Task::Task(Ptr<Object> expression, Ptr<Environemnt> env)
+    : expression_(std::move(expression)), env_(std::move(env)) {
+}
+void Task::Run() {
+    state_ = State::RUNNING;
+    try {
+        result_ = Object::Eval(expression_, env_);
+        state_ = State::DONE;
+    } catch (...) {
+        error_ = std::current_exception();
+        state_ = State::FAILED;
+    }
+    expression_ = nullptr;
+    env_ = nullptr;
+}
+Ptr<Object> Task::GetResult() {
+    if (state_ == State::FAILED) {
+        std::rethrow_exception(error_);
+    }
+    return result_;
+}
+Task::~Task() = default;
+
+Scheduler::Scheduler(size_t stack_size) {
+    SetStackSize(stack_size);
+}
+
+void Scheduler::SetStackSize(size_t stack_size) {
+    size_t size = std::max(stack_size, kMinStackSize);
+    size = (size + PageSize() - 1) / PageSize() * PageSize();
+    if (size == stack_size_) {
+        return;
+    }
+    for (void* stack : stacks_) {
+        UnmapStack(stack, stack_size_);
+    }
+    stacks_.clear();
+    stack_size_ = size;
+}
+
+Scheduler::~Scheduler() {
+    // Tasks which never started have nothing on a stack; the others are resumed with an exception
+    // until they finish.
+    while (true) {
+        Ptr<Task> task;
+        if (!blocked_.empty()) {
+            task = std::move(blocked_.begin()->second);
+            blocked_.erase(blocked_.begin());
+        } else {
+            auto it = std::find_if(ready_.begin(), ready_.end(),
+                                   [](const Ptr<Task>& task) { return task->fiber_ != nullptr; });
+            if (it == ready_.end()) {
+                break;
+            }
+            task = std::move(*it);
+            ready_.erase(it);
+        }
+        task->cancelled_ = true;
+        Resume(task);
+    }
+    for (void* stack : stacks_) {
+        UnmapStack(stack, stack_size_);
+    }
+}
+
+Ptr<Task> Scheduler::Spawn(Ptr<Object> expression, Ptr<Environemnt> env) {
+    Ptr<Task> task = std::make_shared<Task>(std::move(expression), std::move(env));
+    ready_.push_back(task);
+    return task;
+}
+bool Scheduler::RunOne() {
+    if (ready_.empty()) {
+        return false;
+    }
+    Ptr<Task> task = std::move(ready_.front());
+    ready_.pop_front();
+    Resume(task);
+    return true;
+}
+size_t Scheduler::RunPending() {
+    size_t count = 0;
+    while (RunOne()) {
+        ++count;
+    }
+    return count;
+}
+Ptr<Object> Scheduler::Await(const Ptr<Task>& task) {
+    if (running_ != nullptr) {
+        if (task.get() == running_) {
+            throw RuntimeError("await would block forever: a task can not await itself");
+        }
+        if (!task->IsFinished()) {
+            task->waiters_.push_back(GetRunning());
+            Block();
+        }
+        return task->GetResult();
+    }
+    while (!task->IsFinished()) {
+        if (!RunOne()) {
+            throw RuntimeError("await would block forever: no runnable tasks left");
+        }
+    }
+    return task->GetResult();
+}
+Ptr<Object> Scheduler::Receive(const Ptr<Channel>& channel) {
+    std::deque<Ptr<Object>>& values = channel->values_;
+    if (running_ != nullptr && values.empty()) {
+        Task* task = running_;
+        channel->receivers_.push_back(GetRunning());
+        Block();
+        return std::move(task->received_);
+    }
+    while (values.empty()) {
+        if (!RunOne()) {
+            throw RuntimeError("channel-receive would block forever: no runnable tasks left");
+        }
+    }
+    Ptr<Object> value = std::move(values.front());
+    values.pop_front();
+    return value;
+}
+void Scheduler::Send(const Ptr<Channel>& channel, Ptr<Object> value) {
+    while (!channel->receivers_.empty()) {
+        Ptr<Task> receiver = channel->receivers_.front().lock();
+        channel->receivers_.pop_front();
+        // A receiver stops blocking only once handed a value, or when it is cancelled.
+        if (receiver != nullptr && receiver->state_ == Task::State::BLOCKED) {
+            receiver->received_ = std::move(value);
+            Wake(receiver);
+            return;
+        }
+    }
+    channel->values_.push_back(std::move(value));
+}
+void Scheduler::Yield() {
+    if (running_ == nullptr) {
+        RunOne();
+        return;
+    }
+    running_->state_ = Task::State::PENDING;
+    ready_.push_back(GetRunning());
+    Suspend();
+}
+
+void Scheduler::Start() {
+    Scheduler* scheduler = starting;
+    Task* task = scheduler->running_;
+    task->Run();
+    for (const std::weak_ptr<Task>& waiter : task->waiters_) {
+        if (Ptr<Task> blocked = waiter.lock()) {
+            scheduler->Wake(blocked);
+        }
+    }
+    task->waiters_.clear();
+    // Returning switches to uc_link, that is back into Resume.
+}
+void Scheduler::Resume(const Ptr<Task>& task) {
+    if (task->fiber_ == nullptr) {
+        auto fiber = std::make_unique<Task::Fiber>();
+        if (!stacks_.empty()) {
+            fiber->stack = stacks_.back();
+            stacks_.pop_back();
+        } else {
+            fiber->stack = MapStack(stack_size_);
+        }
+        fiber->size = stack_size_;
+        getcontext(&fiber->context);
+        fiber->context.uc_stack.ss_sp = static_cast<char*>(fiber->stack) + PageSize();
+        fiber->context.uc_stack.ss_size = fiber->size;
+        fiber->context.uc_link = &context_;
+        makecontext(&fiber->context, &Scheduler::Start, 0);
+        task->fiber_ = std::move(fiber);
+    }
+    starting = this;
+    running_ = task.get();
+    task->state_ = Task::State::RUNNING;
+    {
+        Sandbox::StackBound bound(static_cast<char*>(task->fiber_->stack) + PageSize() +
+                                  kStackMargin);
+        swapcontext(&context_, &task->fiber_->context);
+    }
+    running_ = nullptr;
+    if (task->IsFinished()) {
+        if (stacks_.size() < kSpareStacks && task->fiber_->size == stack_size_) {
+            stacks_.push_back(task->fiber_->stack);
+            task->fiber_->stack = nullptr;
+        }
+        task->fiber_ = nullptr;
+    }
+}
+void Scheduler::Suspend() {
+    Task* task = running_;
+    swapcontext(&task->fiber_->context, &context_);
+    if (task->cancelled_) {
+        throw Cancelled{};
+    }
+}
+void Scheduler::Block() {
+    Ptr<Task> task = GetRunning();
+    task->state_ = Task::State::BLOCKED;
+    blocked_.emplace(task.get(), task);
+    task = nullptr;
+    Suspend();
+}
+void Scheduler::Wake(const Ptr<Task>& task) {
+    if (blocked_.erase(task.get()) != 0) {
+        task->state_ = Task::State::PENDING;
+        ready_.push_back(task);
+    }
+}
+Ptr<Task> Scheduler::GetRunning() const {
+    return std::static_pointer_cast<Task>(running_->shared_from_this());
+}
+
+void Scheduler::Install(Environemnt* env) {
+    env->Define("spawn", std::make_shared<Syntax>([this](Ptr<Object> ast, Ptr<Environemnt> env) {
+        std::vector<Ptr<Object>> args = CollectArguments(ast);
+        if (args.size() != 1) {
+            throw RuntimeError("spawn must have exactly 1 argument");
+        }
+        return Spawn(args.front(), env);
+    }));
+    env->Define("await", std::make_shared<Procedure<Task>>(
+        [this](const std::vector<Ptr<Task>>& args) {
+            return Await(args.front());
+        },
+        false, Arity::Exactly("await", 1)));
+    env->Define("yield", std::make_shared<Procedure<Object>>(
+        [this](const std::vector<Ptr<Object>>&) -> Ptr<Object> {
+            Yield();
+            return nullptr;
+        },
+        false, Arity::Exactly("yield", 0)));
+    env->Define("task-done?", std::make_shared<Procedure<Task>>(
+        [](const std::vector<Ptr<Task>>& args) {
+            return MakeBoolean(args.front()->IsFinished());
+        },
+        false, Arity::Exactly("task-done?", 1)));
+    env->Define("make-channel", std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>&) {
+            return std::make_shared<Channel>();
+        },
+        false, Arity::Exactly("make-channel", 0)));
+    env->Define("channel-send", std::make_shared<Procedure<Object>>(
+        [this](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            Send(As<Channel>(args.front()), args.back());
+            return nullptr;
+        },
+        false, Arity::Exactly("channel-send", 2)));
+    env->Define("channel-receive", std::make_shared<Procedure<Channel>>(
+        [this](const std::vector<Ptr<Channel>>& args) {
+            return Receive(args.front());
+        },
+        false, Arity::Exactly("channel-receive", 1)));
+}
@@ -2,12 +2,139 @@
 #include "scheme/error.h"
 #include "scheme/tokenizer.h"
 #include "scheme/parser.h"
+#include "scheme/optimizer.h"
+#include <fstream>
 #include <sstream>
 
+namespace {
+BatchResult::Status StatusOf(Error::Kind kind) {
+    switch (kind) {
+        case Error::Kind::SYNTAX:
+            return BatchResult::Status::SYNTAX_ERROR;
+        case Error::Kind::NAME:
+            return BatchResult::Status::NAME_ERROR;
+        case Error::Kind::LIMIT:
+            return BatchResult::Status::LIMIT_EXCEEDED;
+        default:
+            return BatchResult::Status::RUNTIME_ERROR;
+    }
+}
+}  // namespace
+
 std::string Interpreter::Run(const std::string& s) {
-    std::stringstream ss(s);
-    Tokenizer t(&ss);
-    auto node = Read(&t);
-    auto result = Object::Eval(node, global_scope_);
+    Sandbox sandbox{limits_};
+    std::optional<Ptr<Object>> node = parse_cache_.Lookup(s);
+    if (!node.has_value()) {
+        std::stringstream ss(s);
+        Tokenizer t(&ss);
+        std::string_view source = s;
+        node = Compile(&t, &source).ValueOrThrow();
+    }
+    auto result = Object::TryEval(*node, global_scope_).ValueOrThrow();
     return Object::ToString(result);
 }
+
+void Interpreter::RunBatch(std::span<const std::string_view> expressions,
+                           std::vector<BatchResult>* results) {
+    results->resize(expressions.size());
+    ViewBuffer buffer;
+    std::istream stream(&buffer);
+    Tokenizer tokenizer(&stream);
+    for (size_t i = 0; i < expressions.size(); ++i) {
+        Evaluate(
+            [&]() -> Result<Ptr<Object>> {
+                if (std::optional<Ptr<Object>> node = parse_cache_.Lookup(expressions[i])) {
+                    return *node;
+                }
+                buffer.Reset(expressions[i]);
+                stream.clear();
+                tokenizer.Reset();
+                return Compile(&tokenizer, &expressions[i]);
+            },
+            &(*results)[i]);
+    }
+}
+
+void Interpreter::RunBatch(std::istream* input, std::vector<BatchResult>* results) {
+    results->clear();
+    RunStream(input, [results](const BatchResult& result) { results->push_back(result); });
+}
+
+void Interpreter::RunStream(std::istream* input,
+                            const std::function<void(const BatchResult&)>& consume) {
+    Tokenizer tokenizer(input);
+    BatchResult result;
+    while (!tokenizer.IsEnd()) {
+        result.position = tokenizer.GetPosition();
+        bool read = Evaluate([&] { return Compile(&tokenizer, nullptr); }, &result);
+        consume(result);
+        if (!read) {
+            return;
+        }
+    }
+}
+
+bool Interpreter::RunFile(const std::string& path, std::vector<BatchResult>* results) {
+    std::ifstream input(path);
+    if (!input) {
+        return false;
+    }
+    RunBatch(&input, results);
+    return true;
+}
+
+Result<Ptr<Object>> Interpreter::Compile(Tokenizer* tokenizer, const std::string_view* source) {
+    auto ast = TryRead(tokenizer);
+    if (!ast.IsOk()) {
+        return ast;
+    }
+    if (hash_consing_ &&
+        global_scope_->Lookup("quote")->value == global_scope_->GetBuiltin("quote")) {
+        hash_cons_.InternQuoted(ast.GetValue());
+    }
+    Ptr<Object> node = Optimize(ast.GetValue(), global_scope_);
+    if (source != nullptr) {
+        parse_cache_.Insert(*source, node);
+    }
+    return node;
+}
+
+bool Interpreter::Evaluate(const std::function<Result<Ptr<Object>>()>& compile,
+                           BatchResult* result) {
+    Sandbox sandbox{limits_};
+    try {
+        auto node = compile();
+        if (!node.IsOk()) {
+            result->status = node.GetError().kind == Error::Kind::LIMIT
+                                 ? BatchResult::Status::LIMIT_EXCEEDED
+                                 : BatchResult::Status::SYNTAX_ERROR;
+            result->value = std::move(node.GetError().message);
+            return false;
+        }
+        auto value = Object::TryEval(node.GetValue(), global_scope_);
+        if (!value.IsOk()) {
+            result->status = StatusOf(value.GetError().kind);
+            result->value = std::move(value.GetError().message);
+            return true;
+        }
+        result->value = Object::ToString(value.GetValue());
+        result->status = BatchResult::Status::OK;
+    } catch (SyntaxError& e) {
+        result->status = BatchResult::Status::SYNTAX_ERROR;
+        result->value = e.what();
+    } catch (RuntimeError& e) {
+        result->status = BatchResult::Status::RUNTIME_ERROR;
+        result->value = e.what();
+    } catch (NameError& e) {
+        result->status = BatchResult::Status::NAME_ERROR;
+        result->value = e.what();
+    } catch (LimitError& e) {
+        result->status = BatchResult::Status::LIMIT_EXCEEDED;
+        result->value = e.what();
+    } catch (std::exception& e) {
+        // Whatever else a builtin lets out is still an error of this item, not of the batch.
+        result->status = BatchResult::Status::RUNTIME_ERROR;
+        result->value = e.what();
+    }
+    return true;
+}
@@ -0,0 +1,522 @@
+#include "scheme/server.h"
+#include "scheme/error.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <system_error>
+
+namespace {
+
+constexpr auto kSweepInterval = std::chrono::seconds(1);
+// How long accept waits before trying again when the process is out of descriptors or memory.
+constexpr auto kAcceptBackoff = std::chrono::milliseconds(100);
+// Frames longer than that end the connection.
+constexpr size_t kMaxFrameSize = size_t{64} << 20;
+constexpr size_t kMaxSessionSize = 255;
+
+[[noreturn]] void ThrowSystemError(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+bool ReadAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = recv(fd, data, size, 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = send(fd, data, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+// False at the end of the connection, on an error or on a frame too long to accept.
+bool ReadFrame(int fd, std::string* frame) {
+    unsigned char header[4];
+    if (!ReadAll(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    size_t size = size_t{header[0]} << 24 | size_t{header[1]} << 16 | size_t{header[2]} << 8 |
+                  size_t{header[3]};
+    if (size > kMaxFrameSize) {
+        return false;
+    }
+    frame->resize(size);
+    return ReadAll(fd, frame->data(), size);
+}
+
+// The header goes out with the payload, so that a frame costs one system call.
+bool WriteFrame(int fd, std::string* frame) {
+    uint32_t size = frame->size() - 4;
+    (*frame)[0] = static_cast<char>(size >> 24);
+    (*frame)[1] = static_cast<char>(size >> 16);
+    (*frame)[2] = static_cast<char>(size >> 8);
+    (*frame)[3] = static_cast<char>(size);
+    return WriteAll(fd, frame->data(), frame->size());
+}
+
+sockaddr_un Address(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        ThrowSystemError("socket path");
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+BatchResult Malformed() {
+    return {BatchResult::Status::SYNTAX_ERROR, "Malformed request"};
+}
+
+}  // namespace
+
+void LatencyHistogram::Record(std::chrono::nanoseconds latency) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    auto width = std::bit_width(static_cast<uint64_t>(std::max<int64_t>(micros, 0)));
+    size_t bucket = std::min<size_t>(width, kBuckets - 1);
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::GetCount() const {
+    size_t count = 0;
+    for (const auto& bucket : buckets_) {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+std::array<size_t, LatencyHistogram::kBuckets> LatencyHistogram::GetBuckets() const {
+    std::array<size_t, kBuckets> buckets;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return buckets;
+}
+
+std::chrono::microseconds LatencyHistogram::GetQuantile(double q) const {
+    auto buckets = GetBuckets();
+    size_t count = 0;
+    for (size_t bucket : buckets) {
+        count += bucket;
+    }
+    if (count == 0) {
+        return std::chrono::microseconds(0);
+    }
+    // The rank of the quantile, counted from 1.
+    auto rank = static_cast<size_t>(std::clamp(q, 0.0, 1.0) * (count - 1)) + 1;
+    size_t i = 0;
+    for (size_t seen = buckets[0]; seen < rank;) {
+        seen += buckets[++i];
+    }
+    return std::chrono::microseconds(int64_t{1} << i);
+}
+
+std::string LatencyHistogram::ToString() const {
+    std::stringstream ss;
+    ss << "count " << GetCount() << " p50<=" << GetQuantile(0.5).count() << "us p90<="
+       << GetQuantile(0.9).count() << "us p99<=" << GetQuantile(0.99).count() << "us";
+    return ss.str();
+}
+
+Server::Server(ServerOptions options) : options_(std::move(options)) {
+    options_.limits.interrupt = &interrupt_;
+    // Reports a broken prelude now rather than on every request.
+    if (!options_.prelude.empty()) {
+        Interpreter interpreter;
+        interpreter.SetLimits(options_.limits);
+        std::stringstream prelude{options_.prelude};
+        std::vector<BatchResult> results;
+        interpreter.RunBatch(&prelude, &results);
+        for (const auto& result : results) {
+            switch (result.status) {
+                case BatchResult::Status::OK:
+                    break;
+                case BatchResult::Status::SYNTAX_ERROR:
+                    throw SyntaxError(result.value);
+                case BatchResult::Status::NAME_ERROR:
+                    throw NameError(result.value);
+                case BatchResult::Status::LIMIT_EXCEEDED:
+                    throw LimitError(result.value);
+                default:
+                    throw RuntimeError(result.value);
+            }
+        }
+    }
+    size_t count = std::max<size_t>(options_.workers, 1);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::thread([this, worker = worker.get()] { Loop(worker); });
+    }
+}
+
+Server::~Server() {
+    Stop();
+    stop_ = true;
+    // Requests still queued or running are answered without being waited for.
+    interrupt_ = true;
+    for (auto& worker : workers_) {
+        {
+            std::lock_guard lock(worker->mutex);
+        }
+        worker->wake.notify_one();
+    }
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void Server::Listen(const std::string& path) {
+    sockaddr_un address = Address(path);
+    Stop();
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ThrowSystemError("socket");
+    }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        ThrowSystemError("bind");
+    }
+    closing_ = false;
+    listener_ = fd;
+    path_ = path;
+    acceptor_ = std::thread([this] { Accept(); });
+}
+
+void Server::Stop() {
+    if (listener_ < 0) {
+        return;
+    }
+    closing_ = true;
+    // Wakes the acceptor up from accept.
+    shutdown(listener_, SHUT_RDWR);
+    acceptor_.join();
+    close(listener_);
+    unlink(path_.c_str());
+    listener_ = -1;
+
+    std::lock_guard lock(connections_mutex_);
+    interrupt_ = true;
+    for (auto& connection : connections_) {
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+    for (auto& connection : connections_) {
+        connection->thread.join();
+        close(connection->fd);
+    }
+    connections_.clear();
+    interrupt_ = false;
+}
+
+std::future<BatchResult> Server::Submit(std::string expression, std::string session) {
+    Task task;
+    task.expression = std::move(expression);
+    task.session = std::move(session);
+    task.submitted = std::chrono::steady_clock::now();
+    auto future = task.promise.get_future();
+    Worker* worker = WorkerOf(task.session);
+    Push(worker, std::move(task));
+    return future;
+}
+
+bool Server::CloseSession(std::string session) {
+    Task task;
+    task.session = std::move(session);
+    task.close = true;
+    auto future = task.promise.get_future();
+    Worker* worker = WorkerOf(task.session);
+    Push(worker, std::move(task));
+    return future.get().value == "#t";
+}
+
+std::string Server::GetStats() const {
+    return "latency " + latency_.ToString() + "\nevaluation " + evaluation_.ToString() + "\n";
+}
+
+std::unique_ptr<Interpreter> Server::MakeInterpreter() const {
+    auto interpreter = std::make_unique<Interpreter>();
+    interpreter->SetLimits(options_.limits);
+    if (!options_.prelude.empty()) {
+        std::stringstream prelude{options_.prelude};
+        interpreter->RunStream(&prelude, [](const BatchResult&) {});
+    }
+    return interpreter;
+}
+
+void Server::Push(Worker* worker, Task task) {
+    {
+        std::lock_guard lock(worker->mutex);
+        worker->tasks.push_back(std::move(task));
+    }
+    worker->wake.notify_one();
+}
+
+Server::Worker* Server::WorkerOf(const std::string& session) {
+    if (session.empty()) {
+        return workers_[next_worker_++ % workers_.size()].get();
+    }
+    return workers_[std::hash<std::string>{}(session) % workers_.size()].get();
+}
+
+void Server::Loop(Worker* worker) {
+    worker->swept = std::chrono::steady_clock::now();
+    Reclaimer::SetBudget(options_.release_budget);
+    while (true) {
+        std::optional<Task> task;
+        {
+            std::unique_lock lock(worker->mutex);
+            if (worker->tasks.empty() && worker->warm.size() >= options_.warm_interpreters &&
+                Reclaimer::GetPending() == 0) {
+                worker->wake.wait_for(lock, kSweepInterval,
+                                      [&] { return stop_ || !worker->tasks.empty(); });
+            }
+            if (!worker->tasks.empty()) {
+                task = std::move(worker->tasks.front());
+                worker->tasks.pop_front();
+            } else if (stop_) {
+                break;
+            }
+        }
+        if (task.has_value()) {
+            Execute(worker, &*task);
+        } else if (Reclaimer::GetPending() != 0) {
+            Reclaimer::Collect(options_.release_budget);
+        } else if (worker->warm.size() < options_.warm_interpreters) {
+            worker->warm.push_back(MakeInterpreter());
+        }
+        Expire(worker);
+    }
+    // Interpreters are destroyed on the thread which made their objects.
+    worker->sessions.clear();
+    worker->warm.clear();
+    Reclaimer::Collect();
+}
+
+void Server::Execute(Worker* worker, Task* task) {
+    auto now = std::chrono::steady_clock::now();
+    if (task->close) {
+        bool closed = worker->sessions.erase(task->session) > 0;
+        task->promise.set_value({BatchResult::Status::OK, closed ? "#t" : "#f"});
+        return;
+    }
+    std::unique_ptr<Interpreter> fresh;
+    Interpreter* interpreter;
+    auto take = [&] {
+        if (worker->warm.empty()) {
+            return MakeInterpreter();
+        }
+        auto taken = std::move(worker->warm.back());
+        worker->warm.pop_back();
+        return taken;
+    };
+    if (task->session.empty()) {
+        fresh = take();
+        interpreter = fresh.get();
+    } else {
+        Session& session = worker->sessions[task->session];
+        if (session.interpreter == nullptr) {
+            session.interpreter = take();
+        }
+        session.used = now;
+        interpreter = session.interpreter.get();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    BatchResult result;
+    // Whatever one request throws is its own error: escaping the worker would end the daemon.
+    try {
+        std::string_view expression = task->expression;
+        interpreter->RunBatch(std::span(&expression, 1), &worker->results);
+        result = std::move(worker->results.front());
+        try {
+            interpreter->RunPending();
+        } catch (std::exception&) {
+            // Tasks spawned in the background have nobody to report to.
+        }
+    } catch (std::exception& e) {
+        result = {BatchResult::Status::RUNTIME_ERROR, e.what()};
+    } catch (...) {
+        result = {BatchResult::Status::RUNTIME_ERROR, "Unknown error"};
+    }
+    auto end = std::chrono::steady_clock::now();
+    evaluation_.Record(end - start);
+    latency_.Record(end - task->submitted);
+    task->promise.set_value(std::move(result));
+}
+
+void Server::Expire(Worker* worker) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - worker->swept < kSweepInterval) {
+        return;
+    }
+    worker->swept = now;
+    std::erase_if(worker->sessions, [&](const auto& entry) {
+        return now - entry.second.used >= options_.session_timeout;
+    });
+}
+
+void Server::Accept() {
+    while (true) {
+        int fd = accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (closing_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return;
+        }
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EMFILE && errno != ENFILE && errno != ENOBUFS && errno != ENOMEM) {
+                return;
+            }
+            // Retrying at once would spin until a connection ends and frees a descriptor.
+            {
+                std::lock_guard lock(connections_mutex_);
+                Reap();
+            }
+            std::this_thread::sleep_for(kAcceptBackoff);
+            continue;
+        }
+        std::lock_guard lock(connections_mutex_);
+        Reap();
+        auto& connection = connections_.emplace_back(std::make_unique<Connection>());
+        connection->fd = fd;
+        connection->thread = std::thread([this, connection = connection.get()] {
+            Serve(connection);
+        });
+    }
+}
+
+void Server::Reap() {
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if ((*it)->done) {
+            (*it)->thread.join();
+            close((*it)->fd);
+            it = connections_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Server::Serve(Connection* connection) {
+    std::string request;
+    std::string response;
+    while (ReadFrame(connection->fd, &request)) {
+        BatchResult result;
+        size_t session_size = request.size() >= 2 ? static_cast<unsigned char>(request[1]) : 0;
+        if (request.size() < 2 + session_size) {
+            result = Malformed();
+        } else {
+            std::string session = request.substr(2, session_size);
+            switch (static_cast<ServerRequest>(request[0])) {
+                case ServerRequest::EVAL:
+                    result = Submit(request.substr(2 + session_size), std::move(session)).get();
+                    break;
+                case ServerRequest::STATS:
+                    result.value = GetStats();
+                    break;
+                case ServerRequest::CLOSE:
+                    result.value = CloseSession(std::move(session)) ? "#t" : "#f";
+                    break;
+                default:
+                    result = Malformed();
+            }
+        }
+        response.assign(4, '\0');
+        response += static_cast<char>(result.status);
+        response += result.value;
+        if (!WriteFrame(connection->fd, &response)) {
+            break;
+        }
+    }
+    connection->done = true;
+}
+
+ServerClient::ServerClient(const std::string& path) {
+    sockaddr_un address = Address(path);
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        ThrowSystemError("socket");
+    }
+    if (connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        close(fd_);
+        errno = error;
+        ThrowSystemError("connect");
+    }
+}
+
+ServerClient::~ServerClient() {
+    close(fd_);
+}
+
+BatchResult ServerClient::Eval(std::string_view expression, std::string_view session) {
+    return Call(ServerRequest::EVAL, session, expression);
+}
+
+bool ServerClient::CloseSession(std::string_view session) {
+    return Call(ServerRequest::CLOSE, session, {}).value == "#t";
+}
+
+std::string ServerClient::GetStats() {
+    return Call(ServerRequest::STATS, {}, {}).value;
+}
+
+BatchResult ServerClient::Call(ServerRequest kind, std::string_view session,
+                               std::string_view expression) {
+    if (session.size() > kMaxSessionSize) {
+        throw RuntimeError("Session name too long");
+    }
+    std::string frame(4, '\0');
+    frame += static_cast<char>(kind);
+    frame += static_cast<char>(session.size());
+    frame += session;
+    frame += expression;
+    if (!WriteFrame(fd_, &frame)) {
+        ThrowSystemError("send");
+    }
+    errno = 0;
+    if (!ReadFrame(fd_, &frame) || frame.empty()) {
+        if (errno == 0) {
+            errno = ECONNRESET;
+        }
+        ThrowSystemError("recv");
+    }
+    return {static_cast<BatchResult::Status>(frame[0]), frame.substr(1)};
+}
@@ -0,0 +1,376 @@
+#include "scheme/text.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+String::String(std::string_view text) : size_(text.size()) {
+    if (text.size() <= kInlineSize) {
+        Inline data;
+        std::copy(text.begin(), text.end(), data.data.begin());
+        data_ = data;
+        Sandbox::Allocate(sizeof(String));
+        return;
+    }
+    auto buffer = std::make_shared<const std::string>(text);
+    data_ = Slice{buffer, *buffer};
+    Sandbox::Allocate(sizeof(String) + text.size());
+}
+
+String::String(std::string&& text) : size_(text.size()) {
+    if (text.size() <= kInlineSize) {
+        Inline data;
+        std::copy(text.begin(), text.end(), data.data.begin());
+        data_ = data;
+        Sandbox::Allocate(sizeof(String));
+        return;
+    }
+    Sandbox::Allocate(sizeof(String) + text.size());
+    auto buffer = std::make_shared<const std::string>(std::move(text));
+    data_ = Slice{buffer, *buffer};
+}
+
+String::String(Slice slice) : data_(std::move(slice)), size_(std::get<Slice>(data_).view.size()) {
+    Sandbox::Allocate(sizeof(String));
+}
+
+String::String(Ptr<String> left, Ptr<String> right)
+    : size_(left->size_ + right->size_), height_(std::max(left->height_, right->height_) + 1) {
+    data_ = Rope{std::move(left), std::move(right)};
+    Sandbox::Allocate(sizeof(String));
+}
+
+Ptr<String> MakeString(std::string_view text) {
+    return std::make_shared<String>(text);
+}
+
+Ptr<String> MakeString(std::string&& text) {
+    return std::make_shared<String>(std::move(text));
+}
+
+std::string String::ToString() {
+    std::string text = GetText();
+    std::string res = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                res += "\\\"";
+                break;
+            case '\\':
+                res += "\\\\";
+                break;
+            case '\n':
+                res += "\\n";
+                break;
+            case '\t':
+                res += "\\t";
+                break;
+            case '\r':
+                res += "\\r";
+                break;
+            default:
+                res += c;
+        }
+    }
+    return res + '"';
+}
+
+char String::At(size_t index) const {
+    const String* cur = this;
+    while (const Rope* rope = cur->GetRope()) {
+        if (index < rope->left->size_) {
+            cur = rope->left.get();
+        } else {
+            index -= rope->left->size_;
+            cur = rope->right.get();
+        }
+    }
+    return (*cur->GetView())[index];
+}
+
+std::optional<std::string_view> String::GetView() const {
+    if (const auto* data = std::get_if<Inline>(&data_)) {
+        return std::string_view(data->data.data(), size_);
+    }
+    if (const auto* slice = std::get_if<Slice>(&data_)) {
+        return slice->view;
+    }
+    return std::nullopt;
+}
+
+std::string String::GetText() const {
+    std::string res;
+    res.reserve(size_);
+    AppendTo(&res);
+    return res;
+}
+
+void String::AppendTo(std::string* out) const {
+    std::vector<const String*> stack = {this};
+    while (!stack.empty()) {
+        const String* cur = stack.back();
+        stack.pop_back();
+        if (const Rope* rope = cur->GetRope()) {
+            stack.push_back(rope->right.get());
+            stack.push_back(rope->left.get());
+        } else {
+            *out += *cur->GetView();
+        }
+    }
+}
+
+Ptr<String> String::Substring(size_t begin, size_t end) const {
+    if (const Rope* rope = GetRope()) {
+        size_t middle = rope->left->size_;
+        if (end <= middle) {
+            return rope->left->Substring(begin, end);
+        }
+        if (begin >= middle) {
+            return rope->right->Substring(begin - middle, end - middle);
+        }
+        return Append(rope->left->Substring(begin, middle),
+                      rope->right->Substring(0, end - middle));
+    }
+    std::string_view view = GetView()->substr(begin, end - begin);
+    const auto* slice = std::get_if<Slice>(&data_);
+    if (slice == nullptr || view.size() <= kInlineSize) {
+        return MakeString(view);
+    }
+    return std::shared_ptr<String>(new String(Slice{slice->buffer, view}));
+}
+
+Ptr<String> String::Append(const Ptr<String>& left, const Ptr<String>& right) {
+    if (left->size_ == 0) {
+        return right;
+    }
+    if (right->size_ == 0) {
+        return left;
+    }
+    return Join(left, right);
+}
+
+Ptr<String> String::Node(Ptr<String> left, Ptr<String> right) {
+    return std::shared_ptr<String>(new String(std::move(left), std::move(right)));
+}
+
+Ptr<String> String::Balance(Ptr<String> left, Ptr<String> right) {
+    if (Height(left) > Height(right) + 1) {
+        const Rope* rope = left->GetRope();
+        if (Height(rope->left) >= Height(rope->right)) {
+            return Node(rope->left, Node(rope->right, std::move(right)));
+        }
+        const Rope* inner = rope->right->GetRope();
+        return Node(Node(rope->left, inner->left), Node(inner->right, std::move(right)));
+    }
+    if (Height(right) > Height(left) + 1) {
+        const Rope* rope = right->GetRope();
+        if (Height(rope->right) >= Height(rope->left)) {
+            return Node(Node(std::move(left), rope->left), rope->right);
+        }
+        const Rope* inner = rope->left->GetRope();
+        return Node(Node(std::move(left), inner->left), Node(inner->right, rope->right));
+    }
+    return Node(std::move(left), std::move(right));
+}
+
+Ptr<String> String::Join(const Ptr<String>& left, const Ptr<String>& right) {
+    // Heights differ by at most one level per call, so this recurses O(log n) times.
+    if (Height(left) > Height(right) + 1) {
+        const Rope* rope = left->GetRope();
+        return Balance(rope->left, Join(rope->right, right));
+    }
+    if (Height(right) > Height(left) + 1) {
+        const Rope* rope = right->GetRope();
+        return Balance(Join(left, rope->left), rope->right);
+    }
+    if (left->size_ + right->size_ <= kLeafSize) {
+        return MakeString(left->GetText() + right->GetText());
+    }
+    // Merges short leaves next to each other across the seam.
+    const Rope* rope = left->GetRope();
+    if (rope != nullptr && rope->right->height_ == 0 && right->height_ == 0 &&
+        rope->right->size_ + right->size_ <= kLeafSize) {
+        return Balance(rope->left, MakeString(rope->right->GetText() + right->GetText()));
+    }
+    rope = right->GetRope();
+    if (rope != nullptr && rope->left->height_ == 0 && left->height_ == 0 &&
+        left->size_ + rope->left->size_ <= kLeafSize) {
+        return Balance(MakeString(left->GetText() + rope->left->GetText()), rope->right);
+    }
+    return Node(left, right);
+}
+
+int String::Compare(const String& a, const String& b) {
+    std::optional<std::string_view> x = a.GetView();
+    std::optional<std::string_view> y = b.GetView();
+    if (x.has_value() && y.has_value()) {
+        return x->compare(*y);
+    }
+    return a.GetText().compare(b.GetText());
+}
+
+StringPort::StringPort(Ptr<String> source)
+    : input_(source->GetView().has_value() ? std::move(source) : MakeString(source->GetText())) {
+}
+
+Ptr<String> StringPort::ReadLine() {
+    std::string_view text = *input_->GetView();
+    if (position_ >= text.size()) {
+        return nullptr;
+    }
+    size_t end = text.find('\n', position_);
+    if (end == std::string_view::npos) {
+        end = text.size();
+    }
+    Ptr<String> line = input_->Substring(position_, end);
+    position_ = end + 1;
+    return line;
+}
+
+namespace {
+Ptr<String> AsString(const Ptr<Object>& value, const char* name) {
+    auto string = std::dynamic_pointer_cast<String>(value);
+    if (string == nullptr) {
+        throw RuntimeError(std::string(name) + " needs a string");
+    }
+    return string;
+}
+
+size_t AsIndex(const Ptr<Object>& value, size_t max, const char* name) {
+    auto* number = dynamic_cast<Number*>(value.get());
+    if (number == nullptr || number->GetValue() < 0 ||
+        static_cast<size_t>(number->GetValue()) > max) {
+        throw RuntimeError(std::string("Index out of bound in ") + name);
+    }
+    return number->GetValue();
+}
+
+Ptr<StringPort> AsPort(const Ptr<Object>& value, bool input, const char* name) {
+    auto port = std::dynamic_pointer_cast<StringPort>(value);
+    if (port == nullptr || port->IsInput() != input) {
+        throw RuntimeError(std::string(name) + " needs an " + (input ? "input" : "output") +
+                           " string port");
+    }
+    return port;
+}
+
+Ptr<Object> Comparison(bool (*holds)(int), const char* name) {
+    return std::make_shared<Procedure<Object>>(
+        [holds, name](const std::vector<Ptr<Object>>& args) {
+            for (size_t i = 1; i < args.size(); ++i) {
+                if (!holds(String::Compare(*AsString(args[i - 1], name),
+                                           *AsString(args[i], name)))) {
+                    return MakeBoolean(false);
+                }
+            }
+            AsString(args.back(), name);
+            return MakeBoolean(true);
+        }, true, Arity::AtLeast(name, 1));
+}
+}  // namespace
+
+void Environemnt::FullfillStrings() {
+    bindings_["string?"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return MakeBoolean(Is<String>(args[0]));
+        }, true, Arity::Exactly("string?", 1));
+    bindings_["string-length"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return MakeSize(AsString(args[0], "string-length")->GetSize(), "string-length");
+        }, true, Arity::Exactly("string-length", 1));
+    // There are no characters: string-ref returns the string of the one byte at the index.
+    bindings_["string-ref"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            Ptr<String> string = AsString(args[0], "string-ref");
+            if (string->GetSize() == 0) {
+                throw RuntimeError("Index out of bound in string-ref");
+            }
+            size_t index = AsIndex(args[1], string->GetSize() - 1, "string-ref");
+            return MakeString(std::string(1, string->At(index)));
+        }, true, Arity::Exactly("string-ref", 2));
+    bindings_["substring"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            Ptr<String> string = AsString(args[0], "substring");
+            size_t end = args.size() == 3 ? AsIndex(args[2], string->GetSize(), "substring")
+                                          : string->GetSize();
+            size_t begin = AsIndex(args[1], end, "substring");
+            return string->Substring(begin, end);
+        }, true, Arity::Between("substring", 2, 3));
+    bindings_["string-append"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            Ptr<String> res = MakeString(std::string_view());
+            for (const Ptr<Object>& arg : args) {
+                res = String::Append(res, AsString(arg, "string-append"));
+            }
+            return res;
+        }, true);
+    bindings_["string=?"] = Comparison([](int order) { return order == 0; }, "string=?");
+    bindings_["string<?"] = Comparison([](int order) { return order < 0; }, "string<?");
+    bindings_["string>?"] = Comparison([](int order) { return order > 0; }, "string>?");
+    bindings_["string->symbol"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            return std::make_shared<Symbol>(AsString(args[0], "string->symbol")->GetText());
+        }, true, Arity::Exactly("string->symbol", 1));
+    bindings_["symbol->string"] =
+        std::make_shared<Procedure<Symbol>>([](const std::vector<Ptr<Symbol>>& args) {
+            return MakeString(args[0]->GetName());
+        }, true, Arity::Exactly("symbol->string", 1));
+    bindings_["number->string"] =
+        std::make_shared<Procedure<Number>>([](const std::vector<Ptr<Number>>& args) {
+            return MakeString(std::to_string(args[0]->GetValue()));
+        }, true, Arity::Exactly("number->string", 1));
+    // #f unless the whole string is a fixnum.
+    bindings_["string->number"] =
+        std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>& args) {
+            std::string text = AsString(args[0], "string->number")->GetText();
+            size_t digits = !text.empty() && (text[0] == '-' || text[0] == '+') ? 1 : 0;
+            if (text.size() == digits ||
+                !std::all_of(text.begin() + digits, text.end(),
+                             [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+                return Ptr<Object>(MakeBoolean(false));
+            }
+            try {
+                return Ptr<Object>(MakeNumber(std::stoi(text)));
+            } catch (const std::out_of_range&) {
+                return Ptr<Object>(MakeBoolean(false));
+            }
+        }, true, Arity::Exactly("string->number", 1));
+
+    bindings_["open-output-string"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>&) {
+            return std::make_shared<StringPort>();
+        },
+        false, Arity::Exactly("open-output-string", 0));
+    bindings_["open-input-string"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            return std::make_shared<StringPort>(AsString(args[0], "open-input-string"));
+        },
+        false, Arity::Exactly("open-input-string", 1));
+    // (write-string string port) writes the bytes of string, (write datum port) its literal.
+    bindings_["write-string"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            AsPort(args[1], false, "write-string")->Write(*AsString(args[0], "write-string"));
+            return nullptr;
+        },
+        false, Arity::Exactly("write-string", 2));
+    bindings_["write"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            AsPort(args[1], false, "write")->Write(Object::ToString(args[0]));
+            return nullptr;
+        },
+        false, Arity::Exactly("write", 2));
+    bindings_["get-output-string"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) {
+            return AsPort(args[0], false, "get-output-string")->GetOutput();
+        },
+        false, Arity::Exactly("get-output-string", 1));
+    // The next line, or #f once the port is exhausted.
+    bindings_["read-line"] = std::make_shared<Procedure<Object>>(
+        [](const std::vector<Ptr<Object>>& args) -> Ptr<Object> {
+            if (Ptr<String> line = AsPort(args[0], true, "read-line")->ReadLine()) {
+                return line;
+            }
+            return MakeBoolean(false);
+        },
+        false, Arity::Exactly("read-line", 1));
+}
@@ -1,38 +1,73 @@
 #include <scheme/tokenizer.h>
+#include <charconv>
 #include <string>
 
+namespace {
+// The token of an optionally signed run of digits.
+Token MakeInteger(const std::string& literal) {
+    const char* begin = literal.data() + (literal.front() == '+' ? 1 : 0);
+    int value;
+    auto [end, error] = std::from_chars(begin, literal.data() + literal.size(), value);
+    if (error != std::errc() || end != literal.data() + literal.size()) {
+        return InvalidToken{"Integer literal out of range: " + literal};
+    }
+    return ConstantToken{value};
+}
+}  // namespace
+
 void Tokenizer::Next() {
     if (s_->eof()) {
+        token_position_ = position_;
         current_token_.reset();
         return;
     }
     while (std::isblank(s_->peek()) || s_->peek() == '\n' || s_->peek() == '\r') {
-        s_->get();
+        Get();
     }
+    token_position_ = position_;
     if (s_->eof()) {
         current_token_.reset();
         return;
     }
     if (s_->peek() == '(') {
         current_token_ = BracketToken::OPEN;
-        s_->get();
+        Get();
     } else if (s_->peek() == ')') {
         current_token_ = BracketToken::CLOSE;
-        s_->get();
+        Get();
     } else if (s_->peek() == '\'') {
         current_token_ = QuoteToken();
-        s_->get();
+        Get();
+    } else if (s_->peek() == '"') {
+        Get();
+        StringToken token;
+        token.terminated = false;
+        for (int c = Get(); c != std::char_traits<char>::eof(); c = Get()) {
+            if (c == '"') {
+                token.terminated = true;
+                break;
+            }
+            if (c == '\\') {
+                c = Get();
+                if (c == std::char_traits<char>::eof()) {
+                    break;
+                }
+                c = c == 'n' ? '\n' : c == 't' ? '\t' : c == 'r' ? '\r' : c;
+            }
+            token.value += static_cast<char>(c);
+        }
+        current_token_ = std::move(token);
     } else if (s_->peek() == '.') {
         current_token_ = DotToken();
-        s_->get();
+        Get();
     } else if (starts_from(s_->peek(), first_might_begin_)) {
         SymbolToken token;
         while (starts_from(s_->peek(), word_contains)) {
-            token.name += s_->get();
+            token.name += Get();
         }
         current_token_ = token;
     } else if (s_->peek() == '+' || s_->peek() == '-') {
-        char sign = s_->get();
+        char sign = Get();
         if (std::isblank(s_->peek()) || s_->eof() || !std::isdigit(s_->peek())
             || s_->peek() == '\n' || s_->peek() == '\r') {
             SymbolToken token;
@@ -43,19 +78,19 @@ void Tokenizer::Next() {
             std::string integer;
             integer += sign;
             while (std::isdigit(s_->peek())) {
-                integer += s_->get();
+                integer += Get();
             }
-            ConstantToken token;
-            token.value = std::stoi(integer);
-            current_token_ = token;
+            current_token_ = MakeInteger(integer);
         }
     } else if (std::isdigit(s_->peek())) {
         std::string integer;
         while (std::isdigit(s_->peek())) {
-            integer += s_->get();
+            integer += Get();
         }
-        ConstantToken token;
-        token.value = std::stoi(integer);
-        current_token_ = token;
+        current_token_ = MakeInteger(integer);
+    } else {
+        // Taken off the stream, so that reading goes on past it rather than stopping here.
+        current_token_ = InvalidToken{std::string("Unexpected character '") +
+                                      static_cast<char>(Get()) + "'"};
     }
 }
@@ -0,0 +1,38 @@
+#include <fstream>
+#include <iostream>
+#include "scheme/codegen.h"
+#include "scheme/error.h"
+
+// schemec input.scm [-o output.cpp]: translates a Scheme program into C++ source, to be
+// compiled and linked against the scheme library.
+int main(int argc, char** argv) {
+    if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "-o")) {
+        std::cerr << "usage: schemec input.scm [-o output.cpp]" << std::endl;
+        return 2;
+    }
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "schemec: can not open " << argv[1] << std::endl;
+        return 1;
+    }
+    Translation translation;
+    try {
+        translation = TranslateToCpp(&input, argv[1]);
+    } catch (SyntaxError& e) {
+        std::cerr << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    if (argc == 2) {
+        std::cout << translation.code;
+    } else {
+        std::ofstream output(argv[3]);
+        output << translation.code;
+        if (!output) {
+            std::cerr << "schemec: can not write " << argv[3] << std::endl;
+            return 1;
+        }
+    }
+    std::cerr << argv[1] << ": " << translation.translated << " forms translated, "
+              << translation.interpreted << " interpreted" << std::endl;
+    return 0;
+}
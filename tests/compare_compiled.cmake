@@ -0,0 +1,12 @@
+# Runs SCRIPT through the REPL and the program schemec translated it into (COMPILED), and fails
+# unless both print the same results and the same errors.
+execute_process(COMMAND ${REPL} INPUT_FILE ${SCRIPT}
+        OUTPUT_VARIABLE expected ERROR_VARIABLE expected_errors)
+execute_process(COMMAND ${COMPILED}
+        OUTPUT_VARIABLE actual ERROR_VARIABLE actual_errors)
+if(NOT expected STREQUAL actual)
+    message(FATAL_ERROR "Results differ.\nInterpreted:\n${expected}\nCompiled:\n${actual}")
+endif()
+if(NOT expected_errors STREQUAL actual_errors)
+    message(FATAL_ERROR "Errors differ.\nInterpreted:\n${expected_errors}\nCompiled:\n${actual_errors}")
+endif()
@@ -0,0 +1,107 @@
+// Prints the expressions the Catch2 tests in the given sources evaluate, one per line, so that
+// the differential tests of schemec run the same expressions as the unit tests.
+//
+// Taken are the first arguments of ExpectEq, ExpectNoError, ExpectRuntimeError and
+// ExpectNameError which are a single string literal; expressions built at run time, spanning
+// lines or expected to fail to read are left out.
+//
+// extract_expressions OUTPUT SOURCE...
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+constexpr std::string_view kCalls[] = {"ExpectEq(", "ExpectNoError(", "ExpectRuntimeError(",
+                                       "ExpectNameError("};
+
+// Reads the literal starting at text[*pos], which has to be a '"', and moves *pos past it.
+std::optional<std::string> ReadLiteral(const std::string& text, size_t* pos) {
+    if (*pos >= text.size() || text[*pos] != '"') {
+        return std::nullopt;
+    }
+    std::string res;
+    for (size_t i = *pos + 1; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"') {
+            *pos = i + 1;
+            return res;
+        }
+        if (c == '\n') {
+            return std::nullopt;
+        }
+        if (c == '\\' && i + 1 < text.size()) {
+            c = text[++i];
+            switch (c) {
+                case 'n':
+                    c = '\n';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case '"':
+                case '\\':
+                case '\'':
+                    break;
+                default:
+                    return std::nullopt;
+            }
+        }
+        res += c;
+    }
+    return std::nullopt;
+}
+
+void Extract(const std::string& text, std::ostream* out) {
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        std::string_view rest = std::string_view(text).substr(pos);
+        size_t length = 0;
+        for (std::string_view call : kCalls) {
+            if (rest.starts_with(call)) {
+                length = call.size();
+            }
+        }
+        if (length == 0) {
+            continue;
+        }
+        size_t end = pos + length;
+        std::optional<std::string> expression = ReadLiteral(text, &end);
+        while (end < text.size() && std::isspace(static_cast<unsigned char>(text[end]))) {
+            ++end;
+        }
+        if (!expression.has_value() || end == text.size() ||
+            (text[end] != ',' && text[end] != ')') ||
+            expression->find('\n') != std::string::npos) {
+            continue;
+        }
+        *out << *expression << '\n';
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " OUTPUT SOURCE..." << std::endl;
+        return 2;
+    }
+    std::stringstream expressions;
+    for (int i = 2; i < argc; ++i) {
+        std::ifstream source(argv[i]);
+        if (!source) {
+            std::cerr << "Can not open " << argv[i] << std::endl;
+            return 1;
+        }
+        std::stringstream text;
+        text << source.rdbuf();
+        Extract(text.str(), &expressions);
+    }
+    std::ofstream output(argv[1]);
+    output << expressions.str();
+    return output ? 0 : 1;
+}
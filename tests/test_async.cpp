@@ -0,0 +1,129 @@
+#include "scheme_test.h"
+
+#include <sstream>
+
+#include <scheme/parser.h>
+#include <scheme/scheduler.h>
+
+TEST_CASE_METHOD(SchemeTest, "SpawnAndAwait") {
+    ExpectEq("(await (spawn (+ 1 2)))", "3");
+    ExpectEq("(await (spawn '(1 2)))", "(1 2)");
+    ExpectEq("(+ (await (spawn 1)) (await (spawn (* 2 3))))", "7");
+    ExpectEq("(task-done? (car (list (spawn 1) (yield))))", "#t");
+    ExpectEq("(task-done? (spawn 1))", "#f");
+
+    ExpectRuntimeError("(await 1)");
+    ExpectRuntimeError("(await (spawn (car '())))");
+    ExpectRuntimeError("(spawn)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ChannelReceiveWithoutSenders") {
+    ExpectRuntimeError("(channel-receive (make-channel))");
+    ExpectRuntimeError("(channel-send 1 2)");
+}
+
+class SchedulerTest {
+public:
+    SchedulerTest() : env_(std::make_shared<Environemnt>()) {
+        env_->FullfillR5RS();
+        scheduler_.Install(env_.get());
+    }
+
+    std::string Eval(const std::string& expression) {
+        std::stringstream ss{expression};
+        Tokenizer tokenizer{&ss};
+        return Object::ToString(Object::Eval(Read(&tokenizer), env_));
+    }
+
+protected:
+    Ptr<Environemnt> env_;
+    Scheduler scheduler_;
+};
+
+TEST_CASE_METHOD(SchedulerTest, "ChannelsBetweenTasks") {
+    env_->Define("ch", std::make_shared<Channel>());
+
+    Eval("(spawn (channel-send ch (+ 1 2)))");
+    Eval("(spawn (channel-send ch (* 2 3)))");
+    REQUIRE(scheduler_.PendingCount() == 2);
+
+    REQUIRE(Eval("(channel-receive ch)") == "3");
+    REQUIRE(scheduler_.PendingCount() == 1);
+    REQUIRE(Eval("(channel-receive ch)") == "6");
+    REQUIRE(scheduler_.PendingCount() == 0);
+}
+
+TEST_CASE_METHOD(SchedulerTest, "BlockedTaskRunsOthers") {
+    env_->Define("ch", std::make_shared<Channel>());
+
+    Eval("(spawn (channel-send ch (+ 1 (channel-receive ch))))");
+    Eval("(spawn (channel-send ch 41))");
+    REQUIRE(Eval("(await (spawn (channel-receive ch)))") == "42");
+}
+
+TEST_CASE_METHOD(SchedulerTest, "ThousandsOfTasks") {
+    env_->Define("ch", std::make_shared<Channel>());
+
+    for (int i = 0; i < 10000; ++i) {
+        Eval("(spawn (channel-send ch " + std::to_string(i) + "))");
+    }
+    REQUIRE(scheduler_.PendingCount() == 10000);
+    REQUIRE(scheduler_.RunPending() == 10000);
+    REQUIRE(Eval("(channel-receive ch)") == "0");
+}
+
+TEST_CASE_METHOD(SchedulerTest, "BlockedTasksWaitForOneAnother") {
+    env_->Define("a", std::make_shared<Channel>());
+    env_->Define("b", std::make_shared<Channel>());
+    env_->Define("c", std::make_shared<Channel>());
+
+    // Each task blocks on one spawned after it, which in turn waits for the last one.
+    Eval("(spawn (channel-send b (+ 1 (channel-receive a))))");
+    Eval("(spawn (channel-send c (* 2 (channel-receive b))))");
+    REQUIRE(Eval("(await (spawn ((lambda () (channel-send a 20) (channel-receive c)))))") == "42");
+
+    Eval("(define first (spawn (await second)))");
+    Eval("(define second (spawn ((lambda () (yield) 5))))");
+    REQUIRE(Eval("(await first)") == "5");
+
+    // Left blocked; destroying the scheduler unwinds its stack.
+    Eval("(spawn (channel-receive a))");
+    REQUIRE(scheduler_.RunPending() == 1);
+    REQUIRE(scheduler_.BlockedCount() == 1);
+}
+
+TEST_CASE_METHOD(SchedulerTest, "ThousandsOfBlockedTasks") {
+    Eval("(define (chain n in)"
+         "  (if (= n 0)"
+         "      in"
+         "      (let ((out (make-channel)))"
+         "        (spawn (channel-send out (+ 1 (channel-receive in))))"
+         "        (chain (- n 1) out))))");
+    Eval("(define in (make-channel))");
+    Eval("(define out (chain 10000 in))");
+    REQUIRE(scheduler_.RunPending() == 10000);
+    REQUIRE(scheduler_.BlockedCount() == 10000);
+
+    Eval("(channel-send in 0)");
+    REQUIRE(Eval("(channel-receive out)") == "10000");
+    REQUIRE(scheduler_.BlockedCount() == 0);
+}
+
+TEST_CASE_METHOD(SchedulerTest, "TasksRecurseDeeply") {
+    Eval("(define (depth n) (if (= n 0) 0 (+ 1 (depth (- n 1)))))");
+    REQUIRE(scheduler_.GetStackSize() == Scheduler::kDefaultStackSize);
+    REQUIRE(Eval("(await (spawn (depth 50)))") == "50");
+    // Past its small stack a task fails, and the next ones run as usual.
+    REQUIRE_THROWS_AS(Eval("(await (spawn (depth 100000)))"), RuntimeError);
+    REQUIRE(Eval("(await (spawn (depth 50)))") == "50");
+
+    // With as much stack as the interpreter thread, as deep as there.
+    scheduler_.SetStackSize(size_t{8} << 20);
+    REQUIRE(Eval("(await (spawn (depth 3000)))") == "3000");
+    scheduler_.SetStackSize(0);
+    REQUIRE(scheduler_.GetStackSize() == Scheduler::kMinStackSize);
+    REQUIRE_THROWS_AS(Eval("(await (spawn (depth 3000)))"), RuntimeError);
+
+    Eval("(define self (spawn (await self)))");
+    REQUIRE_THROWS_AS(Eval("(await self)"), RuntimeError);
+}
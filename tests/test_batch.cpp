@@ -0,0 +1,147 @@
+#include "scheme_test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace {
+using Status = BatchResult::Status;
+}  // namespace
+
+TEST_CASE("BatchSharesGlobalScope") {
+    Interpreter interpreter;
+    std::vector<std::string_view> expressions = {"(define x 2)", "(set! x (* x 21))", "x",
+                                                 "(+ x 1) ignored"};
+    std::vector<BatchResult> results;
+    interpreter.RunBatch(expressions, &results);
+
+    REQUIRE(results.size() == 4);
+    for (const auto& result : results) {
+        REQUIRE(result.status == Status::OK);
+    }
+    REQUIRE(results[2].value == "42");
+    REQUIRE(results[3].value == "43");
+    REQUIRE(interpreter.Run("x") == "42");
+}
+
+TEST_CASE("BatchReportsErrorsPerItem") {
+    Interpreter interpreter;
+    std::vector<std::string_view> expressions = {"(+ 1 2)", "(car '())", "(+ 1", "",
+                                                 "undefined", "(- 5 1)"};
+    std::vector<BatchResult> results;
+    interpreter.RunBatch(expressions, &results);
+
+    REQUIRE(results.size() == 6);
+    REQUIRE(results[0].status == Status::OK);
+    REQUIRE(results[0].value == "3");
+    REQUIRE(results[1].status == Status::RUNTIME_ERROR);
+    REQUIRE(results[2].status == Status::SYNTAX_ERROR);
+    REQUIRE(results[3].status == Status::SYNTAX_ERROR);
+    REQUIRE(results[4].status != Status::OK);
+    REQUIRE(results[5].status == Status::OK);
+    REQUIRE(results[5].value == "4");
+}
+
+TEST_CASE("BatchReportsArityErrors") {
+    Interpreter interpreter;
+    std::vector<std::string_view> expressions = {"(car)", "(- )", "(substring \"abc\")",
+                                                 "(string<? )", "(eq? 1)", "(map car)",
+                                                 "(length '() '())"};
+    std::vector<BatchResult> results;
+    interpreter.RunBatch(expressions, &results);
+
+    REQUIRE(results.size() == 7);
+    for (const auto& result : results) {
+        REQUIRE(result.status == Status::RUNTIME_ERROR);
+    }
+    REQUIRE(results[0].value == "car must have exactly 1 argument");
+    REQUIRE(results[1].value == "- must have at least 1 argument");
+    REQUIRE(results[2].value == "substring must have 2 to 3 arguments");
+    REQUIRE(results[3].value == "string<? must have at least 1 argument");
+    REQUIRE(results[4].value == "eq? must have exactly 2 arguments");
+    REQUIRE(results[5].value == "map must have at least 2 arguments");
+    REQUIRE(results[6].value == "length must have exactly 1 argument");
+}
+
+TEST_CASE("BatchReportsEveryErrorPerItem") {
+    Interpreter interpreter;
+    interpreter.GetGlobalScope()->Define(
+        "fail", std::make_shared<Procedure<Object>>([](const std::vector<Ptr<Object>>&) {
+            throw std::logic_error("not a scheme error");
+            return Ptr<Object>();
+        }));
+    std::string path = std::filesystem::temp_directory_path() / "scheme_batch_lazy.scm";
+    std::ofstream(path) << "(1 99999999999999)";
+    std::string load = "(define data (load-data \"" + path + "\"))";
+    std::vector<std::string_view> expressions = {"99999999999999", "(fail)", load,
+                                                 "(car (cdr data))", "(car data)"};
+    std::vector<BatchResult> results;
+    interpreter.RunBatch(expressions, &results);
+
+    REQUIRE(results.size() == 5);
+    REQUIRE(results[0].status == Status::SYNTAX_ERROR);
+    REQUIRE(results[1].status == Status::RUNTIME_ERROR);
+    REQUIRE(results[1].value == "not a scheme error");
+    REQUIRE(results[2].status == Status::OK);
+    REQUIRE(results[3].status == Status::SYNTAX_ERROR);
+    REQUIRE(results[4].value == "1");
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("BatchReusesResults") {
+    Interpreter interpreter;
+    std::vector<BatchResult> results;
+    std::vector<std::string_view> large = {"1", "2", "3"};
+    interpreter.RunBatch(large, &results);
+    REQUIRE(results.size() == 3);
+
+    std::vector<std::string_view> small = {"(car '())"};
+    interpreter.RunBatch(small, &results);
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].status == Status::RUNTIME_ERROR);
+
+    interpreter.RunBatch(large, &results);
+    REQUIRE(results[0].status == Status::OK);
+    REQUIRE(results[0].value == "1");
+}
+
+TEST_CASE("BatchFromStream") {
+    Interpreter interpreter;
+    std::vector<BatchResult> results;
+    std::stringstream input{"(define (f x) (* x x))\n(f 7) (car '())\n\n(f 3)"};
+    interpreter.RunBatch(&input, &results);
+
+    REQUIRE(results.size() == 4);
+    REQUIRE(results[1].value == "49");
+    REQUIRE(results[2].status == Status::RUNTIME_ERROR);
+    REQUIRE(results[3].value == "9");
+
+    std::stringstream broken{"(f 2) (f 3"};
+    interpreter.RunBatch(&broken, &results);
+    REQUIRE(results.size() == 2);
+    REQUIRE(results[0].value == "4");
+    REQUIRE(results[1].status == Status::SYNTAX_ERROR);
+
+    REQUIRE_FALSE(interpreter.RunFile("/nonexistent/script.scm", &results));
+}
+
+TEST_CASE("StreamReportsPositions") {
+    Interpreter interpreter;
+    std::stringstream input{"(define (f x)\n  (* x x))\n(f 7)  (car '())\n\n  (f\n 3) (f 2"};
+    std::vector<BatchResult> results;
+    interpreter.RunStream(&input, [&](const BatchResult& result) { results.push_back(result); });
+
+    REQUIRE(results.size() == 5);
+    REQUIRE(results[0].position == Position{1, 1});
+    REQUIRE(results[1].value == "49");
+    REQUIRE(results[1].position == Position{3, 1});
+    REQUIRE(results[2].status == Status::RUNTIME_ERROR);
+    REQUIRE(results[2].position == Position{3, 8});
+    REQUIRE(results[3].value == "9");
+    REQUIRE(results[3].position == Position{5, 3});
+    REQUIRE(results[4].status == Status::SYNTAX_ERROR);
+    REQUIRE(results[4].position == Position{6, 5});
+}
@@ -0,0 +1,87 @@
+#include "scheme_test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <scheme/binary.h>
+#include <scheme/parser.h>
+
+namespace {
+Ptr<Object> ReadText(const std::string& text) {
+    std::stringstream ss{text};
+    Tokenizer tokenizer{&ss};
+    return Read(&tokenizer);
+}
+
+std::string Encode(const std::string& text) {
+    std::string data;
+    WriteBinary(ReadText(text), &data);
+    return data;
+}
+}  // namespace
+
+TEST_CASE("BinaryRoundTrip") {
+    for (std::string text : {"()", "0", "-1", "2147483647", "-2147483648", "abc", "(1 2 3)",
+                             "(a (b c) . d)", "(1 . 2)", "((()) (a a) a)", "(quote (x y))",
+                             "(\"\" \"a (b\" \"a string longer than an inline one\")"}) {
+        REQUIRE(Object::ToString(ReadBinary(Encode(text))) == Object::ToString(ReadText(text)));
+    }
+    std::string data;
+    WriteBinary(std::make_shared<Cell>(std::make_shared<Boolean>(true),
+                                       std::make_shared<Boolean>(false)),
+                &data);
+    REQUIRE(Object::ToString(ReadBinary(data)) == "(#t . #f)");
+}
+
+TEST_CASE("BinaryIsCompact") {
+    std::string text = "(";
+    for (int i = 0; i < 1000; ++i) {
+        text += std::to_string(i % 50) + " symbol ";
+    }
+    text += ")";
+    std::string data = Encode(text);
+    // One byte for the tag and one for the number, two for a symbol reference.
+    REQUIRE(data.size() < 4 * 2000 + 32);
+
+    auto list = ReadBinary(data);
+    auto second = As<Cell>(list)->GetSecond();
+    auto fourth = As<Cell>(As<Cell>(second)->GetSecond())->GetSecond();
+    REQUIRE(As<Cell>(second)->GetFirst() == As<Cell>(fourth)->GetFirst());
+}
+
+TEST_CASE("BinaryRejectsMalformedData") {
+    std::string data = Encode("(1 2 (3 4) five)");
+    for (size_t size = 0; size < data.size(); ++size) {
+        REQUIRE_THROWS_AS(ReadBinary(data.substr(0, size)), SyntaxError);
+    }
+    REQUIRE_THROWS_AS(ReadBinary(data + '\0'), SyntaxError);
+    REQUIRE_THROWS_AS(ReadBinary("SCB\x01\x06\xff\xff\xff\xff\x0f"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadBinary(std::string("SCB\x01\x05\x03", 6)), SyntaxError);
+
+    std::string out;
+    REQUIRE_THROWS_AS(WriteBinary(std::make_shared<Bytes>("x"), &out), RuntimeError);
+}
+
+TEST_CASE("BinaryReadsMappedFiles") {
+    std::string path = std::filesystem::temp_directory_path() / "scheme_test_binary.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << Encode("(define (f x) (* x x))");
+    }
+    {
+        MappedFile file(path);
+        REQUIRE(Object::ToString(ReadBinary(file.GetData())) == "(define (f x) (* x x))");
+    }
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(MappedFile(path), RuntimeError);
+}
+
+TEST_CASE_METHOD(SchemeTest, "BinaryBuiltins") {
+    ExpectEq("(read-binary (write-binary '(1 (2 #t) . x)))", "(1 (2 #t) . x)");
+    ExpectEq("(read-binary (write-binary 5))", "5");
+    ExpectEq("(write-binary '())", "Bytes");
+    ExpectRuntimeError("(write-binary car)");
+    ExpectRuntimeError("(read-binary '(1 2))");
+    ExpectRuntimeError("(write-binary)");
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+
+#include <scheme/codegen.h>
+
+namespace {
+Translation Translate(const std::string& source) {
+    std::stringstream ss{source};
+    return TranslateToCpp(&ss, "test.scm");
+}
+
+bool Contains(const std::string& code, const std::string& part) {
+    return code.find(part) != std::string::npos;
+}
+}  // namespace
+
+TEST_CASE("TranslatesBuiltinsToDirectCalls") {
+    auto translation = Translate("(define (f x) (if (< x 2) (car (list x)) (+ x 1)))");
+    REQUIRE(translation.translated == 1);
+    REQUIRE(translation.interpreted == 0);
+    REQUIRE(Contains(translation.code, "compiled::Test(compiled::Fixnum::LESS"));
+    REQUIRE(Contains(translation.code, "compiled::Arithmetic(compiled::Fixnum::ADD"));
+    REQUIRE(Contains(translation.code, "compiled::Car("));
+    REQUIRE(Contains(translation.code, "program.Builtin(\"list\")"));
+    REQUIRE(!Contains(translation.code, "compiled::Call("));
+}
+
+TEST_CASE("TranslatesReboundBuiltinsAsGlobals") {
+    auto translation = Translate("(define (f x) (+ x 1))\n(define + -)");
+    REQUIRE(translation.translated == 2);
+    REQUIRE(!Contains(translation.code, "compiled::Arithmetic"));
+    REQUIRE(Contains(translation.code, "compiled::Global g0{&program, \"+\"}"));
+}
+
+TEST_CASE("LoopsOnSelfTailCalls") {
+    auto translation = Translate("(define (loop n) (if (= n 0) 0 (loop (- n 1))))");
+    REQUIRE(Contains(translation.code, "continue;"));
+
+    translation = Translate("(define (loop n) (if (= n 0) 0 (loop (- n 1))))\n(set! loop 1)");
+    REQUIRE(!Contains(translation.code, "continue;"));
+}
+
+TEST_CASE("InterpretsUntranslatableForms") {
+    auto translation = Translate("(spawn 1)\n((lambda args args) 1)\n(+ 1 2)");
+    REQUIRE(translation.translated == 1);
+    REQUIRE(translation.interpreted == 2);
+    REQUIRE(Contains(translation.code, "{nullptr, \"(spawn 1)\"}"));
+}
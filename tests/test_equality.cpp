@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+
+#include <scheme/equality.h>
+#include <scheme/hash_cons.h>
+
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "EqualityPredicates") {
+    ExpectEq("(eq? 'a 'a)", "#t");
+    ExpectEq("(eq? 'a 'b)", "#f");
+    ExpectEq("(eq? '() '())", "#t");
+    ExpectEq("(eq? #t #t)", "#t");
+    ExpectEq("(eq? '(1) '(1))", "#f");
+    ExpectEq("(eq? car car)", "#t");
+    ExpectNoError("(define x '(1 2))");
+    ExpectEq("(eq? x x)", "#t");
+    ExpectEq("(eq? (cdr x) (cdr x))", "#t");
+
+    ExpectEq("(eqv? 100000 100000)", "#t");
+    ExpectEq("(eqv? 1 2)", "#f");
+    ExpectEq("(eqv? 1 'a)", "#f");
+    ExpectEq("(eqv? '(1) '(1))", "#f");
+
+    ExpectEq("(equal? '(1 (2 a) . 3) '(1 (2 a) . 3))", "#t");
+    ExpectEq("(equal? '(1 (2 a) . 3) '(1 (2 b) . 3))", "#f");
+    ExpectEq("(equal? '(1 2) '(1 2 3))", "#f");
+    ExpectEq("(equal? '((1)) '(1))", "#f");
+    ExpectEq("(equal? '() '())", "#t");
+    ExpectEq("(equal? 5 5)", "#t");
+    ExpectRuntimeError("(equal? 1)");
+
+    ExpectEq("(memq 'c '(a b c d))", "(c d)");
+    ExpectEq("(memv 100000 '(1 100000))", "(100000)");
+    ExpectEq("(member '(1) '(1 (1)))", "((1))");
+    ExpectEq("(memq '(1) '(1 (1)))", "#f");
+    ExpectEq("(assv 2 '((1 one) (2 two)))", "(2 two)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "EqualOnLongAndDeepLists") {
+    ExpectNoError("(define (range-from n acc) (if (= n 0) acc (range-from (- n 1) (cons n acc))))");
+    ExpectNoError("(define (nest n acc) (if (= n 0) acc (nest (- n 1) (list acc))))");
+    ExpectEq("(equal? (range-from 1000000 '()) (range-from 1000000 '()))", "#t");
+    ExpectEq("(equal? (range-from 1000000 '()) (range-from 999999 '()))", "#f");
+    ExpectEq("(equal? (nest 2000 1) (nest 2000 1))", "#t");
+    ExpectEq("(equal? (nest 2000 1) (nest 2000 2))", "#f");
+}
+
+TEST_CASE("EqualTerminatesOnCycles") {
+    // a is (1 1 1 ...) with a cycle of one pair, b the same with a cycle of two.
+    auto a = MakeCell(MakeNumber(1), nullptr);
+    a->GetSecond() = a;
+    auto b = MakeCell(MakeNumber(1), MakeCell(MakeNumber(1), nullptr));
+    As<Cell>(b->GetSecond())->GetSecond() = b;
+    auto c = MakeCell(MakeNumber(1), MakeCell(MakeNumber(2), nullptr));
+    As<Cell>(c->GetSecond())->GetSecond() = c;
+
+    REQUIRE(IsEqual(a, a));
+    REQUIRE(IsEqual(a, b));
+    REQUIRE_FALSE(IsEqual(a, c));
+
+    // A cycle through cars.
+    auto d = MakeCell(nullptr, nullptr);
+    d->GetFirst() = d;
+    auto e = MakeCell(nullptr, nullptr);
+    e->GetFirst() = e;
+    REQUIRE(IsEqual(d, e));
+
+    for (const auto& cell : {a, b, c, d, e}) {
+        cell->GetFirst() = nullptr;
+        cell->GetSecond() = nullptr;
+    }
+}
+
+TEST_CASE("EqualComparesInternedDataByIdentity") {
+    HashConsTable table;
+    auto a = table.Intern(MakeCell(MakeNumber(1), MakeCell(MakeNumber(2), nullptr)));
+    auto b = table.Intern(MakeCell(MakeNumber(1), MakeCell(MakeNumber(2), nullptr)));
+    auto c = table.Intern(MakeCell(MakeNumber(1), nullptr));
+    REQUIRE(IsEqual(a, b));
+    REQUIRE_FALSE(IsEqual(a, c));
+    REQUIRE(IsEqual(a, MakeCell(MakeNumber(1), MakeCell(MakeNumber(2), nullptr))));
+}
@@ -1,5 +1,9 @@
 #include "scheme_test.h"
 
+#include <sstream>
+
+#include <scheme/parser.h>
+
 TEST_CASE_METHOD(SchemeTest, "Quote") {
     ExpectEq("(quote (1 2))", "(1 2)");
     ExpectEq("'(1 2)", "(1 2)");
@@ -11,3 +15,30 @@ TEST_CASE_METHOD(SchemeTest, "Be careful") {
     ExpectRuntimeError("('() ())");
     ExpectEq("'(())", "(())");
 }
+
+TEST_CASE("TryEvalReturnsErrors") {
+    auto env = std::make_shared<Environemnt>();
+    env->FullfillR5RS();
+    auto eval = [&env](const std::string& expression) {
+        std::stringstream ss{expression};
+        Tokenizer tokenizer{&ss};
+        return Object::TryEval(Read(&tokenizer), env);
+    };
+
+    auto value = eval("(+ 1 (car '(2 3)))");
+    REQUIRE(value.IsOk());
+    REQUIRE(Object::ToString(value.GetValue()) == "3");
+
+    for (const char* expression : {"undefined", "(car 1)", "(1 2)", "(+ 1 (car '()))",
+                                   "((lambda (x) x))", "(car)", "(cons 1)"}) {
+        auto error = eval(expression);
+        REQUIRE_FALSE(error.IsOk());
+        REQUIRE(error.GetError().kind == Error::Kind::RUNTIME);
+    }
+    REQUIRE(eval("(cons 1)").GetError().message == "cons must have exactly 2 arguments");
+    REQUIRE_FALSE(Object::TryEval(nullptr, env).IsOk());
+
+    REQUIRE_FALSE(env->Find("undefined").IsOk());
+    REQUIRE(env->Find("car").IsOk());
+    REQUIRE_FALSE(TryAs<Number>(env->Find("car").GetValue()).IsOk());
+}
@@ -0,0 +1,125 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+
+#include <scheme/hash_cons.h>
+#include <scheme/parser.h>
+#include <scheme/scheme.h>
+
+namespace {
+Ptr<Object> ReadDatum(const std::string& str) {
+    std::stringstream ss{str};
+    Tokenizer tokenizer{&ss};
+    return Read(&tokenizer);
+}
+
+Ptr<Object> Global(Interpreter* interpreter, const std::string& name) {
+    return interpreter->GetGlobalScope()->Lookup(name)->value;
+}
+}  // namespace
+
+TEST_CASE("InternsEqualDataOnce") {
+    HashConsTable table;
+    auto a = table.Intern(ReadDatum("(1 (x 100000) . y)"));
+    auto b = table.Intern(ReadDatum("(1 (x 100000) . y)"));
+    REQUIRE(a == b);
+    REQUIRE(Object::ToString(a) == "(1 (x 100000) . y)");
+    REQUIRE(Is<ConsedCell>(a));
+
+    auto c = table.Intern(ReadDatum("((x 100000) (x 100000))"));
+    REQUIRE(As<Cell>(c)->GetFirst() == As<Cell>(As<Cell>(c)->GetSecond())->GetFirst());
+    REQUIRE(As<Cell>(c)->GetFirst() == As<Cell>(As<Cell>(a)->GetSecond())->GetFirst());
+    REQUIRE(table.Intern(ReadDatum("y")) == As<Cell>(As<Cell>(a)->GetSecond())->GetSecond());
+    REQUIRE(table.Intern(nullptr) == nullptr);
+
+    size_t size = table.GetSize();
+    table.Intern(ReadDatum("(1 (x 100000) . y)"));
+    REQUIRE(table.GetSize() == size);
+
+    REQUIRE(CompareConsed(a, b) == true);
+    REQUIRE(CompareConsed(a, c) == false);
+    REQUIRE(CompareConsed(a, ReadDatum("(1 (x 100000) . y)")) == std::nullopt);
+
+    table.Clear();
+    REQUIRE(table.GetSize() == 0);
+    auto d = table.Intern(ReadDatum("(1 (x 100000) . y)"));
+    REQUIRE(d != a);
+    REQUIRE(CompareConsed(a, d) == std::nullopt);
+}
+
+TEST_CASE("InternsLongLists") {
+    std::string text = "(";
+    for (int i = 0; i < 200000; ++i) {
+        text += std::to_string(i % 7) + " ";
+    }
+    text += ")";
+    HashConsTable table;
+    auto list = table.Intern(ReadDatum(text));
+    REQUIRE(table.Intern(ReadDatum(text)) == list);
+    REQUIRE(table.GetSize() == 200000 + 7);
+}
+
+TEST_CASE("SharesQuotedDataAcrossRuns") {
+    Interpreter interpreter;
+    interpreter.Run("(define a '(1 2 (3 4)))");
+    interpreter.Run("(define b '(1 2 (3 4)))");
+    REQUIRE(Global(&interpreter, "a") != Global(&interpreter, "b"));
+
+    // Only forms read afterwards are interned, not the ones already in the parse cache.
+    interpreter.SetHashConsing(true);
+    interpreter.Run("(define a '(1 2 (3 4)) )");
+    interpreter.Run("(define b '(0 1 2 (3 4)))");
+    interpreter.Run("(define c (car (cdr (cdr '(1 2 (3 4))))))");
+    REQUIRE(Global(&interpreter, "a") == As<Cell>(Global(&interpreter, "b"))->GetSecond());
+    REQUIRE(Interpreter{}.Run("(car (cdr (cdr '(1 2 (3 4)))))") == "(3 4)");
+
+    // Forms the parse cache keeps hand out the same interned data on every run.
+    REQUIRE(interpreter.Run("(define d '(3 4))") == "()");
+    REQUIRE(interpreter.Run("(define d '(3 4))") == "()");
+    REQUIRE(Global(&interpreter, "c") == Global(&interpreter, "d"));
+    REQUIRE(interpreter.GetParseCache().GetHits() == 1);
+    REQUIRE(interpreter.Run("(length (append '(3 4) c))") == "4");
+}
+
+TEST_CASE("DoesNotInternArgumentsOfARebindedQuote") {
+    Interpreter interpreter;
+    interpreter.SetHashConsing(true);
+    interpreter.Run("(define quote list)");
+    REQUIRE(interpreter.Run("(quote (+ 1 2) 4)") == "(3 4)");
+    REQUIRE(interpreter.GetHashConsTable().GetSize() == 0);
+}
+
+TEST_CASE("ComparesInternedStringsByContent") {
+    Interpreter interpreter;
+    interpreter.SetHashConsing(true);
+    REQUIRE(interpreter.Run("(equal? '(\"a\" 1) '(\"a\" 1))") == "#t");
+    REQUIRE(interpreter.Run("(equal? '(\"a\" 1) '(\"b\" 1))") == "#f");
+    REQUIRE(interpreter.Run("(member '(\"x\") '((\"x\")))") == "((\"x\"))");
+
+    HashConsTable table;
+    REQUIRE(table.Intern(ReadDatum("(\"a\" 1)")) == table.Intern(ReadDatum("(\"a\" 1)")));
+
+    // Pairs holding what the table can not intern are left out of it.
+    auto procedure = Global(&interpreter, "car");
+    auto list = table.Intern(MakeCell(procedure, ReadDatum("(1)")));
+    REQUIRE_FALSE(Is<ConsedCell>(list));
+    REQUIRE(Is<ConsedCell>(As<Cell>(list)->GetSecond()));
+    REQUIRE(CompareConsed(list, table.Intern(MakeCell(procedure, ReadDatum("(1)")))) ==
+            std::nullopt);
+}
+
+TEST_CASE("DoesNotInternArgumentsOfALexicalQuote") {
+    Interpreter interpreter;
+    interpreter.SetHashConsing(true);
+    REQUIRE(interpreter.Run("((lambda (quote) (quote (+ 1 2))) (lambda (x) x))") == "3");
+    REQUIRE(interpreter.Run("(let ((quote list)) (quote (+ 1 2) 4))") == "(3 4)");
+    interpreter.Run("(define (f quote) (quote (* 2 3)))");
+    REQUIRE(interpreter.Run("(f list)") == "(6)");
+    interpreter.Run("(define (g) (define (quote x) (* x 10)) (quote (+ 1 2)))");
+    REQUIRE(interpreter.Run("(g)") == "30");
+    REQUIRE(interpreter.GetHashConsTable().GetSize() == 0);
+
+    // Quote is still the builtin outside of them.
+    REQUIRE(interpreter.Run("(let ((x '(1 2))) x)") == "(1 2)");
+    REQUIRE(interpreter.GetHashConsTable().GetSize() == 4);
+}
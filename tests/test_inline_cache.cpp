@@ -0,0 +1,79 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+
+#include <scheme/error.h>
+#include <scheme/parser.h>
+
+namespace {
+Ptr<Object> ReadAll(const std::string& str) {
+    std::stringstream ss{str};
+    Tokenizer tokenizer{&ss};
+    return Read(&tokenizer);
+}
+}  // namespace
+
+TEST_CASE("CachedSiteIsReevaluated") {
+    auto env = std::make_shared<Environemnt>();
+    env->FullfillR5RS();
+
+    auto ast = ReadAll("(+ 1 (car '(2 3)) (* 2 3))");
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(Object::ToString(Object::Eval(ast, env)) == "9");
+    }
+}
+
+TEST_CASE("CacheSeesRebinding") {
+    auto env = std::make_shared<Environemnt>();
+    env->FullfillR5RS();
+
+    auto ast = ReadAll("(+ x 1)");
+    env->Define("x", std::make_shared<Number>(1));
+    REQUIRE(Object::ToString(Object::Eval(ast, env)) == "2");
+
+    uint64_t version = env->GetVersion();
+    env->Define("x", std::make_shared<Number>(10));
+    REQUIRE(env->GetVersion() != version);
+    REQUIRE(Object::ToString(Object::Eval(ast, env)) == "11");
+
+    env->Define("+", (*env)["*"]);
+    REQUIRE(Object::ToString(Object::Eval(ast, env)) == "10");
+}
+
+TEST_CASE("CacheIsPerEnvironment") {
+    auto first = std::make_shared<Environemnt>();
+    auto second = std::make_shared<Environemnt>();
+    first->FullfillR5RS();
+    second->FullfillR5RS();
+    REQUIRE(first->GetId() != second->GetId());
+
+    auto ast = ReadAll("(- x)");
+    first->Define("x", std::make_shared<Number>(1));
+    second->Define("x", std::make_shared<Number>(2));
+    REQUIRE(Object::ToString(Object::Eval(ast, first)) == "1");
+    REQUIRE(Object::ToString(Object::Eval(ast, second)) == "2");
+
+    auto empty = std::make_shared<Environemnt>();
+    REQUIRE_THROWS_AS(Object::Eval(ast, empty), RuntimeError);
+    REQUIRE(empty->Lookup("x") == nullptr);
+}
+
+TEST_CASE("OnlySourcePairsKeepCallSites") {
+    auto env = std::make_shared<Environemnt>();
+    env->FullfillR5RS();
+
+    auto ast = As<Cell>(ReadAll("(+ 1 2)"));
+    REQUIRE(Object::ToString(Object::Eval(ast, env)) == "3");
+    REQUIRE(ast->GetSite()->callable == As<Callable>((*env)["+"]).get());
+
+    std::stringstream ss{"(+ 1 2)"};
+    Tokenizer tokenizer{&ss};
+    auto datum = As<Cell>(ReadDatum(&tokenizer));
+    REQUIRE(datum->GetSite() == nullptr);
+    REQUIRE(Object::ToString(Object::Eval(datum, env)) == "3");
+
+    // Pairs built at run time are still evaluated as applications, just without a cache.
+    auto code = MakeCell(ReadAll("(lambda (x) (* x x))"), MakeCell(MakeNumber(7), nullptr));
+    REQUIRE(Object::ToString(Object::Eval(code, env)) == "49");
+    REQUIRE(sizeof(Cell) < sizeof(FormCell));
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include <limits>
+#include <sstream>
+
+#include <scheme/jit.h>
+#include <scheme/native.h>
+#include <scheme/parser.h>
+
+#include "scheme_test.h"
+
+namespace {
+class JitTest {
+public:
+    JitTest() : global_(std::make_shared<Environemnt>()) {
+        global_->FullfillR5RS();
+        auto shape = std::make_shared<Shape>();
+        shape->names = {"x", "y"};
+        frame_ = std::make_shared<Environemnt>(shape, global_);
+        for (auto& slot : frame_->GetSlots()) {
+            slot = std::make_shared<Binding>();
+        }
+    }
+
+    Ptr<Object> Specialized(const std::string& expression) {
+        std::stringstream ss{expression};
+        Tokenizer tokenizer{&ss};
+        return Specialize(Read(&tokenizer), frame_);
+    }
+
+    std::string Eval(const Ptr<Object>& ast) {
+        return Object::ToString(Object::Eval(ast, frame_));
+    }
+
+    void Set(int slot, Ptr<Object> value) {
+        *frame_->GetSlots()[slot] = std::move(value);
+    }
+
+protected:
+    Ptr<Environemnt> global_;
+    Ptr<Environemnt> frame_;
+};
+
+void CallRepeatedly(SchemeTest* test, const std::string& call, const std::string& result) {
+    for (size_t i = 0; i < kHotCalls + 1; ++i) {
+        test->ExpectEq(call, result);
+    }
+}
+}  // namespace
+
+TEST_CASE_METHOD(JitTest, "SpecializesArithmeticOnLocals") {
+    auto ast = Specialized("(+ x (* y 2))");
+    REQUIRE(Is<FixnumOp>(ast));
+    REQUIRE(ast->ToString() == "(+ x (* y 2))");
+    Set(0, std::make_shared<Number>(1));
+    Set(1, std::make_shared<Number>(3));
+    REQUIRE(Eval(ast) == "7");
+
+    REQUIRE(Is<LocalRef>(Specialized("x")));
+    REQUIRE(Is<Symbol>(Specialized("z")));
+    REQUIRE(Is<PairAccess>(Specialized("(car x)")));
+    REQUIRE(Is<Cell>(Specialized("(+ x y 1)")));
+    REQUIRE(Is<Cell>(Specialized("(lambda (x) (+ x 1))")));
+}
+
+TEST_CASE_METHOD(JitTest, "DeoptimizesOnGuardFailure") {
+    auto ast = Specialized("(+ x y)");
+    Set(0, std::make_shared<Number>(1));
+    Set(1, std::make_shared<Boolean>(true));
+    REQUIRE_THROWS_AS(Eval(ast), RuntimeError);
+    REQUIRE(As<FixnumOp>(ast)->GetDeopts() == 1);
+
+    Set(1, std::make_shared<Number>(2));
+    REQUIRE(Eval(ast) == "3");
+    REQUIRE(As<FixnumOp>(ast)->GetDeopts() == 1);
+
+    global_->Define("+", (*global_)["*"]);
+    REQUIRE(Eval(ast) == "2");
+
+    ast = Specialized("(cdr x)");
+    REQUIRE_THROWS_AS(Eval(ast), RuntimeError);
+}
+
+TEST_CASE_METHOD(SchemeTest, "HotProceduresKeepSemantics") {
+    ExpectNoError("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    ExpectEq("(fib 20)", "6765");
+
+    ExpectNoError("(define (f x) (+ x 1))");
+    CallRepeatedly(this, "(f 1)", "2");
+    ExpectRuntimeError("(f #t)");
+    ExpectNoError("(define + -)");
+    ExpectEq("(f 1)", "0");
+
+    ExpectNoError("(define (second l) (car (cdr l)))");
+    CallRepeatedly(this, "(second '(1 2))", "2");
+    ExpectRuntimeError("(second '(1))");
+
+    ExpectNoError("(define (g) (define x (h)) x)");
+    ExpectNoError("(define (h) 5)");
+    CallRepeatedly(this, "(g)", "5");
+}
+
+TEST_CASE_METHOD(JitTest, "CompilesFixnumTrees") {
+    auto ast = CompileNative(Specialized("(< (+ x 1) (* y -2))"), frame_);
+    REQUIRE(Is<NativeFixnum>(ast) == kNativeCode);
+    REQUIRE(ast->ToString() == "(< (+ x 1) (* y -2))");
+    Set(0, std::make_shared<Number>(-10));
+    Set(1, std::make_shared<Number>(3));
+    REQUIRE(Eval(ast) == "#t");
+    Set(1, std::make_shared<Number>(5));
+    REQUIRE(Eval(ast) == "#f");
+
+    ast = CompileNative(Specialized("(- (* x x) (+ y 7))"), frame_);
+    REQUIRE(Eval(ast) == "88");
+
+    // Only the arithmetic below the call is compiled.
+    ast = CompileNative(Specialized("(+ (car x) (* y 2))"), frame_);
+    REQUIRE(Is<FixnumOp>(ast));
+    REQUIRE(Is<NativeFixnum>(As<FixnumOp>(ast)->GetRhs()) == kNativeCode);
+    REQUIRE(Is<FixnumOp>(CompileNative(Specialized("(+ (< x y) 1)"), frame_)));
+}
+
+TEST_CASE_METHOD(JitTest, "NativeCodeDeoptimizes") {
+    if (!kNativeCode) {
+        return;
+    }
+    auto ast = CompileNative(Specialized("(+ (* x 2) y)"), frame_);
+    auto native = As<NativeFixnum>(ast);
+    Set(0, std::make_shared<Number>(1));
+    Set(1, std::make_shared<Boolean>(true));
+    REQUIRE_THROWS_AS(Eval(ast), RuntimeError);
+    REQUIRE(native->GetDeopts() == 1);
+
+    Set(1, std::make_shared<Number>(2));
+    REQUIRE(Eval(ast) == "4");
+    REQUIRE(native->GetDeopts() == 1);
+
+    // An overflow is left to the builtins.
+    Set(0, std::make_shared<Number>(std::numeric_limits<int>::max()));
+    REQUIRE(Eval(ast) == "0");
+    REQUIRE(native->GetDeopts() == 2);
+
+    Set(0, std::make_shared<Number>(3));
+    global_->Define("*", (*global_)["-"]);
+    REQUIRE(Eval(ast) == "3");
+    REQUIRE(native->GetDeopts() == 2);
+}
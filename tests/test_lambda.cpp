@@ -0,0 +1,156 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "DefineVariable") {
+    ExpectNoError("(define x 1)");
+    ExpectEq("x", "1");
+    ExpectNoError("(define x (+ x 10))");
+    ExpectEq("x", "11");
+
+    ExpectSyntaxError("(define)");
+    ExpectSyntaxError("(define x)");
+    ExpectSyntaxError("(define x 1 2)");
+    ExpectSyntaxError("(define 1 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SetVariable") {
+    ExpectNoError("(define x 1)");
+    ExpectNoError("(set! x (+ x 1))");
+    ExpectEq("x", "2");
+
+    ExpectRuntimeError("(set! y 1)");
+    ExpectSyntaxError("(set! x)");
+    ExpectSyntaxError("(set! 1 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "IfSyntax") {
+    ExpectEq("(if #t 1 2)", "1");
+    ExpectEq("(if #f 1 2)", "2");
+    ExpectEq("(if '() 1 2)", "1");
+    ExpectEq("(if #f 1)", "()");
+    ExpectEq("(if (< 1 2) (+ 1 2) (car '()))", "3");
+
+    ExpectSyntaxError("(if)");
+    ExpectSyntaxError("(if #t)");
+    ExpectSyntaxError("(if #t 1 2 3)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LambdaApplication") {
+    ExpectEq("((lambda (x) (+ x 1)) 5)", "6");
+    ExpectEq("((lambda () 1))", "1");
+    ExpectEq("((lambda (x y) (+ x y) (* x y)) 2 3)", "6");
+    ExpectEq("((lambda args args) 1 2 3)", "(1 2 3)");
+    ExpectEq("((lambda (x . rest) rest) 1 2 3)", "(2 3)");
+    ExpectEq("((lambda (x . rest) rest) 1)", "()");
+
+    ExpectRuntimeError("((lambda (x) x))");
+    ExpectRuntimeError("((lambda (x) x) 1 2)");
+    ExpectRuntimeError("((lambda (x y . z) x) 1)");
+    ExpectSyntaxError("(lambda (x))");
+    ExpectSyntaxError("(lambda (1) 1)");
+    ExpectSyntaxError("(lambda)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "DefineProcedure") {
+    ExpectNoError("(define (inc x) (+ x 1))");
+    ExpectEq("(inc 41)", "42");
+
+    ExpectNoError("(define (fact n) (if (= n 0) 1 (* n (fact (- n 1)))))");
+    ExpectEq("(fact 10)", "3628800");
+
+    ExpectNoError("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    ExpectEq("(fib 15)", "610");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LetSyntax") {
+    ExpectEq("(let ((x 1) (y 2)) (+ x y))", "3");
+    ExpectEq("(let () 5)", "5");
+    ExpectNoError("(define x 10)");
+    ExpectEq("(let ((x 1) (y x)) y)", "10");
+    ExpectEq("(let ((x 1)) (let ((x 2)) x))", "2");
+    ExpectEq("(let ((x 1)) (let ((y 2)) (+ x y)))", "3");
+
+    ExpectSyntaxError("(let ((x)) x)");
+    ExpectSyntaxError("(let ((1 2)) 1)");
+    ExpectSyntaxError("(let ((x 1)))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ClosuresCaptureVariables") {
+    ExpectNoError("(define (adder n) (lambda (x) (+ x n)))");
+    ExpectNoError("(define add2 (adder 2))");
+    ExpectNoError("(define add5 (adder 5))");
+    ExpectEq("(add2 1)", "3");
+    ExpectEq("(add5 1)", "6");
+    ExpectEq("((((lambda (x) (lambda (y) (lambda (z) (+ x y z)))) 1) 2) 3)", "6");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ClosuresShareMutableState") {
+    ExpectNoError("(define (make-counter) (let ((n 0)) (lambda () (set! n (+ n 1)) n)))");
+    ExpectNoError("(define c1 (make-counter))");
+    ExpectNoError("(define c2 (make-counter))");
+    ExpectEq("(c1)", "1");
+    ExpectEq("(c1)", "2");
+    ExpectEq("(c2)", "1");
+    ExpectEq("(c1)", "3");
+
+    ExpectNoError(
+        "(define (make-account balance)"
+        "  (define (withdraw amount) (set! balance (- balance amount)) balance)"
+        "  withdraw)");
+    ExpectNoError("(define acc (make-account 100))");
+    ExpectEq("(acc 10)", "90");
+    ExpectEq("(acc 10)", "80");
+}
+
+TEST_CASE_METHOD(SchemeTest, "InternalDefines") {
+    ExpectNoError(
+        "(define (parity n)"
+        "  (define (ev? n) (if (= n 0) #t (od? (- n 1))))"
+        "  (define (od? n) (if (= n 0) #f (ev? (- n 1))))"
+        "  (ev? n))");
+    ExpectEq("(parity 10)", "#t");
+    ExpectEq("(parity 7)", "#f");
+
+    ExpectRuntimeError("((lambda () (define y x) (define x 1) y))");
+    ExpectSyntaxError("((lambda () (if #t (define z 1)) z))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LocalsShadowGlobals") {
+    ExpectNoError("(define (f + a b) (+ a b))");
+    ExpectEq("(f * 2 3)", "6");
+    ExpectEq("(f - 2 3)", "-1");
+    ExpectNoError("(define (g car) (car '(1 2)))");
+    ExpectEq("(g cdr)", "(2)");
+    ExpectEq("(car '(1 2))", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "RedefinitionIsVisibleToCallers") {
+    ExpectNoError("(define (f) 1)");
+    ExpectNoError("(define (g) (f))");
+    ExpectEq("(g)", "1");
+    ExpectNoError("(define (f) 2)");
+    ExpectEq("(g)", "2");
+    ExpectNoError("(set! f (lambda () 3))");
+    ExpectEq("(g)", "3");
+
+    ExpectNoError("(define (h x) (+ x 1))");
+    ExpectEq("(h 1)", "2");
+    ExpectNoError("(define + *)");
+    ExpectEq("(h 5)", "5");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LambdasAsArguments") {
+    ExpectEq("(parallel-map (lambda (x) (* x x)) '(1 2 3))", "(1 4 9)");
+    ExpectEq("(parallel-reduce (lambda (a b) (+ a b)) 0 '(1 2 3))", "6");
+}
+
+TEST_CASE_METHOD(SchemeTest, "TailCallsRunInConstantStack") {
+    ExpectNoError("(define (loop n acc) (if (= n 0) acc (loop (- n 1) (+ acc 1))))");
+    ExpectEq("(loop 100000 0)", "100000");
+
+    ExpectNoError("(define (even? n) (if (= n 0) #t (odd? (- n 1))))");
+    ExpectNoError("(define (odd? n) (if (= n 0) #f (even? (- n 1))))");
+    ExpectEq("(even? 100001)", "#f");
+
+    ExpectNoError("(define (count n) (let ((m (- n 1))) (if (< m 0) 'done (count m))))");
+    ExpectEq("(count 100000)", "done");
+}
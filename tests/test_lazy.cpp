@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <scheme/binary.h>
+#include <scheme/error.h>
+#include <scheme/lazy.h>
+#include <scheme/parser.h>
+#include <scheme/scheme.h>
+
+namespace {
+std::string WriteFile(const std::string& name, const std::string& contents) {
+    std::string path = std::filesystem::temp_directory_path() / name;
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path;
+}
+
+std::string Binary(const std::string& text) {
+    std::stringstream ss{text};
+    Tokenizer tokenizer{&ss};
+    std::string data;
+    WriteBinary(Read(&tokenizer), &data);
+    return data;
+}
+
+std::string LargeList(int size) {
+    std::string text = "(";
+    for (int i = 0; i < size; ++i) {
+        text += "(" + std::to_string(i) + " key" + std::to_string(i % 10) + " (a b)) ";
+    }
+    return text + ")";
+}
+}  // namespace
+
+TEST_CASE("LazyDataReadsLikeParsedData") {
+    for (std::string text : {"(1 (2 3) . 4)", "( a 'b '(c d) () (()) . (5) )", "-5", "sym", "()",
+                             "((1 . 2) (3 . (4 5)))", "(\"(\" \"a \\\" ) b\" . \"\")"}) {
+        std::stringstream ss{text};
+        Tokenizer tokenizer{&ss};
+        std::string expected = Object::ToString(Read(&tokenizer));
+
+        REQUIRE(Object::ToString(LoadData(WriteFile("scheme_lazy.scm", text))) == expected);
+        REQUIRE(Object::ToString(LoadData(WriteFile("scheme_lazy.bin", Binary(text)))) == expected);
+    }
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "scheme_lazy.scm");
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "scheme_lazy.bin");
+}
+
+TEST_CASE("LazyDataRejectsUnbalancedFiles") {
+    for (std::string text : {"(1 2", "1 2)", "(1 . 2 3)", "(. 1)", "", "1 2"}) {
+        std::string path = WriteFile("scheme_lazy_bad.scm", text);
+        REQUIRE_THROWS_AS(Object::ToString(LoadData(path)), SyntaxError);
+    }
+    std::string data = Binary("(1 2 (3 4))");
+    REQUIRE_THROWS_AS(LoadData(WriteFile("scheme_lazy_bad.scm", data.substr(0, data.size() - 1))),
+                      SyntaxError);
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "scheme_lazy_bad.scm");
+    REQUIRE_THROWS_AS(LoadData("/nonexistent/data"), RuntimeError);
+}
+
+TEST_CASE("LazyDataParsesOnlyWhatIsAccessed") {
+    std::string text = WriteFile("scheme_lazy_large.scm", LargeList(100000));
+    std::string binary = WriteFile("scheme_lazy_large.bin", Binary(LargeList(100000)));
+    for (const std::string& path : {text, binary}) {
+        Interpreter interpreter;
+        interpreter.GetGlobalScope()->Define("data", LoadData(path));
+        // Parsing everything would take megabytes.
+        interpreter.SetLimits({.heap = 1 << 14});
+        REQUIRE(interpreter.Run("(car (cdr (cdr data)))") == "(2 key2 (a b))");
+        REQUIRE(interpreter.Run("(car (cdr (car (cdr data))))") == "key1");
+        REQUIRE_THROWS_AS(interpreter.Run("(list-ref data 99999)"), LimitError);
+
+        interpreter.SetLimits({});
+        REQUIRE(interpreter.Run("(list-ref data 99999)") == "(99999 key9 (a b))");
+    }
+    std::filesystem::remove(text);
+    std::filesystem::remove(binary);
+}
+
+TEST_CASE("LoadDataBuiltin") {
+    std::string path = WriteFile("scheme-lazy-builtin", "((1 2) (3 4))");
+    Interpreter interpreter;
+    interpreter.Run("(define data (load-data '" + path + "))");
+    REQUIRE(interpreter.Run("(car (cdr data))") == "(3 4)");
+    REQUIRE_THROWS_AS(interpreter.Run("(load-data 1)"), RuntimeError);
+    std::filesystem::remove(path);
+}
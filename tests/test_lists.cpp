@@ -0,0 +1,86 @@
+#include "scheme_test.h"
+
+namespace {
+class ListsTest : public SchemeTest {
+public:
+    ListsTest() {
+        // (range n) is (1 2 ... n), built by a loop.
+        ExpectNoError(
+            "(define (range-from n acc) (if (= n 0) acc (range-from (- n 1) (cons n acc))))");
+        ExpectNoError("(define (range n) (range-from n '()))");
+    }
+};
+}  // namespace
+
+TEST_CASE_METHOD(ListsTest, "LengthAppendReverse") {
+    ExpectEq("(length '())", "0");
+    ExpectEq("(length '(1 (2 3) 4))", "3");
+    ExpectRuntimeError("(length '(1 2 . 3))");
+    ExpectRuntimeError("(length 1)");
+
+    ExpectEq("(append)", "()");
+    ExpectEq("(append '(1 2) '() '(3) '(4 5))", "(1 2 3 4 5)");
+    ExpectEq("(append '(1) 2)", "(1 . 2)");
+    ExpectEq("(append '() '())", "()");
+    ExpectRuntimeError("(append 1 '(2))");
+
+    ExpectEq("(reverse '())", "()");
+    ExpectEq("(reverse '(1 (2 3) 4))", "(4 (2 3) 1)");
+    ExpectRuntimeError("(reverse '(1 . 2))");
+
+    ExpectEq("(list-copy '(1 2 3))", "(1 2 3)");
+    ExpectEq("(list-copy '(1 2 . 3))", "(1 2 . 3)");
+}
+
+TEST_CASE_METHOD(ListsTest, "HigherOrder") {
+    ExpectEq("(map (lambda (x) (* x x)) '(1 2 3))", "(1 4 9)");
+    ExpectEq("(map + '(1 2 3) '(10 20))", "(11 22)");
+    ExpectEq("(map abs '())", "()");
+    ExpectRuntimeError("(map abs)");
+    ExpectRuntimeError("(map 1 '(1))");
+
+    ExpectNoError("(define sum 0)");
+    ExpectEq("(for-each (lambda (x y) (set! sum (+ sum (* x y)))) '(1 2 3) '(4 5 6))", "()");
+    ExpectEq("sum", "32");
+
+    ExpectEq("(filter (lambda (x) (> x 2)) '(1 5 2 4))", "(5 4)");
+    ExpectEq("(filter (lambda (x) 0) '(1 2))", "(1 2)");
+
+    ExpectEq("(fold-left - 0 '(1 2 3))", "-6");
+    ExpectEq("(fold-right - 0 '(1 2 3))", "2");
+    ExpectEq("(fold-left cons '() '(1 2))", "((() . 1) . 2)");
+    ExpectEq("(fold-right cons '() '(1 2))", "(1 2)");
+    ExpectEq("(fold-left (lambda (acc x y) (+ acc (* x y))) 0 '(1 2 3) '(4 5))", "14");
+    ExpectEq("(fold-right list 0 '(1 2) '(3 4))", "(1 3 (2 4 0))");
+    ExpectEq("(fold-right + 7 '())", "7");
+}
+
+TEST_CASE_METHOD(ListsTest, "Search") {
+    ExpectEq("(assoc '(1) '((a 1) ((1) 2)))", "((1) 2)");
+    ExpectEq("(assoc 3 '((1 . 2)))", "#f");
+    ExpectEq("(assq 'b '((a 1) (b 2)))", "(b 2)");
+    ExpectEq("(assq 'c '((a 1) (b 2)))", "#f");
+    ExpectRuntimeError("(assq 'b '(a b))");
+
+    ExpectEq("(member 2 '(1 2 3))", "(2 3)");
+    ExpectEq("(member '(a) '(b (a) c))", "((a) c)");
+    ExpectEq("(member 4 '(1 2 3))", "#f");
+
+    ExpectEq("(list-ref '(1 2 3) 2)", "3");
+    ExpectEq("(list-tail '(1 2 3) 2)", "(3)");
+    ExpectEq("(list-tail '(1 2 . 3) 2)", "3");
+}
+
+TEST_CASE_METHOD(ListsTest, "LongListsDoNotGrowTheStack") {
+    ExpectNoError("(define l (range 1000000))");
+    ExpectEq("(length l)", "1000000");
+    ExpectEq("(list-ref (reverse l) 0)", "1000000");
+    ExpectEq("(length (append l l))", "2000000");
+    ExpectEq("(list-ref (map (lambda (x) (+ x 1)) l) 999999)", "1000001");
+    ExpectEq("(length (filter (lambda (x) (< x 10)) l))", "9");
+    ExpectEq("(fold-left + 0 l)", "1784293664");
+    ExpectEq("(fold-right (lambda (x acc) (+ acc 1)) 0 l)", "1000000");
+    ExpectEq("(car (member 999999 l))", "999999");
+    ExpectEq("(length (list-copy l))", "1000000");
+    ExpectEq("(list-tail l 1000000)", "()");
+}
@@ -0,0 +1,238 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+
+#include <scheme/binary.h>
+#include <scheme/error.h>
+#include <scheme/optimizer.h>
+#include <scheme/parser.h>
+
+#include "scheme_test.h"
+
+namespace {
+Ptr<Object> ReadAll(const std::string& str) {
+    std::stringstream ss{str};
+    Tokenizer tokenizer{&ss};
+    return Read(&tokenizer);
+}
+
+class OptimizerTest {
+public:
+    OptimizerTest() : env_(std::make_shared<Environemnt>()) {
+        env_->FullfillR5RS();
+    }
+
+    Ptr<Object> Optimized(const std::string& expression) {
+        return Optimize(ReadAll(expression), env_);
+    }
+
+    std::string Eval(const Ptr<Object>& ast) {
+        return Object::ToString(Object::Eval(ast, env_));
+    }
+
+protected:
+    Ptr<Environemnt> env_;
+};
+}  // namespace
+
+TEST_CASE_METHOD(OptimizerTest, "FoldsConstantArithmetic") {
+    auto ast = Optimized("(+ 1 2 (* 3 4))");
+    REQUIRE(Is<Constant>(ast));
+    REQUIRE(ast->ToString() == "(+ 1 2 (* 3 4))");
+    REQUIRE(Eval(ast) == "15");
+
+    REQUIRE(Is<Constant>(Optimized("(not #t)")));
+    REQUIRE(Is<Constant>(Optimized("(< 1 2)")));
+    REQUIRE(Is<Symbol>(Optimized("x")));
+    REQUIRE(Is<Number>(Optimized("1")));
+}
+
+TEST_CASE_METHOD(OptimizerTest, "KeepsCallsOfImpureBuiltins") {
+    InstallBinary(env_.get());
+    for (const char* name : {"car", "parallel-map", "parallel-reduce", "write-binary"}) {
+        INFO(name);
+        REQUIRE_FALSE(As<Callable>((*env_)[name])->IsPure());
+    }
+    REQUIRE(Is<Cell>(Optimized("(car '(1 2))")));
+    REQUIRE(Is<Cell>(Optimized("(parallel-reduce + 0 '(1 2 3))")));
+    REQUIRE(Eval(Optimized("(parallel-reduce + 0 '(1 2 3))")) == "6");
+}
+
+TEST_CASE_METHOD(OptimizerTest, "FoldsArgumentsOfNonConstantCalls") {
+    auto ast = Optimized("(+ x (* 2 3))");
+    REQUIRE(Is<Cell>(ast));
+    auto args = As<Cell>(As<Cell>(ast)->GetSecond());
+    REQUIRE(Is<Symbol>(args->GetFirst()));
+    REQUIRE(Is<Constant>(As<Cell>(args->GetSecond())->GetFirst()));
+
+    env_->Define("x", std::make_shared<Number>(1));
+    REQUIRE(Eval(ast) == "7");
+}
+
+TEST_CASE_METHOD(OptimizerTest, "HoistsQuote") {
+    auto ast = Optimized("'(1 2)");
+    REQUIRE(Is<Constant>(ast));
+    REQUIRE(Eval(ast) == "(1 2)");
+    REQUIRE(Object::Eval(ast, env_) == Object::Eval(ast, env_));
+
+    REQUIRE(Is<Cell>(Optimized("(list-tail '(1 2 3) 1)")));
+    REQUIRE(Eval(Optimized("(list-tail '(1 2 3) 1)")) == "(2 3)");
+}
+
+TEST_CASE_METHOD(OptimizerTest, "RespectsRebinding") {
+    auto ast = Optimized("(+ 1 2)");
+    REQUIRE(Eval(ast) == "3");
+
+    env_->Define("+", (*env_)["*"]);
+    REQUIRE(Eval(ast) == "2");
+
+    env_->Define("+", (*env_)["list"]);
+    REQUIRE(Eval(ast) == "(1 2)");
+
+    env_->Define("+", std::make_shared<Number>(1));
+    REQUIRE_THROWS_AS(Eval(ast), RuntimeError);
+}
+
+TEST_CASE_METHOD(OptimizerTest, "FoldsExpressionArgumentsOfSyntax") {
+    auto ast = Optimized("(and #f (+ 1 2))");
+    REQUIRE(Is<Cell>(ast));
+    REQUIRE(Is<Constant>(As<Cell>(As<Cell>(As<Cell>(ast)->GetSecond())->GetSecond())->GetFirst()));
+
+    ast = Optimized("(if (< 1 2) x (* 2 3))");
+    auto args = As<Cell>(As<Cell>(ast)->GetSecond());
+    REQUIRE(Is<Constant>(args->GetFirst()));
+    REQUIRE(Is<Symbol>(As<Cell>(args->GetSecond())->GetFirst()));
+}
+
+TEST_CASE_METHOD(OptimizerTest, "LeavesSyntaxAndErrorsAlone") {
+    auto ast = Optimized("(lambda (x) (+ 1 2))");
+    REQUIRE(Is<Cell>(As<Cell>(As<Cell>(As<Cell>(ast)->GetSecond())->GetSecond())->GetFirst()));
+
+    REQUIRE(Is<Cell>(Optimized("(car '())")));
+    REQUIRE(Is<Cell>(Optimized("(/ 1 0)")));
+    REQUIRE(Is<Cell>(Optimized("(number? (yield))")));
+}
+
+TEST_CASE_METHOD(SchemeTest, "ConstantFoldingKeepsSemantics") {
+    ExpectEq("(+ 1 2 (* 3 4))", "15");
+    ExpectEq("(list (+ 1 2) '(3))", "(3 (3))");
+    ExpectRuntimeError("(+ 1 #t)");
+    ExpectRuntimeError("(/ 1 0)");
+    ExpectRuntimeError("(/ 10 (- 2 2))");
+}
+
+TEST_CASE_METHOD(OptimizerTest, "AccessesListsBuiltInPlace") {
+    env_->Define("x", std::make_shared<Number>(5));
+    auto ast = Optimized("(car (cdr (list 1 x 3)))");
+    REQUIRE(Is<Rewritten>(ast));
+    REQUIRE(ast->ToString() == "(car (cdr (list 1 x 3)))");
+    REQUIRE(Eval(ast) == "5");
+
+    REQUIRE(Eval(Optimized("(cdr (cons x (list 2 3)))")) == "(2 3)");
+    REQUIRE(Eval(Optimized("(cdr (cons 1 x))")) == "5");
+    REQUIRE(Eval(Optimized("(null? (cdr (list x)))")) == "#t");
+    REQUIRE(Eval(Optimized("(pair? (cdr (cons 1 x)))")) == "#f");
+    REQUIRE_THROWS_AS(Eval(Optimized("(car (cons x (car '())))")), RuntimeError);
+
+    REQUIRE(Is<Cell>(Optimized("(car (cdr (cons 1 x)))")));
+    REQUIRE(Is<Cell>(Optimized("(car (list))")));
+}
+
+TEST_CASE_METHOD(OptimizerTest, "FusesListPipelines") {
+    env_->Define("xs", ReadAll("(1 -2 3 -4 5 -6)"));
+    std::string pipeline = "(fold-left + 0 (map abs (filter number? xs)))";
+    auto ast = Optimized(pipeline);
+    REQUIRE(Is<Rewritten>(ast));
+    REQUIRE(ast->ToString() == pipeline);
+    REQUIRE(Eval(ast) == "21");
+
+    REQUIRE(Eval(Optimized("(map abs (map abs (filter number? xs)))")) == "(1 2 3 4 5 6)");
+    REQUIRE(Eval(Optimized("(filter number? (map abs xs))")) == "(1 2 3 4 5 6)");
+    REQUIRE(Eval(Optimized("(fold-right max 0 (map abs xs))")) == "6");
+    REQUIRE(Eval(Optimized("(length (filter number? xs))")) == "6");
+    REQUIRE(Eval(Optimized("(length (map abs '()))")) == "0");
+    // Errors are the ones of the unfused calls.
+    REQUIRE_THROWS_WITH(Eval(Optimized("(length (map abs '(1 . 2)))")), "map needs proper lists");
+    REQUIRE_THROWS_AS(Eval(Optimized("(length (map abs '(1 #t)))")), RuntimeError);
+
+    REQUIRE(Is<Rewritten>(Optimized("(map abs (filter number? xs))")));
+    REQUIRE(Is<Rewritten>(Optimized("(for-each abs (map - xs))")));
+    REQUIRE(Is<Cell>(Optimized("(map abs xs)")));
+    REQUIRE(Is<Cell>(Optimized("(fold-left + 0 xs)")));
+    REQUIRE(Is<Cell>(Optimized("(length (map + xs xs))")));
+}
+
+TEST_CASE_METHOD(OptimizerTest, "FusesOnlyPureBuiltins") {
+    env_->Define("xs", ReadAll("(1 -2 3)"));
+    env_->Define("negate", Object::Eval(Optimized("(lambda (x) (- 0 x))"), env_));
+    REQUIRE(Is<Cell>(Optimized("(map abs (map negate xs))")));
+    REQUIRE(Is<Cell>(Optimized("(map (lambda (x) x) (map abs xs))")));
+    REQUIRE(Is<Cell>(Optimized("(fold-left (lambda (acc x) x) 0 (map abs xs))")));
+    REQUIRE(Is<Cell>(Optimized("(fold-right cons '() (map abs xs))")));
+    REQUIRE(Is<Cell>(Optimized("(for-each display (map abs xs))")));
+    REQUIRE(Eval(Optimized("(map abs (map negate xs))")) == "(1 2 3)");
+
+    auto ast = Optimized("(map abs (filter number? xs))");
+    REQUIRE(Is<Rewritten>(ast));
+    env_->Define("abs", Object::Eval(Optimized("(lambda (x) x)"), env_));
+    REQUIRE(Eval(ast) == "(1 -2 3)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "UnfusedPipelinesCallProceduresStageByStage") {
+    ExpectNoError("(define calls '())");
+    ExpectNoError("(define (trace tag x) (set! calls (cons (list tag x) calls)) x)");
+    ExpectEq("(for-each (lambda (x) (trace 'out x)) (map (lambda (x) (trace 'in x)) '(1 2)))",
+             "()");
+    ExpectEq("calls", "((out 2) (out 1) (in 2) (in 1))");
+    ExpectRuntimeError("(map (lambda (x) (trace 'out x)) (map car '((1) 2)))");
+    ExpectEq("calls", "((out 2) (out 1) (in 2) (in 1))");
+
+    ExpectEq("(fold-left + 0 (map abs (filter number? '(1 -2 #t -3))))", "6");
+    ExpectNoError("(define map (lambda (f xs) '(10)))");
+    ExpectEq("(fold-left + 0 (map abs (filter number? '(1 -2 #t -3))))", "10");
+}
+
+TEST_CASE_METHOD(SchemeTest, "TransducersCallProceduresElementByElement") {
+    ExpectNoError("(define calls '())");
+    ExpectNoError("(define (trace tag x) (set! calls (cons (list tag x) calls)) x)");
+    ExpectEq("(list-transduce (tmap (lambda (x) (trace 'in x))) (lambda (acc x) (trace 'out x)) 0 "
+             "'(1 2))",
+             "2");
+    ExpectEq("calls", "((out 2) (in 2) (out 1) (in 1))");
+
+    ExpectNoError("(define stages (list (tfilter (lambda (x) (> x 2))) (tmap (lambda (x) (* x x)))))");
+    ExpectEq("(list-transduce stages + 0 '(1 2 3 4 5))", "50");
+    ExpectEq("(list-transduce (tmap abs) cons '() '(-1 2))", "((() . 1) . 2)");
+    ExpectEq("(list-transduce '() + 0 '(1 2 3))", "6");
+    ExpectEq("(list-transduce (tfilter number?) + 0 '())", "0");
+    ExpectRuntimeError("(list-transduce (list 1) + 0 '(1 2))");
+    ExpectRuntimeError("(list-transduce (tmap abs) + 0 '(1 . 2))");
+    ExpectRuntimeError("(tmap 1)");
+    ExpectRuntimeError("(tfilter number? 1)");
+}
+
+TEST_CASE_METHOD(OptimizerTest, "RewritesAccessesAfterRebinding") {
+    auto ast = Optimized("(car (list x 2))");
+    env_->Define("x", std::make_shared<Number>(1));
+    REQUIRE(Eval(ast) == "1");
+
+    env_->Define("list", (*env_)["cons"]);
+    REQUIRE(Eval(ast) == "1");
+    env_->Define("car", (*env_)["cdr"]);
+    REQUIRE(Eval(ast) == "2");
+}
+
+TEST_CASE_METHOD(SchemeTest, "AppliesLambdasInPlace") {
+    ExpectEq("((lambda (x y) (+ x y)) 1 2)", "3");
+    ExpectEq("((lambda args args) 1 2)", "(1 2)");
+    ExpectRuntimeError("((lambda (x) x) 1 2)");
+
+    ExpectNoError("(define y 10)");
+    ExpectNoError("(define (f x) ((lambda (z) (+ x y z)) 1))");
+    ExpectEq("(f 2)", "13");
+    ExpectNoError("(define (g let) ((lambda (x) (let x)) 5))");
+    ExpectEq("(g list)", "(5)");
+
+    ExpectNoError("(define (loop n) ((lambda (m) (if (= m 0) 'done (loop m))) (- n 1)))");
+    ExpectEq("(loop 100000)", "done");
+}
@@ -0,0 +1,118 @@
+#include "scheme_test.h"
+
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace {
+std::string QuotedRange(int from, int to) {
+    std::string res = "'(";
+    for (int i = from; i < to; ++i) {
+        res += std::to_string(i);
+        res += ' ';
+    }
+    res += ')';
+    return res;
+}
+
+// Lets parallel builtins use threads, however many cores there are.
+class ParallelismGuard {
+public:
+    explicit ParallelismGuard(size_t threads) : previous_(GetParallelism()) {
+        SetParallelism(threads);
+    }
+    ~ParallelismGuard() {
+        SetParallelism(previous_);
+    }
+
+private:
+    size_t previous_;
+};
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "ParallelMap") {
+    ExpectEq("(parallel-map abs '())", "()");
+    ExpectEq("(parallel-map abs '(1 -2 3))", "(1 2 3)");
+    ExpectEq("(parallel-map number? '(1 #t))", "(#t #f)");
+
+    ExpectRuntimeError("(parallel-map abs '(1 #t))");
+    ExpectRuntimeError("(parallel-map abs '(1 . 2))");
+    ExpectRuntimeError("(parallel-map 1 '(1 2))");
+    ExpectRuntimeError("(parallel-map quote '(1 2))");
+    ExpectRuntimeError("(parallel-map abs)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelMapKeepsOrderOnLargeLists") {
+    ExpectEq("(parallel-reduce + 0 (parallel-map abs " + QuotedRange(-50000, 0) + "))",
+             "1250025000");
+    ExpectEq("(car (parallel-map abs " + QuotedRange(-20000, 0) + "))", "20000");
+    ExpectEq("(list-ref (parallel-map abs " + QuotedRange(-20000, 0) + ") 19999)", "1");
+    ExpectRuntimeError("(parallel-map abs (cons #t " + QuotedRange(0, 20000) + "))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelForEach") {
+    ExpectEq("(parallel-for-each abs '(1 2 3))", "()");
+    ExpectRuntimeError("(parallel-for-each abs '(1 #f))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelReduce") {
+    ExpectEq("(parallel-reduce + 0 '())", "0");
+    ExpectEq("(parallel-reduce + 10 '(1 2 3))", "16");
+    ExpectEq("(parallel-reduce max 0 " + QuotedRange(0, 30000) + ")", "29999");
+
+    ExpectRuntimeError("(parallel-reduce + 0)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "PureProcedures") {
+    ExpectNoError("(define square (pure (lambda (x) (* x x))))");
+    ExpectEq("(square 3)", "9");
+    ExpectEq("(parallel-map square '(1 2 3))", "(1 4 9)");
+    ExpectEq("(parallel-reduce (pure (lambda (a b) (+ a b))) 10 '(1 2 3))", "16");
+    ExpectEq("(fold-left + 0 (map square (filter number? '(1 #t 2))))", "5");
+
+    ExpectRuntimeError("(square #t)");
+    ExpectRuntimeError("(pure 1)");
+    ExpectRuntimeError("(pure if)");
+    ExpectRuntimeError("(pure)");
+}
+
+TEST_CASE("PureProceduresRunOnSeveralThreads") {
+    ParallelismGuard parallelism(4);
+    Interpreter interpreter;
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    interpreter.GetGlobalScope()->Define(
+        "note-thread",
+        std::make_shared<Procedure<Object>>([&](const std::vector<Ptr<Object>>& args) {
+            std::lock_guard lock(mutex);
+            threads.insert(std::this_thread::get_id());
+            return args[0];
+        }, true));
+    // Never called before: the threads share a body which is neither optimized nor cached yet.
+    interpreter.Run("(define (twice x) (let ((y (+ x x))) (note-thread y)))");
+    std::string range = QuotedRange(0, 10000);
+    REQUIRE(interpreter.Run("(parallel-reduce + 0 (parallel-map (pure twice) " + range + "))") ==
+            "99990000");
+    REQUIRE(threads.size() > 1);
+
+    threads.clear();
+    REQUIRE(interpreter.Run("(parallel-reduce (pure (lambda (a b) (note-thread (max a b)))) 0 " +
+                            range + ")") == "9999");
+    REQUIRE(threads.size() > 1);
+    REQUIRE(interpreter.Run("(twice 5)") == "10");
+
+    REQUIRE_THROWS_AS(interpreter.Run("(parallel-map (pure car) (cons '(1) " + range + "))"),
+                      RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Run("(parallel-map (pure twice) (cons #t " + range + "))"),
+                      RuntimeError);
+}
+
+TEST_CASE("PureProceduresRunUnderTheDeadline") {
+    ParallelismGuard parallelism(4);
+    Interpreter interpreter;
+    interpreter.Run("(define (spin x) (spin x))");
+    interpreter.SetLimits({.time = std::chrono::milliseconds(200)});
+    REQUIRE_THROWS_AS(interpreter.Run("(parallel-map (pure spin) " + QuotedRange(0, 10000) + ")"),
+                      LimitError);
+}
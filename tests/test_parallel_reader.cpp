@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <scheme/error.h>
+#include <scheme/parser.h>
+#include <scheme/scheme.h>
+
+namespace {
+// A datum with strings holding brackets and quotes, quotes followed by blanks, and blanks of
+// every kind between the parts.
+std::string RandomDatum(std::mt19937* random, int depth) {
+    static const char* kAtoms[] = {"1", "-20", "abc", "#t", "\"s(\"", "\"a \\\"b) \"", "+", "x"};
+    static const char* kBlanks[] = {" ", "\n", "\t ", "  \n "};
+    std::string res;
+    switch ((*random)() % (depth > 4 ? 2 : 5)) {
+        case 0:
+        case 1:
+            return kAtoms[(*random)() % std::size(kAtoms)];
+        case 2:
+            return "'" + std::string(kBlanks[(*random)() % std::size(kBlanks)]) +
+                   RandomDatum(random, depth + 1);
+        case 3:
+            return "(" + RandomDatum(random, depth + 1) + " . " + RandomDatum(random, depth + 1) +
+                   ")";
+        default:
+            res = "(";
+            for (size_t i = (*random)() % 6; i > 0; --i) {
+                res += RandomDatum(random, depth + 1);
+                res += kBlanks[(*random)() % std::size(kBlanks)];
+            }
+            return res + ")";
+    }
+}
+
+std::vector<std::string> ReadSequentially(const std::string& text) {
+    std::stringstream ss{text};
+    Tokenizer tokenizer{&ss};
+    std::vector<std::string> res;
+    while (!tokenizer.IsEnd()) {
+        res.push_back(Object::ToString(Read(&tokenizer)));
+    }
+    return res;
+}
+
+std::vector<std::string> Printed(const std::vector<Ptr<Object>>& data) {
+    std::vector<std::string> res;
+    for (const auto& datum : data) {
+        res.push_back(Object::ToString(datum));
+    }
+    return res;
+}
+}  // namespace
+
+TEST_CASE("ParallelReadMatchesSequentialRead") {
+    std::mt19937 random(7);
+    std::string text;
+    while (text.size() < 8 * kMinChunkSize) {
+        text += RandomDatum(&random, 0);
+        text += random() % 2 == 0 ? " " : "\n";
+    }
+    auto expected = ReadSequentially(text);
+    for (size_t threads : {1, 3, 8}) {
+        REQUIRE(Printed(ReadParallel(text, threads)) == expected);
+    }
+
+    REQUIRE(ReadParallel("").empty());
+    std::vector<std::string> small = {"1", "(2 3)", "(quote x)"};
+    REQUIRE(Printed(ReadParallel("1 (2 3)\n'x")) == small);
+}
+
+TEST_CASE("ParallelReadStopsAtTheFirstError") {
+    std::string data;
+    while (data.size() < 4 * kMinChunkSize) {
+        data += "(1 \"2\" (3 4)) ";
+    }
+    REQUIRE_THROWS_AS(ReadParallel(data + "(1 2" + data, 4), SyntaxError);
+    REQUIRE_THROWS_AS(ReadParallel(data + ")" + data, 4), SyntaxError);
+    REQUIRE_THROWS_AS(ReadParallel(data + "\"abc", 4), SyntaxError);
+    REQUIRE_THROWS_AS(ReadParallel(data + "'", 4), SyntaxError);
+    REQUIRE_THROWS_AS(ReadParallel(data + "(3 [)" + data, 4), SyntaxError);
+    REQUIRE_THROWS_AS(ReadParallel(data + "(99999999999999)" + data, 4), SyntaxError);
+}
+
+TEST_CASE("LoadAllData") {
+    std::string path = std::filesystem::temp_directory_path() / "scheme_load_all.scm";
+    {
+        std::ofstream file(path);
+        for (int i = 0; i < 20000; ++i) {
+            file << "(" << i << " \"row " << i << "\")\n";
+        }
+    }
+    Interpreter interpreter;
+    interpreter.Run("(define rows (load-all-data \"" + path + "\"))");
+    REQUIRE(interpreter.Run("(length rows)") == "20000");
+    REQUIRE(interpreter.Run("(list-ref rows 12345)") == "(12345 \"row 12345\")");
+    REQUIRE_THROWS_AS(interpreter.Run("(load-all-data \"/nonexistent/data.scm\")"), RuntimeError);
+
+    std::ofstream(path) << "(1 2)\n(3 [)\n";
+    REQUIRE_THROWS_AS(interpreter.Run("(load-all-data \"" + path + "\")"), SyntaxError);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include <scheme/error.h>
+#include <scheme/scheme.h>
+
+TEST_CASE("ParseCacheCountsHitsAndMisses") {
+    Interpreter interpreter;
+    ParseCache& cache = interpreter.GetParseCache();
+
+    REQUIRE(interpreter.Run("(+ 1 2)") == "3");
+    REQUIRE(interpreter.Run("(+ 1 2)") == "3");
+    REQUIRE(interpreter.Run("(+ 1 2)") == "3");
+    REQUIRE(cache.GetMisses() == 1);
+    REQUIRE(cache.GetHits() == 2);
+
+    REQUIRE_THROWS_AS(interpreter.Run("(+ 1"), SyntaxError);
+    REQUIRE_THROWS_AS(interpreter.Run("(+ 1"), SyntaxError);
+    REQUIRE(cache.GetSize() == 1);
+
+    std::vector<std::string_view> expressions = {"(+ 1 2)", "(* 2 3)", "(* 2 3)"};
+    std::vector<BatchResult> results;
+    interpreter.RunBatch(expressions, &results);
+    REQUIRE(results[2].value == "6");
+    REQUIRE(cache.GetHits() == 4);
+}
+
+TEST_CASE("ParseCacheEvictsLeastRecentlyUsed") {
+    Interpreter interpreter;
+    ParseCache& cache = interpreter.GetParseCache();
+    cache.SetCapacity(2);
+
+    interpreter.Run("1");
+    interpreter.Run("2");
+    interpreter.Run("1");
+    interpreter.Run("3");
+    REQUIRE(cache.GetSize() == 2);
+    size_t misses = cache.GetMisses();
+    interpreter.Run("1");
+    REQUIRE(cache.GetMisses() == misses);
+    interpreter.Run("2");
+    REQUIRE(cache.GetMisses() == misses + 1);
+
+    cache.SetCapacity(0);
+    REQUIRE(cache.GetSize() == 0);
+    REQUIRE(interpreter.Run("2") == "2");
+    REQUIRE(cache.GetSize() == 0);
+}
+
+TEST_CASE("ParseCacheKeepsSemantics") {
+    Interpreter interpreter;
+    interpreter.Run("(define x 1)");
+    REQUIRE(interpreter.Run("(+ x (car '(10 20)))") == "11");
+    interpreter.Run("(set! x 5)");
+    REQUIRE(interpreter.Run("(+ x (car '(10 20)))") == "15");
+    interpreter.Run("(define (car l) 100)");
+    REQUIRE(interpreter.Run("(+ x (car '(10 20)))") == "105");
+
+    interpreter.Run("(define (f n) (if (= n 0) 0 (+ 1 (f (- n 1)))))");
+    REQUIRE(interpreter.Run("(f 100)") == "100");
+    interpreter.Run("(define (f n) (* n 2))");
+    REQUIRE(interpreter.Run("(f 100)") == "200");
+}
+
+TEST_CASE("ParseCacheCopiesQuotedData") {
+    Interpreter interpreter;
+    interpreter.Run("(define a '(1 (2 3)))");
+    auto list = interpreter.GetGlobalScope()->Lookup("a")->value;
+    As<Cell>(list)->GetFirst() = std::make_shared<Number>(5);
+    REQUIRE(interpreter.Run("a") == "(5 (2 3))");
+
+    interpreter.Run("(define a '(1 (2 3)))");
+    REQUIRE(interpreter.Run("a") == "(1 (2 3))");
+    REQUIRE(interpreter.GetParseCache().GetHits() == 2);
+}
+
+TEST_CASE("ParseCacheRefreshesHoistedQuotedData") {
+    Interpreter interpreter;
+    Ptr<Object> kept;
+    interpreter.GetGlobalScope()->Define(
+        "keep", std::make_shared<Procedure<Object>>([&kept](const std::vector<Ptr<Object>>& args) {
+            kept = args.front();
+            return args.front();
+        }));
+
+    // No global is rebound between the runs, so the hoisted datum is not folded again.
+    REQUIRE(interpreter.Run("(keep '(1 (2 3)))") == "(1 (2 3))");
+    Ptr<Object> first = kept;
+    As<Cell>(first)->GetFirst() = std::make_shared<Number>(5);
+    REQUIRE(interpreter.Run("(keep '(1 (2 3)))") == "(1 (2 3))");
+    REQUIRE(kept != first);
+    REQUIRE(interpreter.GetParseCache().GetHits() == 1);
+}
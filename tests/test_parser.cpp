@@ -153,4 +153,31 @@ TEST_CASE("Invalid") {
     REQUIRE_THROWS_AS(ReadFull("(1 . ()"), SyntaxError);
     REQUIRE_THROWS_AS(ReadFull("(1 . )"), SyntaxError);
     REQUIRE_THROWS_AS(ReadFull("(1 . 2 3)"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("["), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("(1 ["), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("(1 $ 2)"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("(1 99999999999)"), SyntaxError);
+}
+
+TEST_CASE("Read without throwing") {
+    std::stringstream ss{"(1 . 2) '(a b) (1 . 2 3) ) (1"};
+    Tokenizer tokenizer{&ss};
+
+    auto pair = TryRead(&tokenizer);
+    REQUIRE(pair.IsOk());
+    REQUIRE(Is<Cell>(pair.GetValue()));
+    auto quote = TryRead(&tokenizer);
+    REQUIRE(quote.IsOk());
+    REQUIRE(Object::ToString(quote.GetValue()) == "(quote (a b))");
+
+    auto error = TryRead(&tokenizer);
+    REQUIRE_FALSE(error.IsOk());
+    REQUIRE(error.GetError().kind == Error::Kind::SYNTAX);
+    REQUIRE_THROWS_AS(std::move(error).ValueOrThrow(), SyntaxError);
+
+    while (!tokenizer.IsEnd() && tokenizer.GetToken() != Token{BracketToken::CLOSE}) {
+        tokenizer.Next();
+    }
+    REQUIRE_FALSE(TryRead(&tokenizer).IsOk());
+    REQUIRE_FALSE(TryRead(&tokenizer).IsOk());
 }
@@ -0,0 +1,48 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <scheme/object.h>
+#include <scheme/scheme.h>
+
+TEST_CASE("SharesSmallNumbersAndBooleans") {
+    REQUIRE(MakeNumber(5) == MakeNumber(5));
+    REQUIRE(MakeNumber(kMinSharedNumber) == MakeNumber(kMinSharedNumber));
+    REQUIRE(MakeNumber(kMaxSharedNumber + 1) != MakeNumber(kMaxSharedNumber + 1));
+    REQUIRE(MakeNumber(-100000)->GetValue() == -100000);
+    REQUIRE(MakeBoolean(true) == MakeBoolean(true));
+    REQUIRE_FALSE(MakeBoolean(false)->var_);
+}
+
+TEST_CASE("PairsAreNotPadded") {
+    REQUIRE(BlockPool<72, 8>::kBlockSize == 72);
+    REQUIRE(BlockPool<72>::kBlockSize == 80);
+    REQUIRE(BlockPool<4, 4>::kBlockSize == sizeof(void*));
+    // The object header and the two slots; the call site cache lives in FormCell.
+    REQUIRE(sizeof(Cell) == sizeof(Object) + 2 * sizeof(Ptr<Object>));
+}
+
+TEST_CASE("PairsMoveBetweenThreads") {
+    // Pairs made on one thread and freed on another go back to the pool of the other.
+    std::vector<Ptr<Object>> lists(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        threads.emplace_back([&lists, i] {
+            Ptr<Object> list = nullptr;
+            for (int j = 0; j < 100000; ++j) {
+                list = MakeCell(MakeNumber(j), list);
+            }
+            lists[i] = list;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(As<Number>(As<Cell>(lists[2])->GetFirst())->GetValue() == 99999);
+    lists.clear();
+
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(parallel-reduce + 0 (parallel-map abs '(-1 2 -3 4)))") == "10");
+    REQUIRE(interpreter.Run("(cdr (cons 1 (list 2 3)))") == "(2 3)");
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch.hpp>
+
+#include <scheme/object.h>
+#include <scheme/reclaimer.h>
+#include <scheme/scheme.h>
+
+namespace {
+Ptr<Object> LongList(int size) {
+    Ptr<Object> list = nullptr;
+    for (int i = 0; i < size; ++i) {
+        list = MakeCell(MakeNumber(i), list);
+    }
+    return list;
+}
+
+// Budgets are per thread: keeps the tests after this one unlimited.
+struct BudgetGuard {
+    explicit BudgetGuard(size_t budget) {
+        Reclaimer::SetBudget(budget);
+    }
+    ~BudgetGuard() {
+        Reclaimer::SetBudget(0);
+        Reclaimer::Collect();
+    }
+};
+}  // namespace
+
+TEST_CASE("DeeplyNestedListsAreFreed") {
+    Ptr<Object> nested = nullptr;
+    for (int i = 0; i < 1000000; ++i) {
+        nested = MakeCell(nested, MakeCell(MakeNumber(i), nullptr));
+    }
+    nested = nullptr;
+    REQUIRE(Reclaimer::GetPending() == 0);
+
+    Ptr<Object> list = LongList(1000000);
+    list = nullptr;
+    REQUIRE(Reclaimer::GetPending() == 0);
+}
+
+TEST_CASE("ReleaseBudgetBoundsPauses") {
+    BudgetGuard guard(100);
+    Ptr<Object> list = LongList(10000);
+    Ptr<Object> shared = As<Cell>(list)->GetSecond();
+    for (int i = 0; i < 5000; ++i) {
+        shared = As<Cell>(shared)->GetSecond();
+    }
+    std::weak_ptr<Object> first = list;
+    Ptr<Object> cur = list;
+    for (int i = 0; i < 110; ++i) {
+        cur = As<Cell>(cur)->GetSecond();
+    }
+    std::weak_ptr<Object> later = cur;
+    cur = nullptr;
+
+    // 100 pairs at once, then two per pair allocated.
+    list = nullptr;
+    REQUIRE(first.expired());
+    REQUIRE_FALSE(later.expired());
+    REQUIRE(Reclaimer::GetPending() != 0);
+    LongList(10);
+    REQUIRE(later.expired());
+
+    REQUIRE(Reclaimer::Collect(10) == Reclaimer::GetPending());
+    REQUIRE(Reclaimer::Collect() == 0);
+    // Pairs referenced elsewhere are left alone.
+    REQUIRE(Object::ToString(As<Cell>(shared)->GetFirst()) == "4998");
+
+    Interpreter interpreter;
+    interpreter.Run("(define (range n acc) (if (= n 0) acc (range (- n 1) (cons n acc))))");
+    interpreter.Run("(define xs (range 100000 '()))");
+    interpreter.Run("(define xs 0)");
+    REQUIRE(Reclaimer::GetPending() != 0);
+    REQUIRE(interpreter.Run("(length (range 10 '()))") == "10");
+}
@@ -0,0 +1,37 @@
+#include <catch2/catch.hpp>
+
+#include <scheme/error.h>
+#include <scheme/runtime.h>
+
+#include <vector>
+
+TEST_CASE("RuntimeEvaluatesExpressions") {
+    Runtime runtime(4);
+    REQUIRE(runtime.WorkersCount() == 4);
+
+    std::vector<std::future<std::string>> results;
+    for (int i = 0; i < 1000; ++i) {
+        results.push_back(runtime.Submit("(+ " + std::to_string(i) + " 1)"));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(results[i].get() == std::to_string(i + 1));
+    }
+}
+
+TEST_CASE("RuntimePropagatesErrors") {
+    Runtime runtime(2);
+
+    auto syntax = runtime.Submit("(+ 1");
+    auto runtime_error = runtime.Submit("(car '())");
+    auto ok = runtime.Submit("'(1 2)");
+
+    REQUIRE_THROWS_AS(syntax.get(), SyntaxError);
+    REQUIRE_THROWS_AS(runtime_error.get(), RuntimeError);
+    REQUIRE(ok.get() == "(1 2)");
+}
+
+TEST_CASE("RuntimeWithSingleWorker") {
+    Runtime runtime(0);
+    REQUIRE(runtime.WorkersCount() == 1);
+    REQUIRE(runtime.Submit("(* 6 7)").get() == "42");
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <scheme/error.h>
+#include <scheme/scheme.h>
+
+namespace {
+std::string Nested(size_t depth) {
+    return std::string(depth, '(') + std::string(depth, ')');
+}
+}  // namespace
+
+TEST_CASE("SandboxLimitsSteps") {
+    Interpreter interpreter;
+    interpreter.Run("(define (loop n) (if (= n 0) 0 (loop (- n 1))))");
+    interpreter.SetLimits({.steps = 1000});
+
+    REQUIRE(interpreter.Run("(loop 10)") == "0");
+    REQUIRE_THROWS_AS(interpreter.Run("(loop 1000000)"), LimitError);
+    // The budget is per Run.
+    REQUIRE(interpreter.Run("(loop 10)") == "0");
+
+    interpreter.SetLimits({});
+    REQUIRE(interpreter.Run("(loop 100000)") == "0");
+}
+
+TEST_CASE("SandboxLimitsTime") {
+    Interpreter interpreter;
+    interpreter.Run("(define (loop) (loop))");
+    interpreter.SetLimits({.time = std::chrono::milliseconds(20)});
+    REQUIRE_THROWS_AS(interpreter.Run("(loop)"), LimitError);
+}
+
+TEST_CASE("SandboxLimitsHeap") {
+    Interpreter interpreter;
+    interpreter.Run(
+        "(define (grow n acc) (if (= n 0) (car acc) (grow (- n 1) (cons n acc))))");
+    interpreter.SetLimits({.heap = 1 << 16});
+
+    REQUIRE(interpreter.Run("(grow 10 '())") == "1");
+    REQUIRE_THROWS_AS(interpreter.Run("(grow 1000000 '())"), LimitError);
+}
+
+TEST_CASE("SandboxLimitsDepth") {
+    Interpreter interpreter;
+    interpreter.Run("(define (sum n) (if (= n 0) 0 (+ n (sum (- n 1)))))");
+    interpreter.SetLimits({.depth = 200});
+
+    REQUIRE(interpreter.Run("(sum 10)") == "55");
+    REQUIRE_THROWS_AS(interpreter.Run("(sum 100000)"), LimitError);
+    REQUIRE_THROWS_AS(interpreter.Run("'" + Nested(100000)), LimitError);
+    REQUIRE(interpreter.Run("'" + Nested(50)) == "(" + Nested(49) + ")");
+}
+
+TEST_CASE("SandboxLimitsReading") {
+    Interpreter interpreter;
+    interpreter.SetLimits({.time = std::chrono::milliseconds(100)});
+    REQUIRE_THROWS_AS(interpreter.Run("(1 ["), SyntaxError);
+
+    std::string long_list = "'(";
+    for (int i = 0; i < 100000; ++i) {
+        long_list += "1 ";
+    }
+    long_list += ")";
+    interpreter.SetLimits({.steps = 1000});
+    REQUIRE_THROWS_AS(interpreter.Run(long_list), LimitError);
+
+    std::atomic<bool> interrupt = true;
+    interpreter.SetLimits({.interrupt = &interrupt});
+    REQUIRE_THROWS_AS(interpreter.Run(long_list), LimitError);
+    interpreter.SetLimits({});
+    REQUIRE(interpreter.Run("(length " + long_list + ")") == "100000");
+}
+
+TEST_CASE("SandboxReportsLimitsInBatches") {
+    Interpreter interpreter;
+    interpreter.SetLimits({.steps = 100, .depth = 100});
+    std::vector<std::string_view> expressions = {
+        "(define (loop) (loop))", "(loop)", "(+ 1 2)", "'((((((((((((((((((((((((((("};
+    std::string deep = "'" + Nested(1000);
+    expressions.push_back(deep);
+    std::vector<BatchResult> results;
+    interpreter.RunBatch(expressions, &results);
+
+    REQUIRE(results[0].status == BatchResult::Status::OK);
+    REQUIRE(results[1].status == BatchResult::Status::LIMIT_EXCEEDED);
+    REQUIRE(results[2].value == "3");
+    REQUIRE(results[3].status == BatchResult::Status::SYNTAX_ERROR);
+    REQUIRE(results[4].status == BatchResult::Status::LIMIT_EXCEEDED);
+}
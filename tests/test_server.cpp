@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <scheme/error.h>
+#include <scheme/server.h>
+
+namespace {
+using Status = BatchResult::Status;
+
+std::string SocketPath() {
+    return "/tmp/scheme-test-" + std::to_string(getpid()) + ".sock";
+}
+}  // namespace
+
+TEST_CASE("LatencyHistogram") {
+    LatencyHistogram histogram;
+    REQUIRE(histogram.GetCount() == 0);
+    REQUIRE(histogram.GetQuantile(0.5).count() == 0);
+
+    using std::chrono::microseconds;
+    histogram.Record(std::chrono::nanoseconds(500));
+    for (int i = 0; i < 8; ++i) {
+        histogram.Record(microseconds(3));
+    }
+    histogram.Record(microseconds(1000));
+    histogram.Record(std::chrono::hours(1000));
+
+    REQUIRE(histogram.GetCount() == 11);
+    auto buckets = histogram.GetBuckets();
+    REQUIRE(buckets[0] == 1);
+    REQUIRE(buckets[2] == 8);
+    REQUIRE(buckets[10] == 1);
+    REQUIRE(buckets[LatencyHistogram::kBuckets - 1] == 1);
+    REQUIRE(histogram.GetQuantile(0).count() == 1);
+    REQUIRE(histogram.GetQuantile(0.5).count() == 4);
+    REQUIRE(histogram.GetQuantile(0.9).count() == 1024);
+    REQUIRE(histogram.ToString() == "count 11 p50<=4us p90<=1024us p99<=1024us");
+}
+
+TEST_CASE("ServerIsolatesSessions") {
+    Server server({.workers = 2, .prelude = "(define (square x) (* x x))"});
+
+    REQUIRE(server.Submit("(define x 5)", "a").get().status == Status::OK);
+    REQUIRE(server.Submit("(square x)", "a").get().value == "25");
+    REQUIRE(server.Submit("x", "b").get().status == Status::RUNTIME_ERROR);
+    REQUIRE(server.Submit("(define x 1)").get().status == Status::OK);
+    REQUIRE(server.Submit("x").get().status == Status::RUNTIME_ERROR);
+    REQUIRE(server.Submit("(square 3)").get().value == "9");
+
+    REQUIRE(server.CloseSession("a"));
+    REQUIRE_FALSE(server.CloseSession("a"));
+    REQUIRE(server.Submit("x", "a").get().status == Status::RUNTIME_ERROR);
+    REQUIRE(server.GetLatency().GetCount() == 7);
+    REQUIRE(server.GetEvaluationLatency().GetCount() == 7);
+
+    REQUIRE_THROWS_AS(Server({.prelude = "(car '())"}), RuntimeError);
+}
+
+TEST_CASE("ServerSurvivesMalformedRequests") {
+    std::string path = SocketPath();
+    Server server({.workers = 1});
+    server.Listen(path);
+
+    REQUIRE(server.Submit("12345678901234").get().status == Status::SYNTAX_ERROR);
+    REQUIRE(server.Submit("(+ 1 99999999999999)", "s").get().status == Status::SYNTAX_ERROR);
+    REQUIRE(server.Submit("(+ 1 2)", "s").get().value == "3");
+
+    ServerClient client(path);
+    REQUIRE(client.Eval("-12345678901234").status == Status::SYNTAX_ERROR);
+    REQUIRE(client.Eval("(* 6 7)").value == "42");
+}
+
+TEST_CASE("ServerAppliesLimits") {
+    Server server({.workers = 1, .limits = {.steps = 1000}});
+    auto result = server.Submit("(define (loop n) (if (= n 0) 0 (loop (- n 1))))", "s").get();
+    REQUIRE(result.status == Status::OK);
+    REQUIRE(server.Submit("(loop 10)", "s").get().value == "0");
+    REQUIRE(server.Submit("(loop 100000)", "s").get().status == Status::LIMIT_EXCEEDED);
+    REQUIRE(server.Submit("(loop 10)", "s").get().value == "0");
+}
+
+TEST_CASE("ServerStopInterruptsEvaluation") {
+    std::string path = SocketPath();
+    Server server({.workers = 1, .limits = {}});
+    server.Listen(path);
+
+    ServerClient client(path);
+    REQUIRE(client.Eval("(define (spin n) (spin (+ n 1)))", "s").status == Status::OK);
+    auto spinning = std::async(std::launch::async, [&path] {
+        ServerClient own(path);
+        return own.Eval("(spin 0)", "s");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    server.Stop();
+    REQUIRE_THROWS_AS(spinning.get(), std::system_error);
+    REQUIRE(server.Submit("(+ 1 2)", "s").get().value == "3");
+
+    // Requests after Stop run as usual, and the destructor does not wait for a runaway one.
+    REQUIRE(server.Submit("(spin 1)", "s").wait_for(std::chrono::milliseconds(50)) ==
+            std::future_status::timeout);
+}
+
+TEST_CASE("ServerOverSocket") {
+    std::string path = SocketPath();
+    Server server({.workers = 4});
+    server.Listen(path);
+
+    ServerClient client(path);
+    REQUIRE(client.Eval("(+ 1 2)").value == "3");
+    auto error = client.Eval("(car '())");
+    REQUIRE(error.status == Status::RUNTIME_ERROR);
+    REQUIRE(client.Eval("(+ 1").status == Status::SYNTAX_ERROR);
+    REQUIRE(client.Eval("(define s \"text\")", "session").status == Status::OK);
+    REQUIRE(client.Eval("(string-append s \"!\")", "session").value == "\"text!\"");
+    REQUIRE(client.CloseSession("session"));
+    REQUIRE(client.GetStats().starts_with("latency count 5 "));
+
+    // Clients on threads of their own, each in its own session.
+    std::vector<std::future<bool>> clients;
+    for (int i = 0; i < 8; ++i) {
+        clients.push_back(std::async(std::launch::async, [&path, i] {
+            ServerClient own(path);
+            std::string session = "counter" + std::to_string(i);
+            own.Eval("(define n " + std::to_string(i) + ")", session);
+            for (int j = 0; j < 50; ++j) {
+                own.Eval("(set! n (+ n 1))", session);
+            }
+            return own.Eval("n", session).value == std::to_string(i + 50);
+        }));
+    }
+    for (auto& result : clients) {
+        REQUIRE(result.get());
+    }
+
+    server.Stop();
+    REQUIRE_THROWS_AS(client.Eval("1"), std::system_error);
+    REQUIRE_THROWS_AS(ServerClient(path), std::system_error);
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+
+#include <scheme/text.h>
+
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "StringLiterals") {
+    ExpectEq("\"hello\"", "\"hello\"");
+    ExpectEq("\"\"", "\"\"");
+    ExpectEq("\"a\\\"b\\\\c\\nd\"", "\"a\\\"b\\\\c\\nd\"");
+    ExpectEq("'(\"a b\" c)", "(\"a b\" c)");
+    ExpectEq("(string? \"a\")", "#t");
+    ExpectEq("(string? 'a)", "#f");
+    ExpectSyntaxError("\"abc");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StringBuiltins") {
+    ExpectEq("(string-length \"hello\")", "5");
+    ExpectEq("(string-ref \"hello\" 1)", "\"e\"");
+    ExpectRuntimeError("(string-ref \"hello\" 5)");
+    ExpectRuntimeError("(string-ref \"\" 0)");
+    ExpectEq("(substring \"hello world\" 6)", "\"world\"");
+    ExpectEq("(substring \"hello world\" 0 5)", "\"hello\"");
+    ExpectEq("(substring \"hello\" 2 2)", "\"\"");
+    ExpectRuntimeError("(substring \"hello\" 3 2)");
+    ExpectRuntimeError("(substring \"hello\" 0 6)");
+    ExpectEq("(string-append)", "\"\"");
+    ExpectEq("(string-append \"a\" \"\" \"bc\")", "\"abc\"");
+    ExpectRuntimeError("(string-append \"a\" 'b)");
+
+    ExpectEq("(string=? \"ab\" \"ab\" \"ab\")", "#t");
+    ExpectEq("(string=? \"ab\" \"abc\")", "#f");
+    ExpectEq("(string<? \"ab\" \"abc\" \"b\")", "#t");
+    ExpectEq("(string>? \"b\" \"a\")", "#t");
+    ExpectEq("(equal? '(\"a\" 1) (list (string-append \"a\") 1))", "#t");
+    ExpectEq("(eqv? \"a\" \"a\")", "#f");
+
+    ExpectEq("(string->symbol \"abc\")", "abc");
+    ExpectEq("(symbol->string 'abc)", "\"abc\"");
+    ExpectEq("(number->string -42)", "\"-42\"");
+    ExpectEq("(string->number \"-42\")", "-42");
+    ExpectEq("(string->number \"4x\")", "#f");
+    ExpectEq("(string->number \"99999999999\")", "#f");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StringPorts") {
+    ExpectNoError("(define out (open-output-string))");
+    ExpectEq("(write-string \"count: \" out)", "()");
+    ExpectEq("(write (list 1 \"a\") out)", "()");
+    ExpectEq("(get-output-string out)", "\"count: (1 \\\"a\\\")\"");
+    ExpectRuntimeError("(read-line out)");
+
+    ExpectNoError("(define in (open-input-string \"first\\n\\nlast\"))");
+    ExpectEq("(read-line in)", "\"first\"");
+    ExpectEq("(read-line in)", "\"\"");
+    ExpectEq("(read-line in)", "\"last\"");
+    ExpectEq("(read-line in)", "#f");
+    ExpectRuntimeError("(write-string \"x\" in)");
+}
+
+TEST_CASE("StringsShareStorage") {
+    std::string text(1000, 'x');
+    text += "needle";
+    auto string = MakeString(std::move(text));
+    auto slice = string->Substring(500, 1006);
+    REQUIRE(slice->GetSize() == 506);
+    REQUIRE(slice->GetView()->data() == string->GetView()->data() + 500);
+    REQUIRE(slice->Substring(500, 506)->GetText() == "needle");
+
+    auto small = MakeString(std::string_view("short"));
+    REQUIRE(small->GetView()->data() >= reinterpret_cast<const char*>(small.get()));
+    REQUIRE(small->GetView()->data() < reinterpret_cast<const char*>(small.get() + 1));
+}
+
+TEST_CASE("RopesStayBalanced") {
+    // A line at a time, as a log would be built.
+    Ptr<String> rope = MakeString(std::string_view());
+    std::string expected;
+    for (int i = 0; i < 100000; ++i) {
+        std::string line = "line " + std::to_string(i) + "\n";
+        rope = String::Append(rope, MakeString(std::string_view(line)));
+        expected += line;
+    }
+    REQUIRE(rope->GetSize() == expected.size());
+    REQUIRE(rope->GetText() == expected);
+    for (size_t i = 0; i < expected.size(); i += 9973) {
+        REQUIRE(rope->At(i) == expected[i]);
+    }
+    REQUIRE(rope->Substring(1000, 500000)->GetText() == expected.substr(1000, 499000));
+
+    // Long strings added on both sides.
+    Ptr<String> both = MakeString(std::string_view());
+    std::string chunk(300, 'a');
+    for (int i = 0; i < 10000; ++i) {
+        chunk[0] = static_cast<char>('a' + i % 26);
+        both = i % 2 == 0 ? String::Append(both, MakeString(std::string_view(chunk)))
+                          : String::Append(MakeString(std::string_view(chunk)), both);
+    }
+    REQUIRE(both->GetSize() == 3000000);
+    REQUIRE(String::Compare(*both, *MakeString(both->GetText())) == 0);
+}
+
+TEST_CASE_METHOD(SchemeTest, "LongStringsAreBuiltInLinearTime") {
+    ExpectNoError(
+        "(define (build n acc) (if (= n 0) acc (build (- n 1) (string-append acc \"line\\n\"))))");
+    ExpectEq("(string-length (build 200000 \"\"))", "1000000");
+    ExpectNoError("(define (write-line port) (write-string \"line\\n\" port) port)");
+    ExpectNoError("(define (fill n port) (if (= n 0) port (fill (- n 1) (write-line port))))");
+    ExpectEq("(string-length (get-output-string (fill 200000 (open-output-string))))", "1000000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SizesPastTheFixnumRange") {
+    // Appending shares both halves, so the strings are long without taking memory.
+    ExpectNoError("(define (grow s n) (if (= n 0) s (grow (string-append s s) (- n 1))))");
+    ExpectEq("(string-length (grow \"ab\" 29))", "1073741824");
+    ExpectRuntimeError("(string-length (grow \"ab\" 30))");
+
+    REQUIRE(MakeSize(7, "length")->GetValue() == 7);
+    REQUIRE(MakeSize(2147483647, "length")->GetValue() == 2147483647);
+    REQUIRE_THROWS_AS(MakeSize(size_t{2147483648}, "length"), RuntimeError);
+}
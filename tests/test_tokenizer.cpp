@@ -4,6 +4,7 @@
 #include <scheme/tokenizer.h>
 
 #include <sstream>
+#include <vector>
 
 TEST_CASE("Tokenizer works on simple case") {
     std::stringstream ss{"4+)'."};
@@ -34,6 +35,31 @@ TEST_CASE("Tokenizer works on simple case") {
     REQUIRE(tokenizer.IsEnd());
 }
 
+TEST_CASE("String literals") {
+    std::stringstream ss{"\"a (b\"\"\\\"\\n\\\\\" \"end"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{StringToken{"a (b"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{StringToken{"\"\n\\"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{StringToken{"end", false}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
+
+TEST_CASE("Token positions") {
+    std::stringstream ss{"(f\n  \"a\nb\" -12)\n\n"};
+    Tokenizer tokenizer{&ss};
+
+    std::vector<Position> positions;
+    for (; !tokenizer.IsEnd(); tokenizer.Next()) {
+        positions.push_back(tokenizer.GetPosition());
+    }
+    REQUIRE(positions == std::vector<Position>{{1, 1}, {1, 2}, {2, 3}, {3, 4}, {3, 7}});
+    REQUIRE(tokenizer.GetPosition() == Position{5, 1});
+}
+
 TEST_CASE("Negative numbers") {
     std::stringstream ss{"-2 - 2"};
     Tokenizer tokenizer{&ss};
@@ -50,6 +76,23 @@ TEST_CASE("Negative numbers") {
     REQUIRE(tokenizer.GetToken() == Token{ConstantToken{2}});
 }
 
+TEST_CASE("Integers out of range") {
+    std::stringstream ss{"2147483647 -2147483648 +12 2147483648 -99999999999999 1"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{2147483647}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{-2147483647 - 1}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{12}});
+    tokenizer.Next();
+    REQUIRE(std::holds_alternative<InvalidToken>(tokenizer.GetToken()));
+    tokenizer.Next();
+    REQUIRE(std::holds_alternative<InvalidToken>(tokenizer.GetToken()));
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{1}});
+}
+
 TEST_CASE("Symbol names") {
     std::stringstream ss{"foo bar zog-zog? Am1good?"};
     Tokenizer tokenizer{&ss};